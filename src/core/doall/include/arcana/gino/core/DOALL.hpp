@@ -23,6 +23,7 @@
 #define NOELLE_SRC_TOOLS_DOALL_H_
 
 #include "arcana/noelle/core/IVStepperUtility.hpp"
+#include "arcana/noelle/core/LoopCarriedSCC.hpp"
 #include "arcana/noelle/core/Noelle.hpp"
 
 #include "arcana/gino/core/DOALLTask.hpp"
@@ -31,6 +32,83 @@
 
 namespace arcana::gino {
 
+/*
+ * Array whose elements are only updated by associative and commutative
+ * operations within a loop (e.g., histograms).
+ * Every task instance accumulates into its own dense copy of the array.
+ */
+struct ArrayReduction {
+  Value *object;
+  uint64_t size;
+  Type *elementType;
+  Instruction::BinaryOps combineOperator;
+  std::set<Instruction *> accesses;
+  Instruction *privateCopies;
+};
+
+/*
+ * Update of a memory location through an associative and commutative operator
+ * (e.g., hist[k]++) that is shared between iterations.
+ * The update is performed by a native atomic instruction when its type and
+ * operator allow it, and while holding a lock hashed by address otherwise.
+ */
+struct SharedUpdate {
+  LoadInst *load;
+  Instruction *update;
+  StoreInst *store;
+  AtomicRMWInst::BinOp atomicOperator;
+  bool needsLock;
+};
+
+/*
+ * Live-out variable that keeps the value assigned by the last iteration that
+ * assigned it.
+ * Every task instance records its last assignment together with the
+ * iteration that performed it.
+ */
+struct LastPrivateVariable {
+  uint32_t envID;
+  PHINode *headerPHI;
+  AllocaInst *values;
+  AllocaInst *iterations;
+};
+
+/*
+ * Live-out variable computed by a reduction whose updates are guarded by a
+ * condition.
+ * Conditional accumulations (e.g., sums of the elements that satisfy a
+ * predicate) are combined with the operator of their accumulation.
+ * Selections (e.g., argmin/argmax) keep the element that wins a comparison
+ * against the current one, together with the variables selected with it
+ * (e.g., its index).
+ * Every task instance records the iteration that selected its element to
+ * break ties like the sequential loop does.
+ */
+struct CompositeReduction {
+  PHINode *headerPHI;
+  Instruction::BinaryOps combineOperator;
+  CmpInst *compare;
+  bool selectsNewElementWhenTrue;
+  std::vector<PHINode *> selectedWithPHIs;
+  AllocaInst *values;
+  AllocaInst *iterations;
+  std::vector<AllocaInst *> selectedWithValues;
+};
+
+/*
+ * Floating-point sum computed in a way that does not depend on the number of
+ * task instances.
+ * Partial sums are computed over blocks of a fixed number of iterations and
+ * they are combined in a fixed tree order after the parallelized loop.
+ * The result is reproducible across numbers of cores, but it can differ from
+ * the one of the sequential loop, which adds the values in a different order.
+ */
+struct DeterministicReduction {
+  PHINode *headerPHI;
+  Value *partials;
+  Value *numberOfBlocks;
+};
+
 class DOALL : public ParallelizationTechnique {
 public:
   /*
@@ -46,24 +124,143 @@ public:
 
   std::string getName(void) const override;
 
+  void enableTwoLevelChunking(void);
+
+  void enableDeterministicReductions(void);
+
+  void enableAtomicUpdates(void);
+
   Transformation getParallelizationID(void) const override;
 
   static std::set<SCC *> getSCCsThatBlockDOALLToBeApplicable(LoopContent *LDI,
                                                              Noelle &par);
 
+  static std::string getInspectedIndicesMetadataName(void);
+
 protected:
   bool enabled;
   Function *taskDispatcher;
   Noelle &n;
   std::map<PHINode *, std::set<Instruction *>> IVValueJustBeforeEnteringBody;
+  bool useTwoLevelChunking;
+  bool useDeterministicReductions;
+  bool useAtomicUpdates;
+  Value *taskExecutedTheLastIteration;
+  Value *chunkCounter;
+  std::vector<ArrayReduction> arrayReductions;
+  std::vector<LastPrivateVariable> lastPrivateVariables;
+  std::vector<CompositeReduction> compositeReductions;
+  std::vector<DeterministicReduction> deterministicReductions;
+  std::vector<SharedUpdate> sharedUpdates;
 
   virtual void invokeParallelizedLoop(LoopContent *LDI);
 
+  virtual std::set<SCC *> getSCCsThatBlockParallelization(
+      LoopContent *LDI) const;
+
+  virtual bool canHandleLoopExits(LoopContent *LDI) const;
+
+  virtual void appendDispatcherArguments(LoopContent *LDI,
+                                         IRBuilder<> &builder,
+                                         std::vector<Value *> &arguments);
+
+  virtual void generateCodeToMergeTaskResults(LoopContent *LDI,
+                                              IRBuilder<> &builder);
+
   /*
    * DOALL specific generation
    */
   void rewireLoopToIterateChunks(LoopContent *LDI, DOALLTask *task);
 
+  bool canIterateTwoLevelChunks(LoopContent *LDI) const;
+
+  void rewireLoopToIterateTwoLevelChunks(LoopContent *LDI, DOALLTask *task);
+
+  void strengthReduceDivisionsOfTheLoopGoverningIV(LoopContent *LDI,
+                                                   DOALLTask *task);
+
+  uint64_t getChunkSizeAlignedToTheWrittenData(LoopContent *LDI) const;
+
+  void assumeAlignmentOfTheWrittenData(LoopContent *LDI, DOALLTask *task);
+
+  std::vector<ArrayReduction> getArrayReductions(LoopContent *LDI) const;
+
+  static bool isDueToArrayReductions(
+      LoopCarriedSCC *sccInfo,
+      const std::vector<ArrayReduction> &reductions);
+
+  void privatizeArrayReductions(LoopContent *LDI, DOALLTask *task);
+
+  void combineArrayReductions(LoopContent *LDI, IRBuilder<> &builder);
+
+  std::vector<SharedUpdate> getSharedUpdates(LoopContent *LDI) const;
+
+  static bool isDueToSharedUpdates(LoopCarriedSCC *sccInfo,
+                                   const std::vector<SharedUpdate> &updates);
+
+  bool isCheaperToUpdateAtomically(
+      LoopContent *LDI,
+      const ArrayReduction &reduction,
+      const std::vector<SharedUpdate> &updates) const;
+
+  void lowerSharedUpdates(LoopContent *LDI, DOALLTask *task);
+
+  std::set<PHINode *> getPHIsOfLastPrivateVariable(LoopContent *LDI,
+                                                   uint32_t liveOutID) const;
+
+  void generateCodeToTrackLastPrivateVariables(LoopContent *LDI,
+                                               DOALLTask *task);
+
+  void mergeLastPrivateVariables(LoopContent *LDI, IRBuilder<> &builder);
+
+  Value *fetchValueOfHeaderPHIWhenLeavingTask(PHINode *headerPHIClone,
+                                              BasicBlock *bb);
+
+  std::vector<CompositeReduction> getCompositeReductions(
+      LoopContent *LDI) const;
+
+  bool isProducedByCompositeReduction(LoopContent *LDI,
+                                      uint32_t liveOutID) const;
+
+  void generateCodeToTrackCompositeReductions(LoopContent *LDI,
+                                              DOALLTask *task);
+
+  void mergeCompositeReductions(LoopContent *LDI, IRBuilder<> &builder);
+
+  static bool isConditionalAccumulation(
+      LoopStructure *loopStructure,
+      SCC *scc,
+      PHINode *headerPHI,
+      bool requiresReassociation,
+      Instruction::BinaryOps &combineOperator);
+
+  std::set<PHINode *> getPHIsOfDeterministicReductions(
+      LoopContent *LDI) const;
+
+  bool isProducedByDeterministicReduction(LoopContent *LDI,
+                                          uint32_t liveOutID) const;
+
+  Value *generateCodeToComputeMaximumNumberOfIterations(
+      LoopContent *LDI,
+      IRBuilder<> &builder);
+
+  void generateCodeToComputeReductionsInBlocks(LoopContent *LDI,
+                                               DOALLTask *task);
+
+  void combineDeterministicReductions(LoopContent *LDI, IRBuilder<> &builder);
+
+  static uint64_t getIterationsPerDeterministicReductionBlock(void);
+
+  bool canComputeIterations(LoopContent *LDI) const;
+
+  Value *generateCodeToComputeIteration(LoopContent *LDI,
+                                        DOALLTask *task,
+                                        IRBuilder<> &builder);
+
+  void hoistExitConditionValueDerivation(LoopContent *LDI,
+                                         DOALLTask *task,
+                                         IRBuilder<> &entryBuilder);
+
   /*
    * Interface
    */
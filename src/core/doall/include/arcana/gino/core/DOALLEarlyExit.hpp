@@ -0,0 +1,78 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef NOELLE_SRC_TOOLS_DOALL_EARLY_EXIT_H_
+#define NOELLE_SRC_TOOLS_DOALL_EARLY_EXIT_H_
+
+#include "arcana/gino/core/DOALL.hpp"
+
+namespace arcana::gino {
+
+/*
+ * DOALL for search loops that can leave from several exit blocks.
+ * Tasks run their chunks speculatively.
+ * When a task leaves the loop from an early exit, it publishes the iteration
+ * and the exit block taken through an atomic minimum in the environment.
+ * Tasks check that location at the beginning of every chunk and stop once
+ * they are past the earliest iteration that left the loop.
+ * The join then restores the exit block and the live-out variables of that
+ * iteration.
+ */
+class DOALLEarlyExit : public DOALL {
+public:
+  /*
+   * Methods
+   */
+  DOALLEarlyExit(Noelle &noelle);
+
+  bool canBeAppliedToLoop(LoopContent *LDI, Heuristics *h) const override;
+
+  std::string getName(void) const override;
+
+protected:
+  AllocaInst *earliestExit;
+
+  bool canHandleLoopExits(LoopContent *LDI) const override;
+
+  void invokeParallelizedLoop(LoopContent *LDI) override;
+
+  void generateCodeToMergeTaskResults(LoopContent *LDI,
+                                      IRBuilder<> &builder) override;
+
+  void generateCodeToPublishEarlyExits(LoopContent *LDI,
+                                       DOALLTask *task,
+                                       Value *earliestExitInTask);
+
+  void generateCodeToStopAfterEarlyExits(LoopContent *LDI,
+                                         DOALLTask *task,
+                                         Value *earliestExitInTask);
+
+  BasicBlock *getBasicBlockExecutedOnlyByLastIterationBeforeExitingTask(
+      LoopContent *LDI,
+      uint32_t taskIndex,
+      BasicBlock &bb) override;
+
+  static constexpr uint64_t bitsForExitBlockIndex = 8;
+};
+
+} // namespace arcana::gino
+
+#endif // NOELLE_SRC_TOOLS_DOALL_EARLY_EXIT_H_
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef NOELLE_SRC_TOOLS_DOALL_PROCESSES_H_
+#define NOELLE_SRC_TOOLS_DOALL_PROCESSES_H_
+
+#include "arcana/gino/core/DOALL.hpp"
+
+namespace arcana::gino {
+
+/*
+ * DOALL where task instances run within forked processes rather than threads.
+ * This allows loops that invoke thread-unsafe library functions to be
+ * parallelized: the library state becomes private to each process.
+ * Memory locations written by the loop are sent back to the parent process at
+ * the join.
+ */
+class DOALLProcesses : public DOALL {
+public:
+  /*
+   * Methods
+   */
+  DOALLProcesses(Noelle &noelle);
+
+  bool apply(LoopContent *LDI, Heuristics *h) override;
+
+  bool canBeAppliedToLoop(LoopContent *LDI, Heuristics *h) const override;
+
+  std::string getName(void) const override;
+
+protected:
+  std::set<Value *> memoryObjectsToMerge;
+  std::set<AllocaInst *> stackLocationsOfTheOriginalFunction;
+
+  std::set<SCC *> getSCCsThatBlockParallelization(
+      LoopContent *LDI) const override;
+
+  void appendDispatcherArguments(LoopContent *LDI,
+                                 IRBuilder<> &builder,
+                                 std::vector<Value *> &arguments) override;
+
+  bool collectMemoryObjectsWrittenByTheLoop(LoopContent *LDI,
+                                            std::set<Value *> &objects) const;
+
+  static bool isCallToLibraryFunction(Value *v);
+
+  static bool isAllocationOfHeapObject(Value *v);
+
+  static bool isCallToFunctionWithPrivateState(Value *v);
+};
+
+} // namespace arcana::gino
+
+#endif // NOELLE_SRC_TOOLS_DOALL_PROCESSES_H_
@@ -27,7 +27,12 @@ DOALL::DOALL(Noelle &noelle)
   : ParallelizationTechnique{ noelle },
     enabled{ true },
     taskDispatcher{ nullptr },
-    n{ noelle } {
+    n{ noelle },
+    useTwoLevelChunking{ false },
+    useDeterministicReductions{ false },
+    useAtomicUpdates{ false },
+    taskExecutedTheLastIteration{ nullptr },
+    chunkCounter{ nullptr } {
 
   /*
    * Fetch the dispatcher to use to jump to a parallelized DOALL loop.
@@ -45,6 +50,24 @@ DOALL::DOALL(Noelle &noelle)
   return;
 }
 
+void DOALL::enableTwoLevelChunking(void) {
+  this->useTwoLevelChunking = true;
+
+  return;
+}
+
+void DOALL::enableDeterministicReductions(void) {
+  this->useDeterministicReductions = true;
+
+  return;
+}
+
+void DOALL::enableAtomicUpdates(void) {
+  this->useAtomicUpdates = true;
+
+  return;
+}
+
 uint32_t DOALL::getMinimumNumberOfIdleCores(void) const {
   return 2;
 }
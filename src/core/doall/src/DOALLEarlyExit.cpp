@@ -0,0 +1,538 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/DOALLEarlyExit.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/Loads.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/ADT/Triple.h"
+
+namespace arcana::gino {
+
+/*
+ * Check @inst can run in the iterations after the one that leaves @loop.
+ *
+ * The header compares the loop governing IV with its run-time bound before
+ * every iteration, so these iterations never go past the trip count of the
+ * loop.
+ */
+static bool canBeSpeculated(Instruction *inst,
+                            Loop *loop,
+                            ScalarEvolution &SE,
+                            DominatorTree &DT) {
+
+  /*
+   * Divisions and calls must not trap whatever their operands are.
+   */
+  if (isa<DbgInfoIntrinsic>(inst)) {
+    return true;
+  }
+  if (inst->isIntDivRem() || isa<CallBase>(inst)) {
+    return isSafeToSpeculativelyExecute(inst);
+  }
+
+  /*
+   * Loads of loop invariant pointers must access dereferenceable memory.
+   */
+  auto load = dyn_cast<LoadInst>(inst);
+  if (load == nullptr) {
+    return true;
+  }
+  auto &DL = load->getModule()->getDataLayout();
+  auto pointer = load->getPointerOperand();
+  if (loop->isLoopInvariant(pointer)) {
+    auto contextInst = loop->getHeader()->getFirstNonPHI();
+    return isDereferenceableAndAlignedPointer(pointer,
+                                              load->getType(),
+                                              load->getAlign(),
+                                              DL,
+                                              contextInst,
+                                              &DT);
+  }
+
+  /*
+   * Other loads must walk memory with a constant step from a loop invariant
+   * base.
+   * The iterations that run after leaving the loop access the elements the
+   * loop would access up to its run-time bound if it did not leave early.
+   */
+  auto accessSCEV = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(pointer));
+  if ((accessSCEV == nullptr) || (accessSCEV->getLoop() != loop)
+      || !accessSCEV->isAffine()) {
+    return false;
+  }
+  auto stepSCEV = dyn_cast<SCEVConstant>(accessSCEV->getStepRecurrence(SE));
+  if ((stepSCEV == nullptr) || stepSCEV->getAPInt().isZero()) {
+    return false;
+  }
+
+  return SE.isLoopInvariant(accessSCEV->getStart(), loop);
+}
+
+DOALLEarlyExit::DOALLEarlyExit(Noelle &noelle)
+  : DOALL{ noelle },
+    earliestExit{ nullptr } {
+
+  return;
+}
+
+std::string DOALLEarlyExit::getName(void) const {
+  return "DOALL (early exits)";
+}
+
+bool DOALLEarlyExit::canBeAppliedToLoop(LoopContent *LDI, Heuristics *h) const {
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL: Checking if the loop can leave early\n";
+  }
+
+  /*
+   * Fetch information about the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopEnv = LDI->getEnvironment();
+  auto allIVInfo = LDI->getInductionVariableManager();
+
+  /*
+   * Tasks execute iterations after the one that leaves the loop.
+   * These iterations must not have side effects.
+   */
+  for (auto inst : loopStructure->getInstructions()) {
+    if (inst->mayWriteToMemory()) {
+      if (this->verbose != Verbosity::Disabled) {
+        errs() << "DOALL:   The loop writes memory\n";
+      }
+      if (this->verbose >= Verbosity::Maximal) {
+        errs() << "DOALL:     " << *inst << "\n";
+      }
+      return false;
+    }
+  }
+
+  /*
+   * The iteration that leaves the loop is identified by the loop governing IV.
+   * This IV must be an integer with a constant step.
+   */
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  if (loopGoverningIVAttr == nullptr) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "DOALL:   The loop has no loop governing IV\n";
+    }
+    return false;
+  }
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto isIVSupported = [](InductionVariable *iv) -> bool {
+    auto ivType = iv->getLoopEntryPHI()->getType();
+    if (!ivType->isIntegerTy() || (ivType->getIntegerBitWidth() > 64)) {
+      return false;
+    }
+    auto stepValue =
+        dyn_cast_or_null<ConstantInt>(iv->getSingleComputedStepValue());
+    if ((stepValue == nullptr) || stepValue->isZero()) {
+      return false;
+    }
+
+    return true;
+  };
+  if (!isIVSupported(loopGoverningIV)) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "DOALL:   The loop governing IV does not have a constant step\n";
+    }
+    return false;
+  }
+
+  /*
+   * Live-out variables are recomputed at the join from the iteration that
+   * left the loop.
+   * So they can only be IVs that have a constant step.
+   */
+  auto ivs = allIVInfo->getInductionVariables(*loopStructure);
+  for (auto envID : loopEnv->getEnvIDsOfLiveOutVars()) {
+    auto producer = loopEnv->getProducer(envID);
+    auto isIV = false;
+    for (auto iv : ivs) {
+      if ((iv->getLoopEntryPHI() == producer) && isIVSupported(iv)) {
+        isIV = true;
+        break;
+      }
+    }
+    if (!isIV) {
+      if (this->verbose != Verbosity::Disabled) {
+        errs() << "DOALL:   The live-out " << *producer
+               << " cannot be recomputed from the iteration that left the loop\n";
+      }
+      return false;
+    }
+  }
+
+  /*
+   * The iterations after the one that leaves the loop must not trap either.
+   */
+  auto program = this->noelle.getProgram();
+  auto loopHeader = loopStructure->getHeader();
+  auto &loopFunction = *loopHeader->getParent();
+  DominatorTree DT(loopFunction);
+  LoopInfo LI(DT);
+  AssumptionCache AC(loopFunction);
+  TargetLibraryInfoImpl TLII(Triple(program->getTargetTriple()));
+  TargetLibraryInfo TLI(TLII);
+  ScalarEvolution SE(loopFunction, TLI, AC, DT, LI);
+  auto loop = LI.getLoopFor(loopHeader);
+  assert(loop != nullptr);
+  for (auto inst : loopStructure->getInstructions()) {
+    if (!canBeSpeculated(inst, loop, SE, DT)) {
+      if (this->verbose != Verbosity::Disabled) {
+        errs() << "DOALL:   The loop might trap after leaving early\n";
+      }
+      if (this->verbose >= Verbosity::Maximal) {
+        errs() << "DOALL:     " << *inst << "\n";
+      }
+      return false;
+    }
+  }
+
+  /*
+   * Check the conditions of DOALL.
+   */
+  return DOALL::canBeAppliedToLoop(LDI, h);
+}
+
+bool DOALLEarlyExit::canHandleLoopExits(LoopContent *LDI) const {
+
+  /*
+   * Fetch information about the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopHeader = loopStructure->getHeader();
+  auto exitBlocks = loopStructure->getLoopExitBasicBlocks();
+
+  /*
+   * Loops with a single exit are handled by DOALL.
+   */
+  if (exitBlocks.size() < 2) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "DOALL:   The loop has a single exit block\n";
+    }
+    return false;
+  }
+  if (exitBlocks.size() > (1u << DOALLEarlyExit::bitsForExitBlockIndex)) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "DOALL:   Too many loop exit blocks\n";
+    }
+    return false;
+  }
+
+  /*
+   * The header must leave the loop to the first exit block, which is the one
+   * taken after the last iteration.
+   * Every other exit must be taken from the body and it must go to a
+   * different exit block.
+   */
+  auto exitsFromTheHeader = 0;
+  for (auto exitEdge : loopStructure->getLoopExitEdges()) {
+    auto isFromTheHeader = (exitEdge.first == loopHeader);
+    auto isToTheFirstExit = (exitEdge.second == exitBlocks[0]);
+    if (isFromTheHeader != isToTheFirstExit) {
+      if (this->verbose != Verbosity::Disabled) {
+        errs()
+            << "DOALL:   The loop exits are not taken after evaluating the loop governing IV\n";
+      }
+      return false;
+    }
+    if (isFromTheHeader) {
+      exitsFromTheHeader++;
+    }
+  }
+  if (exitsFromTheHeader != 1) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "DOALL:   The header does not leave the loop\n";
+    }
+    return false;
+  }
+
+  return true;
+}
+
+void DOALLEarlyExit::invokeParallelizedLoop(LoopContent *LDI) {
+
+  /*
+   * Fetch the task.
+   */
+  auto task = (DOALLTask *)this->tasks[0];
+
+  /*
+   * Fetch the loop function.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopFunction = loopStructure->getFunction();
+  auto environment = LDI->getEnvironment();
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto int64 = tm->getIntegerType(64);
+
+  /*
+   * Allocate the location that keeps the earliest exit taken by the tasks.
+   * This location is reset every time the parallelized loop starts.
+   */
+  IRBuilder<> functionEntryBuilder(&*loopFunction->begin()->begin());
+  this->earliestExit =
+      functionEntryBuilder.CreateAlloca(int64,
+                                        nullptr,
+                                        "noelle.doall.earliest_exit");
+  IRBuilder<> builder(this->entryPointOfParallelizedLoop);
+  builder.CreateStore(cm->getIntegerConstant(INT64_MAX, 64),
+                      this->earliestExit);
+
+  /*
+   * The location is a new live-in of the loop.
+   */
+  auto envID = environment->addLiveInValue(this->earliestExit, {});
+  this->envBuilder->addVariableToEnvironment(envID,
+                                             this->earliestExit->getType());
+  auto envUser = this->envBuilder->getUser(0);
+  envUser->addLiveIn(envID);
+
+  /*
+   * Load the pointer to the location at the entry of the task.
+   */
+  IRBuilder<> taskEntryBuilder(task->getEntry()->getTerminator());
+  auto envVarPtr =
+      envUser->createEnvironmentVariablePointer(taskEntryBuilder,
+                                                envID,
+                                                this->earliestExit->getType());
+  auto earliestExitInTask = taskEntryBuilder.CreateLoad(
+      envVarPtr->getType()->getPointerElementType(),
+      envVarPtr,
+      "noelle.environment_variable.live_in");
+
+  /*
+   * Let tasks publish their early exits and stop when they are past the
+   * earliest one.
+   */
+  this->generateCodeToPublishEarlyExits(LDI, task, earliestExitInTask);
+  this->generateCodeToStopAfterEarlyExits(LDI, task, earliestExitInTask);
+  if (this->verbose >= Verbosity::Maximal) {
+    task->getTaskBody()->print(errs() << "DOALL:  Task with early exits:\n");
+    errs() << "\n";
+  }
+
+  /*
+   * Invoke the tasks.
+   */
+  DOALL::invokeParallelizedLoop(LDI);
+
+  return;
+}
+
+void DOALLEarlyExit::generateCodeToPublishEarlyExits(
+    LoopContent *LDI,
+    DOALLTask *task,
+    Value *earliestExitInTask) {
+
+  /*
+   * Every exit block but the first one is an early exit.
+   * The key published is the iteration that left the loop followed by the
+   * index of the exit block, so the lowest key is the exit of the sequential
+   * execution.
+   */
+  auto cm = this->n.getConstantsManager();
+  for (auto i = 1; i < task->getNumberOfLastBlocks(); i++) {
+    auto bb = task->getLastBlock(i);
+    IRBuilder<> builder(bb->getTerminator());
+    auto iteration = this->generateCodeToComputeIteration(LDI, task, builder);
+    auto key = builder.CreateOr(
+        builder.CreateShl(iteration, DOALLEarlyExit::bitsForExitBlockIndex),
+        cm->getIntegerConstant(i, 64),
+        "earlyExitKey");
+    builder.CreateAtomicRMW(AtomicRMWInst::Min,
+                            earliestExitInTask,
+                            key,
+                            MaybeAlign(8),
+                            AtomicOrdering::Monotonic);
+  }
+
+  return;
+}
+
+void DOALLEarlyExit::generateCodeToStopAfterEarlyExits(
+    LoopContent *LDI,
+    DOALLTask *task,
+    Value *earliestExitInTask) {
+  assert(this->chunkCounter != nullptr);
+
+  /*
+   * Fetch the header and the first basic block of the body.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopHeader = loopStructure->getHeader();
+  auto headerClone = task->getCloneOfOriginalBasicBlock(loopHeader);
+  BasicBlock *bodyClone = nullptr;
+  for (auto succBB : successors(loopHeader)) {
+    if (loopStructure->isIncluded(succBB)) {
+      bodyClone = task->getCloneOfOriginalBasicBlock(succBB);
+      break;
+    }
+  }
+  assert(bodyClone != nullptr);
+
+  /*
+   * Check the earliest exit at the beginning of every chunk.
+   */
+  auto taskFunction = task->getTaskBody();
+  auto &cxt = taskFunction->getContext();
+  auto checkBB = BasicBlock::Create(cxt, "check_early_exits", taskFunction);
+  auto pollBB = BasicBlock::Create(cxt, "poll_early_exits", taskFunction);
+  headerClone->getTerminator()->replaceSuccessorWith(bodyClone, checkBB);
+  bodyClone->replacePhiUsesWith(headerClone, checkBB);
+  IRBuilder<> checkBuilder(checkBB);
+  auto isNewChunk = checkBuilder.CreateICmpEQ(
+      this->chunkCounter,
+      ConstantInt::get(this->chunkCounter->getType(), 0),
+      "isNewChunk");
+  checkBuilder.CreateCondBr(isNewChunk, pollBB, bodyClone);
+
+  /*
+   * Leave the task if another task has left the loop at an earlier
+   * iteration.
+   */
+  auto tm = this->n.getTypesManager();
+  IRBuilder<> pollBuilder(pollBB);
+  auto iteration =
+      this->generateCodeToComputeIteration(LDI, task, pollBuilder);
+  auto firstKeyOfIteration =
+      pollBuilder.CreateShl(iteration, DOALLEarlyExit::bitsForExitBlockIndex);
+  auto earliestKey = pollBuilder.CreateAlignedLoad(tm->getIntegerType(64),
+                                                   earliestExitInTask,
+                                                   MaybeAlign(8),
+                                                   "earliestExitKey");
+  earliestKey->setAtomic(AtomicOrdering::Monotonic);
+  auto isPastEarliestExit =
+      pollBuilder.CreateICmpSGT(firstKeyOfIteration, earliestKey);
+  pollBuilder.CreateCondBr(isPastEarliestExit, task->getExit(), bodyClone);
+  for (auto &phi : bodyClone->phis()) {
+    phi.addIncoming(phi.getIncomingValueForBlock(checkBB), pollBB);
+  }
+
+  return;
+}
+
+void DOALLEarlyExit::generateCodeToMergeTaskResults(LoopContent *LDI,
+                                                    IRBuilder<> &builder) {
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto int64 = tm->getIntegerType(64);
+
+  /*
+   * Decode the earliest exit taken by the tasks.
+   */
+  auto earliestKey =
+      builder.CreateLoad(int64, this->earliestExit, "earliestExitKey");
+  auto hasExitedEarly =
+      builder.CreateICmpNE(earliestKey,
+                           cm->getIntegerConstant(INT64_MAX, 64),
+                           "hasExitedEarly");
+  auto winningIteration =
+      builder.CreateLShr(earliestKey, DOALLEarlyExit::bitsForExitBlockIndex);
+  auto exitBlockIndex = builder.CreateAnd(
+      earliestKey,
+      cm->getIntegerConstant(
+          (1u << DOALLEarlyExit::bitsForExitBlockIndex) - 1,
+          64));
+
+  /*
+   * Specify which exit block to take after the parallelized loop.
+   * The first exit block is taken if no task left the loop early.
+   */
+  auto environment = LDI->getEnvironment();
+  auto exitBlockID = environment->getExitBlockID();
+  if (exitBlockID != -1) {
+    auto int32 = tm->getIntegerType(32);
+    auto exitBlockVar = this->envBuilder->getEnvironmentVariable(exitBlockID);
+    auto exitBlock = builder.CreateSelect(
+        hasExitedEarly,
+        builder.CreateTrunc(exitBlockIndex, int32),
+        cm->getIntegerConstant(0, 32));
+    builder.CreateStore(exitBlock, exitBlockVar);
+  }
+
+  /*
+   * Recompute the live-out IVs for the iteration that left the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto allIVInfo = LDI->getInductionVariableManager();
+  for (auto envID : environment->getEnvIDsOfLiveOutVars()) {
+    auto producer = environment->getProducer(envID);
+    for (auto iv : allIVInfo->getInductionVariables(*loopStructure)) {
+      if (iv->getLoopEntryPHI() != producer) {
+        continue;
+      }
+      auto ivType = producer->getType();
+      auto stepOfIV = cast<ConstantInt>(iv->getSingleComputedStepValue());
+      auto valueAtWinningIteration = builder.CreateAdd(
+          iv->getStartValue(),
+          builder.CreateMul(stepOfIV,
+                            builder.CreateTrunc(winningIteration, ivType)));
+
+      auto envVar = this->envBuilder->getEnvironmentVariable(envID);
+      auto valueOfLastIteration = builder.CreateLoad(ivType, envVar);
+      builder.CreateStore(builder.CreateSelect(hasExitedEarly,
+                                               valueAtWinningIteration,
+                                               valueOfLastIteration),
+                          envVar);
+      break;
+    }
+  }
+
+  return;
+}
+
+BasicBlock *DOALLEarlyExit::
+    getBasicBlockExecutedOnlyByLastIterationBeforeExitingTask(
+        LoopContent *LDI,
+        uint32_t taskIndex,
+        BasicBlock &bb) {
+
+  /*
+   * Live-out variables stored when leaving the loop early are overwritten at
+   * the join by the ones of the earliest exit.
+   */
+  auto task = this->tasks[taskIndex];
+  if (&bb != task->getLastBlock(0)) {
+    return &bb;
+  }
+
+  return DOALL::getBasicBlockExecutedOnlyByLastIterationBeforeExitingTask(
+      LDI,
+      taskIndex,
+      bb);
+}
+
+} // namespace arcana::gino
@@ -0,0 +1,477 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "llvm/Analysis/ValueTracking.h"
+#include "arcana/noelle/core/LoopCarriedUnknownSCC.hpp"
+#include "arcana/gino/core/DOALLProcesses.hpp"
+
+namespace arcana::gino {
+
+DOALLProcesses::DOALLProcesses(Noelle &noelle) : DOALL{ noelle } {
+
+  /*
+   * Fetch the dispatcher that runs task instances within processes.
+   */
+  this->taskDispatcher =
+      this->n.getProgram()->getFunction("NOELLE_DOALLDispatcherProcesses");
+  this->enabled = (this->taskDispatcher != nullptr);
+  if (!this->enabled) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs()
+          << "DOALL: WARNING: function NOELLE_DOALLDispatcherProcesses couldn't be found. DOALL with processes is disabled\n";
+    }
+  }
+
+  return;
+}
+
+std::string DOALLProcesses::getName(void) const {
+  return "DOALL (processes)";
+}
+
+bool DOALLProcesses::canBeAppliedToLoop(LoopContent *LDI, Heuristics *h) const {
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL: Checking if the loop can run within processes\n";
+  }
+
+  /*
+   * Every memory location the loop writes must be sent back to the parent
+   * process.
+   * So we need to know all of them.
+   */
+  std::set<Value *> objects;
+  if (!this->collectMemoryObjectsWrittenByTheLoop(LDI, objects)) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs()
+          << "DOALL:   The loop writes memory locations that cannot be merged between processes\n";
+    }
+    return false;
+  }
+
+  /*
+   * Check the conditions of DOALL.
+   */
+  return DOALL::canBeAppliedToLoop(LDI, h);
+}
+
+bool DOALLProcesses::apply(LoopContent *LDI, Heuristics *h) {
+
+  /*
+   * Collect the memory objects written by the loop.
+   */
+  this->memoryObjectsToMerge.clear();
+  auto collected =
+      this->collectMemoryObjectsWrittenByTheLoop(LDI,
+                                                 this->memoryObjectsToMerge);
+  assert(collected);
+
+  /*
+   * Remember the stack locations of the function before the environment gets
+   * allocated.
+   * The new ones will be the environment variables, which include live-out
+   * and reduction variables.
+   */
+  auto loopFunction = LDI->getLoopStructure()->getFunction();
+  this->stackLocationsOfTheOriginalFunction.clear();
+  for (auto &inst : loopFunction->getEntryBlock()) {
+    if (auto allocaInst = dyn_cast<AllocaInst>(&inst)) {
+      this->stackLocationsOfTheOriginalFunction.insert(allocaInst);
+    }
+  }
+
+  /*
+   * Parallelize the loop.
+   */
+  return DOALL::apply(LDI, h);
+}
+
+std::set<SCC *> DOALLProcesses::getSCCsThatBlockParallelization(
+    LoopContent *LDI) const {
+  std::set<SCC *> sccs;
+
+  /*
+   * Fetch the SCCs that block DOALL with threads.
+   * Arrays updated by reductions are not privatized within processes because
+   * their private copies would not be merged back.
+   */
+  auto sccManager = LDI->getSCCManager();
+  for (auto scc : DOALL::getSCCsThatBlockDOALLToBeApplicable(LDI, this->n)) {
+
+    /*
+     * Check if all loop-carried data dependences of the SCC go through the
+     * internal state of library functions (e.g., the buffer of strerror).
+     * This state is private to each process, so these dependences can be
+     * ignored.
+     */
+    auto sccInfo = sccManager->getSCCAttrs(scc);
+    auto loopCarriedSCC = dyn_cast<LoopCarriedSCC>(sccInfo);
+    auto areAllDueToLibraries = (loopCarriedSCC != nullptr);
+    if (loopCarriedSCC != nullptr) {
+      for (auto dep : loopCarriedSCC->getLoopCarriedDependences()) {
+        if (isa<ControlDependence<Value, Value>>(dep)) {
+          continue;
+        }
+        if (!isa<MemoryDependence<Value, Value>>(dep)
+            || !DOALLProcesses::isCallToFunctionWithPrivateState(dep->getSrc())
+            || !DOALLProcesses::isCallToFunctionWithPrivateState(
+                dep->getDst())) {
+          areAllDueToLibraries = false;
+          break;
+        }
+      }
+    }
+    if (areAllDueToLibraries) {
+      continue;
+    }
+
+    /*
+     * We found an SCC that blocks DOALL with processes as well.
+     */
+    sccs.insert(scc);
+  }
+
+  return sccs;
+}
+
+bool DOALLProcesses::collectMemoryObjectsWrittenByTheLoop(
+    LoopContent *LDI,
+    std::set<Value *> &objects) const {
+
+  /*
+   * Fetch the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+
+  /*
+   * Define the function that records the memory object pointed by a pointer
+   * written by the loop.
+   * Globals and stack locations have a size known at compile time.
+   * Heap objects have their size given to their allocator.
+   */
+  auto addObject = [loopStructure, &objects](Value *ptr) -> bool {
+    auto object = getUnderlyingObject(ptr);
+    if (auto globalVar = dyn_cast<GlobalVariable>(object)) {
+      objects.insert(globalVar);
+      return true;
+    }
+    if (auto allocaInst = dyn_cast<AllocaInst>(object)) {
+      if (!allocaInst->isStaticAlloca()) {
+        return false;
+      }
+      if (loopStructure->isIncluded(allocaInst->getParent())) {
+
+        /*
+         * The stack location is allocated within the loop, so it is private
+         * to each iteration.
+         */
+        return true;
+      }
+      objects.insert(allocaInst);
+      return true;
+    }
+    if (DOALLProcesses::isAllocationOfHeapObject(object)) {
+      if (loopStructure->isIncluded(cast<Instruction>(object))) {
+
+        /*
+         * The heap object would only exist in the process that allocates it.
+         */
+        return false;
+      }
+      objects.insert(object);
+      return true;
+    }
+    return false;
+  };
+
+  /*
+   * Collect the memory objects.
+   */
+  for (auto bb : loopStructure->getBasicBlocks()) {
+    for (auto &inst : *bb) {
+      auto merged = true;
+      if (auto storeInst = dyn_cast<StoreInst>(&inst)) {
+        merged = addObject(storeInst->getPointerOperand());
+
+      } else if (auto rmwInst = dyn_cast<AtomicRMWInst>(&inst)) {
+        merged = addObject(rmwInst->getPointerOperand());
+
+      } else if (auto cmpXchgInst = dyn_cast<AtomicCmpXchgInst>(&inst)) {
+        merged = addObject(cmpXchgInst->getPointerOperand());
+
+      } else if (auto callInst = dyn_cast<CallBase>(&inst)) {
+
+        /*
+         * Calls that only read memory are fine.
+         */
+        if (callInst->onlyReadsMemory()) {
+          continue;
+        }
+
+        /*
+         * Only library functions are allowed to write memory.
+         * The memory written by them must be reachable from their arguments,
+         * unless it is their internal state, which is private to each process.
+         */
+        if (!DOALLProcesses::isCallToLibraryFunction(callInst)
+            || (!callInst->onlyAccessesArgMemory()
+                && !DOALLProcesses::isCallToFunctionWithPrivateState(
+                    callInst))) {
+          merged = false;
+        } else {
+          for (auto argID = 0u; argID < callInst->arg_size(); argID++) {
+            auto arg = callInst->getArgOperand(argID);
+            if (!arg->getType()->isPointerTy()) {
+              continue;
+            }
+            if (callInst->onlyReadsMemory(argID)) {
+              continue;
+            }
+            if (!addObject(arg)) {
+              merged = false;
+              break;
+            }
+          }
+        }
+      }
+
+      /*
+       * Check if the memory written by the current instruction can be merged.
+       */
+      if (!merged) {
+        if (this->verbose >= Verbosity::Maximal) {
+          errs() << "DOALL:     Unknown memory written by " << inst << "\n";
+        }
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void DOALLProcesses::appendDispatcherArguments(
+    LoopContent *LDI,
+    IRBuilder<> &builder,
+    std::vector<Value *> &arguments) {
+
+  /*
+   * Fetch the loop function.
+   */
+  auto loopFunction = LDI->getLoopStructure()->getFunction();
+  auto &DL = loopFunction->getParent()->getDataLayout();
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+
+  /*
+   * Collect the memory regions that the processes can modify.
+   *
+   * The first set of regions are the memory objects written by the loop.
+   * The size of a heap object is computed from the arguments of its allocator,
+   * which are available before the loop.
+   */
+  auto int64 = tm->getIntegerType(64);
+  std::vector<std::pair<Value *, Value *>> regions;
+  for (auto object : this->memoryObjectsToMerge) {
+    if (auto globalVar = dyn_cast<GlobalVariable>(object)) {
+      auto size = DL.getTypeAllocSize(globalVar->getValueType());
+      regions.push_back(
+          std::make_pair(globalVar, cm->getIntegerConstant(size, 64)));
+      continue;
+    }
+    if (auto allocaInst = dyn_cast<AllocaInst>(object)) {
+      auto sizeInBits = allocaInst->getAllocationSizeInBits(DL);
+      assert(sizeInBits.hasValue());
+      auto size = sizeInBits->getFixedSize() / 8;
+      regions.push_back(
+          std::make_pair(allocaInst, cm->getIntegerConstant(size, 64)));
+      continue;
+    }
+    auto allocation = cast<CallBase>(object);
+    auto size = builder.CreateZExtOrTrunc(allocation->getArgOperand(0), int64);
+    if (allocation->arg_size() == 2) {
+      size = builder.CreateMul(
+          size,
+          builder.CreateZExtOrTrunc(allocation->getArgOperand(1), int64));
+    }
+    regions.push_back(std::make_pair(allocation, size));
+  }
+
+  /*
+   * The second set of regions are the environment variables, which store the
+   * live-out and the reduction variables.
+   */
+  for (auto &inst : loopFunction->getEntryBlock()) {
+    auto allocaInst = dyn_cast<AllocaInst>(&inst);
+    if (allocaInst == nullptr) {
+      continue;
+    }
+    if (this->stackLocationsOfTheOriginalFunction.count(allocaInst) > 0) {
+      continue;
+    }
+    auto sizeInBits = allocaInst->getAllocationSizeInBits(DL);
+    if (!sizeInBits.hasValue()) {
+      continue;
+    }
+    auto size = sizeInBits->getFixedSize() / 8;
+    regions.push_back(
+        std::make_pair(allocaInst, cm->getIntegerConstant(size, 64)));
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Memory regions to merge between processes = "
+           << regions.size() << "\n";
+  }
+
+  /*
+   * Allocate the arrays that describe the memory regions.
+   */
+  IRBuilder<> entryBuilder(&*loopFunction->begin()->begin());
+  auto regionsArrayType =
+      ArrayType::get(tm->getVoidPointerType(), regions.size());
+  auto sizesArrayType = ArrayType::get(tm->getIntegerType(64), regions.size());
+  auto regionsArray =
+      entryBuilder.CreateAlloca(regionsArrayType,
+                                nullptr,
+                                "noelle.doall.processes.regions");
+  auto sizesArray = entryBuilder.CreateAlloca(sizesArrayType,
+                                              nullptr,
+                                              "noelle.doall.processes.sizes");
+
+  /*
+   * Describe the memory regions.
+   */
+  auto zero = cm->getIntegerConstant(0, 64);
+  for (auto i = 0u; i < regions.size(); i++) {
+    auto index = cm->getIntegerConstant(i, 64);
+    auto regionPtr = builder.CreateInBoundsGEP(regionsArrayType,
+                                               regionsArray,
+                                               { zero, index });
+    auto region =
+        builder.CreateBitCast(regions[i].first, tm->getVoidPointerType());
+    builder.CreateStore(region, regionPtr);
+    auto sizePtr =
+        builder.CreateInBoundsGEP(sizesArrayType, sizesArray, { zero, index });
+    builder.CreateStore(regions[i].second, sizePtr);
+  }
+
+  /*
+   * Append the arguments.
+   */
+  arguments.push_back(builder.CreateInBoundsGEP(regionsArrayType,
+                                                regionsArray,
+                                                { zero, zero }));
+  arguments.push_back(
+      builder.CreateInBoundsGEP(sizesArrayType, sizesArray, { zero, zero }));
+  arguments.push_back(cm->getIntegerConstant(regions.size(), 64));
+
+  return;
+}
+
+bool DOALLProcesses::isCallToLibraryFunction(Value *v) {
+  auto callInst = dyn_cast<CallBase>(v);
+  if (callInst == nullptr) {
+    return false;
+  }
+  auto callee = callInst->getCalledFunction();
+  if (callee == nullptr) {
+    return false;
+  }
+
+  return callee->isDeclaration();
+}
+
+bool DOALLProcesses::isAllocationOfHeapObject(Value *v) {
+  if (!DOALLProcesses::isCallToLibraryFunction(v)) {
+    return false;
+  }
+
+  /*
+   * Allocators whose arguments are the number of bytes they allocate, or the
+   * number of elements and the size of each element (e.g., calloc).
+   */
+  static const std::map<std::string, uint32_t> allocators = {
+    { "malloc", 1 },
+    { "calloc", 2 },
+    { "_Znwm", 1 },
+    { "_Znam", 1 }
+  };
+  auto callInst = cast<CallBase>(v);
+  auto callee = callInst->getCalledFunction();
+  auto allocator = allocators.find(callee->getName().str());
+  if (allocator == allocators.end()) {
+    return false;
+  }
+  if (callInst->arg_size() != allocator->second) {
+    return false;
+  }
+  for (auto &arg : callInst->args()) {
+    if (!arg->getType()->isIntegerTy()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool DOALLProcesses::isCallToFunctionWithPrivateState(Value *v) {
+  if (!DOALLProcesses::isCallToLibraryFunction(v)) {
+    return false;
+  }
+
+  /*
+   * Library functions whose only side effect outside their pointer arguments
+   * is a static buffer they return.
+   * Their results do not depend on their previous calls, so every process
+   * computes the same results the sequential loop does.
+   * Functions whose state flows from a call to the next one (e.g., rand and
+   * strtok) are not included: every process would start from the same state.
+   */
+  static const std::set<std::string> functionsWithPrivateState = {
+    "localtime", "gmtime", "ctime", "asctime", "strerror"
+  };
+  auto callInst = cast<CallBase>(v);
+  auto callee = callInst->getCalledFunction();
+  if (functionsWithPrivateState.count(callee->getName().str()) == 0) {
+    return false;
+  }
+
+  /*
+   * The function must not write memory through its arguments.
+   * Otherwise, its calls depend on each other through that memory as well
+   * (e.g., strtok on a shared buffer).
+   */
+  for (auto argID = 0u; argID < callInst->arg_size(); argID++) {
+    auto arg = callInst->getArgOperand(argID);
+    if (!arg->getType()->isPointerTy() || isa<ConstantPointerNull>(arg)) {
+      continue;
+    }
+    if (!callInst->onlyReadsMemory(argID)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace arcana::gino
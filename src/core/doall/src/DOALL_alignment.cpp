@@ -0,0 +1,313 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <numeric>
+
+#include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+
+namespace arcana::gino {
+
+/*
+ * Size (in bytes) of a cache line of the target.
+ */
+static const uint64_t cacheLineSize = 64;
+
+/*
+ * Describe the array that is written the most by the loop.
+ */
+struct WrittenArray {
+  Value *base = nullptr;
+  uint64_t elementSize = 0;
+  uint64_t strideBetweenIterations = 0;
+
+  /*
+   * Offset from the base where the first chunk of iterations starts writing
+   * (i.e., the end of the first element written for IVs that decrease).
+   */
+  bool isOffsetOfFirstChunkKnown = false;
+  int64_t offsetOfFirstChunk = 0;
+};
+
+/*
+ * Check the compiler can make @base aligned to a cache line, or that it is
+ * aligned already.
+ */
+static bool isCacheLineAligned(Value *base, const DataLayout &DL) {
+  if (auto globalArray = dyn_cast<GlobalVariable>(base)) {
+    if (!globalArray->isDeclaration() && globalArray->isDefinitionExact()) {
+      return true;
+    }
+  } else if (isa<AllocaInst>(base)) {
+    return true;
+  }
+
+  return base->getPointerAlignment(DL).value() >= cacheLineSize;
+}
+
+/*
+ * Return the size (in bytes) of the widest vector register that the code of
+ * @F can use.
+ */
+static uint64_t getVectorRegisterSize(Function *F) {
+  auto features = F->getFnAttribute("target-features").getValueAsString();
+  if (features.contains("+avx512f")) {
+    return 64;
+  }
+  if (features.contains("+avx")) {
+    return 32;
+  }
+
+  return 16;
+}
+
+/*
+ * Find the array that is written by most stores of the loop.
+ * Only stores to addresses computed by indexing a base pointer with an IV that
+ * has a constant step are considered.
+ */
+static WrittenArray fetchDominantWrittenArray(LoopContent *LDI) {
+
+  /*
+   * Fetch the loop information.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopFunction = loopStructure->getFunction();
+  auto &DL = loopFunction->getParent()->getDataLayout();
+  auto allIVInfo = LDI->getInductionVariableManager();
+
+  /*
+   * Collect the IVs of the loop with a constant step.
+   */
+  std::unordered_map<Value *, int64_t> stepOfIVs;
+  std::unordered_map<Value *, int64_t> startOfIVs;
+  for (auto ivInfo : allIVInfo->getInductionVariables(*loopStructure)) {
+    auto step = dyn_cast_or_null<ConstantInt>(
+        ivInfo->getSingleComputedStepValue());
+    if (step == nullptr) {
+      continue;
+    }
+    stepOfIVs[ivInfo->getLoopEntryPHI()] = step->getSExtValue();
+    auto start = dyn_cast<ConstantInt>(ivInfo->getStartValue());
+    if ((start != nullptr) && !start->isNegative()) {
+      startOfIVs[ivInfo->getLoopEntryPHI()] = start->getSExtValue();
+    }
+  }
+
+  /*
+   * Count the stores to each array indexed by an IV.
+   */
+  std::unordered_map<Value *, WrittenArray> arrays;
+  std::unordered_map<Value *, uint64_t> numberOfStores;
+  for (auto bb : loopStructure->getBasicBlocks()) {
+    for (auto &inst : *bb) {
+      auto storeInst = dyn_cast<StoreInst>(&inst);
+      if (storeInst == nullptr) {
+        continue;
+      }
+      auto gep = dyn_cast<GetElementPtrInst>(
+          storeInst->getPointerOperand()->stripPointerCasts());
+      if (gep == nullptr) {
+        continue;
+      }
+
+      /*
+       * Check that the last index is an IV.
+       */
+      auto lastIndex = (gep->idx_end() - 1)->get();
+      if (auto castInst = dyn_cast<CastInst>(lastIndex)) {
+        lastIndex = castInst->getOperand(0);
+      }
+      if (stepOfIVs.find(lastIndex) == stepOfIVs.end()) {
+        continue;
+      }
+      auto step = stepOfIVs.at(lastIndex);
+      if (step == 0) {
+        continue;
+      }
+
+      /*
+       * Compute the distance between the elements written by two consecutive
+       * iterations.
+       */
+      auto elementSize =
+          DL.getTypeAllocSize(gep->getResultElementType()).getFixedSize();
+      if (elementSize == 0) {
+        continue;
+      }
+      auto base = gep->getPointerOperand()->stripPointerCasts();
+      auto &array = arrays[base];
+      array.base = base;
+      array.elementSize = elementSize;
+      array.strideBetweenIterations = elementSize * std::abs(step);
+
+      /*
+       * Compute where the first chunk starts writing when the indices that
+       * precede the IV are zero and the IV starts from a constant.
+       */
+      auto isOffsetKnown = (startOfIVs.find(lastIndex) != startOfIVs.end());
+      for (auto index = gep->idx_begin(); index != (gep->idx_end() - 1);
+           index++) {
+        auto constantIndex = dyn_cast<ConstantInt>(index->get());
+        if ((constantIndex == nullptr) || !constantIndex->isZero()) {
+          isOffsetKnown = false;
+        }
+      }
+      int64_t offset = 0;
+      if (isOffsetKnown) {
+        offset = startOfIVs.at(lastIndex) * (int64_t)elementSize;
+        if (step < 0) {
+          offset += elementSize;
+        }
+      }
+      if (numberOfStores[base] == 0) {
+        array.isOffsetOfFirstChunkKnown = isOffsetKnown;
+        array.offsetOfFirstChunk = offset;
+      } else if (!isOffsetKnown || (array.offsetOfFirstChunk != offset)) {
+        array.isOffsetOfFirstChunkKnown = false;
+      }
+      numberOfStores[base]++;
+    }
+  }
+
+  /*
+   * Pick the array written by most stores.
+   */
+  WrittenArray dominantArray;
+  uint64_t maxNumberOfStores = 0;
+  for (auto &pair : arrays) {
+    auto stores = numberOfStores.at(pair.first);
+    if (stores > maxNumberOfStores) {
+      maxNumberOfStores = stores;
+      dominantArray = pair.second;
+    }
+  }
+
+  return dominantArray;
+}
+
+uint64_t DOALL::getChunkSizeAlignedToTheWrittenData(LoopContent *LDI) const {
+
+  /*
+   * Fetch the chunk size.
+   */
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto chunkSize = ltm->getChunkSize();
+
+  /*
+   * Fetch the array written the most by the loop.
+   */
+  auto array = fetchDominantWrittenArray(LDI);
+  if (array.base == nullptr) {
+    return chunkSize;
+  }
+
+  /*
+   * Compute the number of iterations that write a whole cache line.
+   * Chunks of these iterations start at the beginning of a cache line only
+   * if the first chunk does.
+   */
+  auto &DL =
+      LDI->getLoopStructure()->getFunction()->getParent()->getDataLayout();
+  auto doesFirstChunkStartACacheLine =
+      array.isOffsetOfFirstChunkKnown
+      && ((array.offsetOfFirstChunk % (int64_t)cacheLineSize) == 0)
+      && isCacheLineAligned(array.base, DL);
+  uint64_t iterationsPerCacheLine = 1;
+  if (doesFirstChunkStartACacheLine
+      && (array.strideBetweenIterations <= cacheLineSize)
+      && ((cacheLineSize % array.strideBetweenIterations) == 0)) {
+    iterationsPerCacheLine = cacheLineSize / array.strideBetweenIterations;
+  }
+
+  /*
+   * Compute the number of iterations that write a whole vector register.
+   */
+  uint64_t iterationsPerVector = 1;
+  auto vectorRegisterSize =
+      getVectorRegisterSize(LDI->getLoopStructure()->getFunction());
+  if ((array.strideBetweenIterations == array.elementSize)
+      && (array.elementSize <= vectorRegisterSize)
+      && ((vectorRegisterSize % array.elementSize) == 0)) {
+    iterationsPerVector = vectorRegisterSize / array.elementSize;
+  }
+
+  /*
+   * Round the chunk size up to a multiple of both.
+   */
+  auto granularity = std::lcm(iterationsPerCacheLine, iterationsPerVector);
+  auto alignedChunkSize =
+      ((chunkSize + granularity - 1) / granularity) * granularity;
+
+  return alignedChunkSize;
+}
+
+void DOALL::assumeAlignmentOfTheWrittenData(LoopContent *LDI,
+                                            DOALLTask *task) {
+
+  /*
+   * Fetch the array written the most by the loop.
+   */
+  auto array = fetchDominantWrittenArray(LDI);
+  if (array.base == nullptr) {
+    return;
+  }
+  auto loopFunction = LDI->getLoopStructure()->getFunction();
+  auto &DL = loopFunction->getParent()->getDataLayout();
+
+  /*
+   * Align the array to a cache line if we own its definition.
+   */
+  auto cacheLineAlignment = Align(cacheLineSize);
+  if (auto globalArray = dyn_cast<GlobalVariable>(array.base)) {
+    if (!globalArray->isDeclaration() && globalArray->isDefinitionExact()
+        && (globalArray->getAlign().valueOrOne() < cacheLineAlignment)) {
+      globalArray->setAlignment(cacheLineAlignment);
+    }
+  } else if (auto allocaArray = dyn_cast<AllocaInst>(array.base)) {
+    if (allocaArray->getAlign() < cacheLineAlignment) {
+      allocaArray->setAlignment(cacheLineAlignment);
+    }
+  }
+
+  /*
+   * The alignment of an array received through the environment is lost within
+   * the task. Restore it.
+   */
+  if (!task->isAnOriginalLiveIn(array.base)) {
+    return;
+  }
+  auto alignment = array.base->getPointerAlignment(DL);
+  if (alignment.value() < array.elementSize) {
+    return;
+  }
+  auto arrayClone = task->getCloneOfOriginalLiveIn(array.base);
+  IRBuilder<> entryBuilder(task->getEntry()->getTerminator());
+  entryBuilder.CreateAlignmentAssumption(DL, arrayClone, alignment.value());
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Assume " << *array.base << " to be aligned to "
+           << alignment.value() << " bytes\n";
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -25,6 +25,26 @@
 
 namespace arcana::gino {
 
+std::string DOALL::getInspectedIndicesMetadataName(void) {
+  return "gino.inspected.indices";
+}
+
+/*
+ * Check whether two memory accesses go through indices that have been
+ * inspected to be distinct at run time (i.e., they have the same tag).
+ */
+static bool areThroughInspectedIndices(Instruction *fromInst,
+                                       Instruction *toInst) {
+  if ((fromInst == nullptr) || (toInst == nullptr)) {
+    return false;
+  }
+  auto name = DOALL::getInspectedIndicesMetadataName();
+  auto fromTag = fromInst->getMetadata(name);
+  auto toTag = toInst->getMetadata(name);
+
+  return (fromTag != nullptr) && (fromTag == toTag);
+}
+
 std::set<SCC *> DOALL::getSCCsThatBlockDOALLToBeApplicable(LoopContent *LDI,
                                                            Noelle &par) {
   std::set<SCC *> sccs;
@@ -67,6 +87,9 @@ std::set<SCC *> DOALL::getSCCsThatBlockDOALLToBeApplicable(LoopContent *LDI,
 
       auto fromInst = dyn_cast<Instruction>(dep->getSrc());
       auto toInst = dyn_cast<Instruction>(dep->getDst());
+      if (areThroughInspectedIndices(fromInst, toInst)) {
+        continue;
+      }
       areAllDataLCDsFromDisjointMemoryAccesses &=
           fromInst && toInst
           && domainSpaceAnalysis
@@ -91,4 +114,71 @@ std::set<SCC *> DOALL::getSCCsThatBlockDOALLToBeApplicable(LoopContent *LDI,
   return sccs;
 }
 
+std::set<SCC *> DOALL::getSCCsThatBlockParallelization(
+    LoopContent *LDI) const {
+  std::set<SCC *> sccs;
+
+  /*
+   * SCCs of last-private variables do not block DOALL because the value
+   * assigned by the latest iteration is selected after the parallelized loop.
+   */
+  auto sccManager = LDI->getSCCManager();
+  auto sccdag = sccManager->getSCCDAG();
+  auto loopEnv = LDI->getEnvironment();
+  std::set<SCC *> mergedSCCs;
+  for (auto envID : loopEnv->getEnvIDsOfLiveOutVars()) {
+    if (this->getPHIsOfLastPrivateVariable(LDI, envID).size() > 0) {
+      mergedSCCs.insert(sccdag->sccOfValue(loopEnv->getProducer(envID)));
+    }
+  }
+
+  /*
+   * SCCs of composite reductions do not block DOALL because the partial
+   * results of the task instances are merged after the parallelized loop.
+   */
+  for (auto &reduction : this->getCompositeReductions(LDI)) {
+    mergedSCCs.insert(sccdag->sccOfValue(reduction.headerPHI));
+    for (auto phi : reduction.selectedWithPHIs) {
+      mergedSCCs.insert(sccdag->sccOfValue(phi));
+    }
+  }
+
+  /*
+   * SCCs of floating-point sums computed in blocks do not block DOALL because
+   * every block is computed by a single task instance.
+   */
+  for (auto phi : this->getPHIsOfDeterministicReductions(LDI)) {
+    mergedSCCs.insert(sccdag->sccOfValue(phi));
+  }
+
+  /*
+   * SCCs due to arrays updated by reductions do not block DOALL because every
+   * task instance updates its own copy of the arrays.
+   */
+  auto reductions = this->getArrayReductions(LDI);
+
+  /*
+   * SCCs due to updates of shared memory locations do not block DOALL
+   * because these updates are performed atomically.
+   */
+  auto sharedUpdates = this->getSharedUpdates(LDI);
+  for (auto scc : DOALL::getSCCsThatBlockDOALLToBeApplicable(LDI, this->n)) {
+    if (mergedSCCs.count(scc) > 0) {
+      continue;
+    }
+    auto sccInfo = dyn_cast<LoopCarriedSCC>(sccManager->getSCCAttrs(scc));
+    if ((sccInfo != nullptr)
+        && DOALL::isDueToArrayReductions(sccInfo, reductions)) {
+      continue;
+    }
+    if ((sccInfo != nullptr)
+        && DOALL::isDueToSharedUpdates(sccInfo, sharedUpdates)) {
+      continue;
+    }
+    sccs.insert(scc);
+  }
+
+  return sccs;
+}
+
 } // namespace arcana::gino
@@ -36,37 +36,9 @@ bool DOALL::canBeAppliedToLoop(LoopContent *LDI, Heuristics *h) const {
   auto loopEnv = LDI->getEnvironment();
 
   /*
-   * The loop must have one single exit path.
+   * The loop exits must be handled by the technique.
    */
-  auto numOfExits = 0;
-  for (auto bb : loopStructure->getLoopExitBasicBlocks()) {
-
-    /*
-     * Fetch the last instruction before the terminator
-     */
-    auto terminator = bb->getTerminator();
-    auto prevInst = terminator->getPrevNode();
-
-    /*
-     * Check if the last instruction is a call to a function that cannot return
-     * (e.g., abort()).
-     */
-    if (prevInst == nullptr) {
-      numOfExits++;
-      continue;
-    }
-    if (auto callInst = dyn_cast<CallInst>(prevInst)) {
-      auto callee = callInst->getCalledFunction();
-      if ((callee != nullptr) && (callee->getName() == "exit")) {
-        continue;
-      }
-    }
-    numOfExits++;
-  }
-  if (numOfExits != 1) {
-    if (this->verbose != Verbosity::Disabled) {
-      errs() << "DOALL:   More than 1 loop exit blocks\n";
-    }
+  if (!this->canHandleLoopExits(LDI)) {
     return false;
   }
 
@@ -94,6 +66,15 @@ bool DOALL::canBeAppliedToLoop(LoopContent *LDI, Heuristics *h) const {
     if (isa<InductionVariableSCC>(sccInfo)) {
       continue;
     }
+    if (this->getPHIsOfLastPrivateVariable(LDI, liveOutVar).size() > 0) {
+      continue;
+    }
+    if (this->isProducedByCompositeReduction(LDI, liveOutVar)) {
+      continue;
+    }
+    if (this->isProducedByDeterministicReduction(LDI, liveOutVar)) {
+      continue;
+    }
 
     /*
      * The SCC cannot be handled by DOALL.
@@ -115,7 +96,7 @@ bool DOALL::canBeAppliedToLoop(LoopContent *LDI, Heuristics *h) const {
    * The compiler must be able to remove loop-carried data dependences of all
    * SCCs with loop-carried data dependences.
    */
-  auto nonDOALLSCCs = DOALL::getSCCsThatBlockDOALLToBeApplicable(LDI, this->n);
+  auto nonDOALLSCCs = this->getSCCsThatBlockParallelization(LDI);
   if (nonDOALLSCCs.size() > 0) {
     if (this->verbose != Verbosity::Disabled) {
       for (auto scc : nonDOALLSCCs) {
@@ -215,4 +196,49 @@ bool DOALL::canBeAppliedToLoop(LoopContent *LDI, Heuristics *h) const {
   return true;
 }
 
+bool DOALL::canHandleLoopExits(LoopContent *LDI) const {
+
+  /*
+   * Fetch information about the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+
+  /*
+   * The loop must have one single exit path.
+   */
+  auto numOfExits = 0;
+  for (auto bb : loopStructure->getLoopExitBasicBlocks()) {
+
+    /*
+     * Fetch the last instruction before the terminator
+     */
+    auto terminator = bb->getTerminator();
+    auto prevInst = terminator->getPrevNode();
+
+    /*
+     * Check if the last instruction is a call to a function that cannot return
+     * (e.g., abort()).
+     */
+    if (prevInst == nullptr) {
+      numOfExits++;
+      continue;
+    }
+    if (auto callInst = dyn_cast<CallInst>(prevInst)) {
+      auto callee = callInst->getCalledFunction();
+      if ((callee != nullptr) && (callee->getName() == "exit")) {
+        continue;
+      }
+    }
+    numOfExits++;
+  }
+  if (numOfExits != 1) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "DOALL:   More than 1 loop exit blocks\n";
+    }
+    return false;
+  }
+
+  return true;
+}
+
 } // namespace arcana::gino
@@ -0,0 +1,620 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "llvm/Analysis/ValueTracking.h"
+#include "arcana/noelle/core/LoopCarriedSCC.hpp"
+#include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+
+namespace arcana::gino {
+
+/*
+ * Maximum number of bytes of all dense private copies of an array.
+ * Larger arrays are not privatized.
+ */
+static const uint64_t maximumSizeOfPrivateCopies = 64 * 1024 * 1024;
+
+/*
+ * Return the operator to combine the private copies of an array updated by
+ * the binary operator given as input, which uses @load to read the element
+ * being updated.
+ * The identity of all combine operators is zero, so private copies can be
+ * zero-initialized.
+ */
+static bool getCombineOperator(BinaryOperator *update,
+                               LoadInst *load,
+                               Instruction::BinaryOps &combineOperator) {
+  auto isLoadFirst = (update->getOperand(0) == load);
+  auto isLoadSecond = (update->getOperand(1) == load);
+  if (isLoadFirst == isLoadSecond) {
+    return false;
+  }
+
+  switch (update->getOpcode()) {
+    case Instruction::Add:
+    case Instruction::Or:
+    case Instruction::Xor:
+      combineOperator = update->getOpcode();
+      return true;
+    case Instruction::Sub:
+      combineOperator = Instruction::Add;
+      return isLoadFirst;
+    case Instruction::FAdd:
+      combineOperator = Instruction::FAdd;
+      return update->hasAllowReassoc();
+    case Instruction::FSub:
+      combineOperator = Instruction::FAdd;
+      return isLoadFirst && update->hasAllowReassoc();
+    default:
+      return false;
+  }
+}
+
+/*
+ * Return the number of bytes of the memory object given as input if the
+ * object can be privatized.
+ */
+static uint64_t getSizeOfPrivatizableObject(LoopStructure *loopStructure,
+                                            Value *object) {
+  auto &DL = loopStructure->getFunction()->getParent()->getDataLayout();
+  if (auto globalVar = dyn_cast<GlobalVariable>(object)) {
+    if (globalVar->isDeclaration()
+        || !globalVar->getValueType()->isSized()) {
+      return 0;
+    }
+    return DL.getTypeAllocSize(globalVar->getValueType());
+  }
+  if (auto allocaInst = dyn_cast<AllocaInst>(object)) {
+    if (!allocaInst->isStaticAlloca()
+        || loopStructure->isIncluded(allocaInst->getParent())) {
+      return 0;
+    }
+    auto sizeInBits = allocaInst->getAllocationSizeInBits(DL);
+    if (!sizeInBits.hasValue()) {
+      return 0;
+    }
+    return sizeInBits->getFixedSize() / 8;
+  }
+
+  return 0;
+}
+
+/*
+ * Create the function that combines the private copies of an array into the
+ * original one.
+ * Every task instance combines a contiguous partition of the elements.
+ * The environment of the function stores the pointer to the original array
+ * followed by the pointer to the private copies.
+ */
+static Function *createCombineFunction(Module &M,
+                                       FunctionType *signature,
+                                       ArrayReduction &reduction,
+                                       uint64_t numberOfCopies) {
+
+  /*
+   * Create the function.
+   */
+  auto combineFunction =
+      Function::Create(signature,
+                       GlobalValue::InternalLinkage,
+                       "noelle_doall_array_reduction_combine",
+                       M);
+  auto argIter = combineFunction->arg_begin();
+  auto envArg = &*(argIter++);
+  auto instanceID = &*(argIter++);
+  auto numInstances = &*(argIter++);
+
+  /*
+   * Create the basic blocks.
+   */
+  auto &cxt = M.getContext();
+  auto entryBB = BasicBlock::Create(cxt, "entry", combineFunction);
+  auto elementsHeaderBB =
+      BasicBlock::Create(cxt, "elements_header", combineFunction);
+  auto elementsBodyBB =
+      BasicBlock::Create(cxt, "elements_body", combineFunction);
+  auto copiesHeaderBB =
+      BasicBlock::Create(cxt, "copies_header", combineFunction);
+  auto copiesBodyBB = BasicBlock::Create(cxt, "copies_body", combineFunction);
+  auto elementsLatchBB =
+      BasicBlock::Create(cxt, "elements_latch", combineFunction);
+  auto exitBB = BasicBlock::Create(cxt, "exit", combineFunction);
+
+  /*
+   * Fetch the arrays.
+   */
+  auto &DL = M.getDataLayout();
+  auto int64 = IntegerType::get(cxt, 64);
+  auto voidPtrType = PointerType::getUnqual(IntegerType::get(cxt, 8));
+  auto elementType = reduction.elementType;
+  auto elementPtrType = PointerType::getUnqual(elementType);
+  IRBuilder<> entryBuilder(entryBB);
+  auto envPtr =
+      entryBuilder.CreateBitCast(envArg, PointerType::getUnqual(voidPtrType));
+  auto original = entryBuilder.CreateBitCast(
+      entryBuilder.CreateLoad(voidPtrType, envPtr),
+      elementPtrType,
+      "original");
+  auto copies = entryBuilder.CreateBitCast(
+      entryBuilder.CreateLoad(
+          voidPtrType,
+          entryBuilder.CreateConstInBoundsGEP1_64(voidPtrType, envPtr, 1)),
+      elementPtrType,
+      "copies");
+
+  /*
+   * Compute the partition of the elements of the current task instance.
+   */
+  auto numberOfElements = ConstantInt::get(
+      int64,
+      reduction.size / DL.getTypeAllocSize(elementType));
+  auto one = ConstantInt::get(int64, 1);
+  auto clampToTheElements = [&entryBuilder, numberOfElements](Value *v) {
+    auto isWithin = entryBuilder.CreateICmpULT(v, numberOfElements);
+    return entryBuilder.CreateSelect(isWithin, v, numberOfElements);
+  };
+  auto elementsPerInstance = entryBuilder.CreateUDiv(
+      entryBuilder.CreateAdd(numberOfElements,
+                             entryBuilder.CreateSub(numInstances, one)),
+      numInstances);
+  auto firstElement = clampToTheElements(
+      entryBuilder.CreateMul(instanceID, elementsPerInstance));
+  auto lastElement = clampToTheElements(
+      entryBuilder.CreateAdd(firstElement, elementsPerInstance));
+  entryBuilder.CreateBr(elementsHeaderBB);
+
+  /*
+   * Iterate over the elements of the partition.
+   */
+  IRBuilder<> elementsHeaderBuilder(elementsHeaderBB);
+  auto element = elementsHeaderBuilder.CreatePHI(int64, 2, "element");
+  auto isElementWithin =
+      elementsHeaderBuilder.CreateICmpULT(element, lastElement);
+  elementsHeaderBuilder.CreateCondBr(isElementWithin, elementsBodyBB, exitBB);
+
+  IRBuilder<> elementsBodyBuilder(elementsBodyBB);
+  auto originalElementPtr =
+      elementsBodyBuilder.CreateInBoundsGEP(elementType, original, element);
+  auto originalValue =
+      elementsBodyBuilder.CreateLoad(elementType, originalElementPtr);
+  elementsBodyBuilder.CreateBr(copiesHeaderBB);
+
+  /*
+   * Accumulate the element of every private copy.
+   */
+  IRBuilder<> copiesHeaderBuilder(copiesHeaderBB);
+  auto copy = copiesHeaderBuilder.CreatePHI(int64, 2, "copy");
+  auto accumulator =
+      copiesHeaderBuilder.CreatePHI(elementType, 2, "accumulator");
+  auto isCopyWithin = copiesHeaderBuilder.CreateICmpULT(
+      copy,
+      ConstantInt::get(int64, numberOfCopies));
+  copiesHeaderBuilder.CreateCondBr(isCopyWithin,
+                                   copiesBodyBB,
+                                   elementsLatchBB);
+
+  IRBuilder<> copiesBodyBuilder(copiesBodyBB);
+  auto copyElementIndex = copiesBodyBuilder.CreateAdd(
+      copiesBodyBuilder.CreateMul(copy, numberOfElements),
+      element);
+  auto copyValue = copiesBodyBuilder.CreateLoad(
+      elementType,
+      copiesBodyBuilder.CreateInBoundsGEP(elementType,
+                                          copies,
+                                          copyElementIndex));
+  auto newAccumulator = copiesBodyBuilder.CreateBinOp(reduction.combineOperator,
+                                                      accumulator,
+                                                      copyValue);
+  auto nextCopy = copiesBodyBuilder.CreateAdd(copy, one);
+  copiesBodyBuilder.CreateBr(copiesHeaderBB);
+
+  IRBuilder<> elementsLatchBuilder(elementsLatchBB);
+  elementsLatchBuilder.CreateStore(accumulator, originalElementPtr);
+  auto nextElement = elementsLatchBuilder.CreateAdd(element, one);
+  elementsLatchBuilder.CreateBr(elementsHeaderBB);
+
+  IRBuilder<> exitBuilder(exitBB);
+  exitBuilder.CreateRetVoid();
+
+  /*
+   * Close the loops.
+   */
+  element->addIncoming(firstElement, entryBB);
+  element->addIncoming(nextElement, elementsLatchBB);
+  copy->addIncoming(ConstantInt::get(int64, 0), elementsBodyBB);
+  copy->addIncoming(nextCopy, copiesBodyBB);
+  accumulator->addIncoming(originalValue, elementsBodyBB);
+  accumulator->addIncoming(newAccumulator, copiesBodyBB);
+
+  return combineFunction;
+}
+
+std::vector<ArrayReduction> DOALL::getArrayReductions(LoopContent *LDI) const {
+  std::vector<ArrayReduction> reductions;
+
+  /*
+   * Fetch the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto maxCores = ltm->getMaximumNumberOfCores();
+
+  /*
+   * Calls could access the arrays without going through their updates.
+   */
+  for (auto inst : loopStructure->getInstructions()) {
+    if (isa<CallBase>(inst) && inst->mayReadOrWriteMemory()) {
+      return reductions;
+    }
+  }
+
+  /*
+   * Fetch the live-in values of the loop.
+   * Arrays on the stack are accessed by tasks through the live-in that points
+   * to them, so they must be live-in values themselves.
+   */
+  auto loopEnv = LDI->getEnvironment();
+  std::set<Value *> liveIns;
+  for (auto envID : loopEnv->getEnvIDsOfLiveInVars()) {
+    liveIns.insert(loopEnv->getProducer(envID));
+  }
+
+  /*
+   * Collect the updates of array elements.
+   * An update loads an element, combines it with a value through an
+   * associative and commutative operator, and stores the result back to the
+   * same element.
+   */
+  std::map<Value *, ArrayReduction> candidates;
+  std::set<Value *> rejected;
+  for (auto inst : loopStructure->getInstructions()) {
+    auto storeInst = dyn_cast<StoreInst>(inst);
+    if ((storeInst == nullptr) || !storeInst->isSimple()) {
+      continue;
+    }
+    auto update = dyn_cast<BinaryOperator>(storeInst->getValueOperand());
+    if ((update == nullptr) || !update->hasOneUse()) {
+      continue;
+    }
+    LoadInst *loadInst = nullptr;
+    for (auto &op : update->operands()) {
+      auto opLoad = dyn_cast<LoadInst>(op.get());
+      if ((opLoad != nullptr)
+          && (opLoad->getPointerOperand() == storeInst->getPointerOperand())) {
+        loadInst = opLoad;
+        break;
+      }
+    }
+    if ((loadInst == nullptr) || !loadInst->isSimple()
+        || !loadInst->hasOneUse()
+        || (loadInst->getParent() != storeInst->getParent())) {
+      continue;
+    }
+    Instruction::BinaryOps combineOperator;
+    if (!getCombineOperator(update, loadInst, combineOperator)) {
+      continue;
+    }
+
+    /*
+     * Fetch the array updated.
+     */
+    auto object = getUnderlyingObject(storeInst->getPointerOperand());
+    auto size = getSizeOfPrivatizableObject(loopStructure, object);
+    auto elementType = loadInst->getType();
+    auto &DL = loopStructure->getFunction()->getParent()->getDataLayout();
+    if ((size == 0)
+        || (isa<AllocaInst>(object) && (liveIns.count(object) == 0))
+        || (!elementType->isIntegerTy() && !elementType->isFloatingPointTy())
+        || ((size % DL.getTypeAllocSize(elementType)) != 0)
+        || ((size * maxCores) > maximumSizeOfPrivateCopies)) {
+      rejected.insert(object);
+      continue;
+    }
+
+    /*
+     * All updates of an array must agree on how to combine its elements.
+     */
+    if (candidates.count(object) == 0) {
+      ArrayReduction reduction;
+      reduction.object = object;
+      reduction.size = size;
+      reduction.elementType = elementType;
+      reduction.combineOperator = combineOperator;
+      reduction.privateCopies = nullptr;
+      candidates[object] = reduction;
+    }
+    auto &reduction = candidates[object];
+    if ((reduction.elementType != elementType)
+        || (reduction.combineOperator != combineOperator)) {
+      rejected.insert(object);
+      continue;
+    }
+    reduction.accesses.insert(loadInst);
+    reduction.accesses.insert(storeInst);
+  }
+
+  /*
+   * The elements of the arrays must not be accessed other than by their
+   * updates.
+   */
+  for (auto inst : loopStructure->getInstructions()) {
+    auto ptr = getLoadStorePointerOperand(inst);
+    if (ptr == nullptr) {
+      if (auto rmwInst = dyn_cast<AtomicRMWInst>(inst)) {
+        ptr = rmwInst->getPointerOperand();
+      } else if (auto cmpXchgInst = dyn_cast<AtomicCmpXchgInst>(inst)) {
+        ptr = cmpXchgInst->getPointerOperand();
+      } else {
+        continue;
+      }
+    }
+    auto object = getUnderlyingObject(ptr);
+    if (candidates.count(object) == 0) {
+      continue;
+    }
+    if (candidates[object].accesses.count(inst) == 0) {
+      rejected.insert(object);
+    }
+  }
+
+  /*
+   * Keep the arrays that block DOALL.
+   * The other ones are updated at disjoint elements between iterations, so
+   * they do not need to be privatized.
+   * Arrays that are cheaper to update atomically are not privatized either.
+   */
+  auto sharedUpdates = this->getSharedUpdates(LDI);
+  auto sccManager = LDI->getSCCManager();
+  auto blockingSCCs = DOALL::getSCCsThatBlockDOALLToBeApplicable(LDI, this->n);
+  for (auto &pair : candidates) {
+    if (rejected.count(pair.first) > 0) {
+      continue;
+    }
+    auto &reduction = pair.second;
+    if (this->isCheaperToUpdateAtomically(LDI, reduction, sharedUpdates)) {
+      continue;
+    }
+    for (auto scc : blockingSCCs) {
+      auto sccInfo = dyn_cast<LoopCarriedSCC>(sccManager->getSCCAttrs(scc));
+      if ((sccInfo != nullptr)
+          && DOALL::isDueToArrayReductions(sccInfo, { reduction })) {
+        reductions.push_back(reduction);
+        break;
+      }
+    }
+  }
+
+  return reductions;
+}
+
+bool DOALL::isDueToArrayReductions(
+    LoopCarriedSCC *sccInfo,
+    const std::vector<ArrayReduction> &reductions) {
+  for (auto &reduction : reductions) {
+
+    /*
+     * Check if all loop-carried data dependences of the SCC are between
+     * updates of the current array.
+     */
+    auto areAllDueToTheArray = true;
+    for (auto dep : sccInfo->getLoopCarriedDependences()) {
+      if (isa<ControlDependence<Value, Value>>(dep)) {
+        continue;
+      }
+      auto fromInst = dyn_cast<Instruction>(dep->getSrc());
+      auto toInst = dyn_cast<Instruction>(dep->getDst());
+      if (!isa<MemoryDependence<Value, Value>>(dep) || (fromInst == nullptr)
+          || (toInst == nullptr)
+          || (reduction.accesses.count(fromInst) == 0)
+          || (reduction.accesses.count(toInst) == 0)) {
+        areAllDueToTheArray = false;
+        break;
+      }
+    }
+    if (areAllDueToTheArray) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void DOALL::privatizeArrayReductions(LoopContent *LDI, DOALLTask *task) {
+
+  /*
+   * Fetch the arrays to privatize.
+   */
+  this->arrayReductions = this->getArrayReductions(LDI);
+  if (this->arrayReductions.size() == 0) {
+    return;
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Array reductions:\n";
+    for (auto &reduction : this->arrayReductions) {
+      errs() << "DOALL:     " << *reduction.object << " (" << reduction.size
+             << " bytes)\n";
+    }
+  }
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto int64 = tm->getIntegerType(64);
+  auto int8 = tm->getIntegerType(8);
+  auto voidPtrType = tm->getVoidPointerType();
+
+  /*
+   * Fetch the environment.
+   */
+  auto environment = LDI->getEnvironment();
+  auto envUser = this->envBuilder->getUser(0);
+
+  /*
+   * Fetch the allocator of the private copies.
+   */
+  auto program = this->n.getProgram();
+  auto callocFunction = program->getOrInsertFunction(
+      "calloc",
+      FunctionType::get(voidPtrType, { int64, int64 }, false));
+
+  /*
+   * Privatize the arrays.
+   */
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto maxCores = ltm->getMaximumNumberOfCores();
+  IRBuilder<> builder(this->entryPointOfParallelizedLoop);
+  IRBuilder<> taskEntryBuilder(task->getEntry()->getTerminator());
+  for (auto &reduction : this->arrayReductions) {
+
+    /*
+     * Allocate one copy per task instance.
+     * Zero is the identity of all combine operators.
+     */
+    auto copies = builder.CreateCall(
+        callocFunction,
+        { cm->getIntegerConstant(maxCores, 64),
+          cm->getIntegerConstant(reduction.size, 64) },
+        "noelle.doall.array_reduction.copies");
+    reduction.privateCopies = copies;
+
+    /*
+     * The copies are a new live-in of the loop.
+     */
+    auto envID = environment->addLiveInValue(copies, {});
+    this->envBuilder->addVariableToEnvironment(envID, copies->getType());
+    envUser->addLiveIn(envID);
+    auto envVarPtr =
+        envUser->createEnvironmentVariablePointer(taskEntryBuilder,
+                                                  envID,
+                                                  copies->getType());
+    auto copiesInTask = taskEntryBuilder.CreateLoad(
+        envVarPtr->getType()->getPointerElementType(),
+        envVarPtr,
+        "noelle.environment_variable.live_in");
+
+    /*
+     * Compute the copy of the current task instance.
+     */
+    auto offsetOfCopy = taskEntryBuilder.CreateMul(
+        task->taskInstanceID,
+        cm->getIntegerConstant(reduction.size, 64));
+    auto privateCopy = taskEntryBuilder.CreateInBoundsGEP(int8,
+                                                          copiesInTask,
+                                                          offsetOfCopy,
+                                                          "privateCopy");
+
+    /*
+     * Redirect the updates to the same element of the private copy.
+     */
+    auto objectInTask = isa<GlobalVariable>(reduction.object)
+                            ? reduction.object
+                            : this->fetchCloneInTask(task, reduction.object);
+    for (auto access : reduction.accesses) {
+      auto accessInTask = task->getCloneOfOriginalInstruction(access);
+      auto ptr = getLoadStorePointerOperand(accessInTask);
+      IRBuilder<> accessBuilder(accessInTask);
+      auto offset =
+          accessBuilder.CreateSub(accessBuilder.CreatePtrToInt(ptr, int64),
+                                  accessBuilder.CreatePtrToInt(objectInTask,
+                                                               int64));
+      auto ptrInPrivateCopy = accessBuilder.CreateBitCast(
+          accessBuilder.CreateInBoundsGEP(int8, privateCopy, offset),
+          ptr->getType());
+      accessInTask->replaceUsesOfWith(ptr, ptrInPrivateCopy);
+    }
+  }
+
+  return;
+}
+
+void DOALL::combineArrayReductions(LoopContent *LDI, IRBuilder<> &builder) {
+  if (this->arrayReductions.size() == 0) {
+    return;
+  }
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto voidPtrType = tm->getVoidPointerType();
+
+  /*
+   * Fetch the functions to dispatch the combine step and to free the copies.
+   */
+  auto program = this->n.getProgram();
+  auto dispatcher = program->getFunction("NOELLE_DOALLDispatcher");
+  assert(dispatcher != nullptr);
+  auto freeFunction = program->getOrInsertFunction(
+      "free",
+      FunctionType::get(tm->getVoidType(), { voidPtrType }, false));
+
+  /*
+   * Combine the private copies of every array.
+   * The elements of an array are partitioned between the cores, so the
+   * combine step runs in parallel.
+   */
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto maxCores = ltm->getMaximumNumberOfCores();
+  auto loopFunction = LDI->getLoopStructure()->getFunction();
+  auto taskSignature = this->tasks[0]->getTaskBody()->getFunctionType();
+  IRBuilder<> functionEntryBuilder(&*loopFunction->begin()->begin());
+  auto zero = cm->getIntegerConstant(0, 64);
+  for (auto &reduction : this->arrayReductions) {
+    auto combineFunction = createCombineFunction(*program,
+                                                 taskSignature,
+                                                 reduction,
+                                                 maxCores);
+
+    /*
+     * Create the environment of the combine step.
+     */
+    auto envType = ArrayType::get(voidPtrType, 2);
+    auto combineEnv =
+        functionEntryBuilder.CreateAlloca(envType,
+                                          nullptr,
+                                          "noelle.doall.array_reduction.env");
+    builder.CreateStore(
+        builder.CreateBitCast(reduction.object, voidPtrType),
+        builder.CreateInBoundsGEP(envType, combineEnv, { zero, zero }));
+    builder.CreateStore(
+        reduction.privateCopies,
+        builder.CreateInBoundsGEP(envType,
+                                  combineEnv,
+                                  { zero, cm->getIntegerConstant(1, 64) }));
+
+    /*
+     * Combine.
+     */
+    builder.CreateCall(dispatcher,
+                       { combineFunction,
+                         builder.CreateBitCast(combineEnv, voidPtrType),
+                         cm->getIntegerConstant(maxCores, 64),
+                         cm->getIntegerConstant(1, 64) });
+    builder.CreateCall(freeFunction, { reduction.privateCopies });
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -30,6 +30,17 @@ namespace arcana::gino {
 
 void DOALL::rewireLoopToIterateChunks(LoopContent *LDI, DOALLTask *task) {
 
+  /*
+   * Check if the chunks of the task can be iterated by an outer loop that
+   * surrounds a counted loop over the iterations of a chunk.
+   */
+  this->taskExecutedTheLastIteration = nullptr;
+  this->chunkCounter = nullptr;
+  if (this->useTwoLevelChunking && this->canIterateTwoLevelChunks(LDI)) {
+    this->rewireLoopToIterateTwoLevelChunks(LDI, task);
+    return;
+  }
+
   /*
    * Fetch loop and IV information.
    */
@@ -52,6 +63,7 @@ void DOALL::rewireLoopToIterateChunks(LoopContent *LDI, DOALLTask *task) {
                                             headerClone,
                                             chunkCounterType,
                                             task->chunkSizeArg);
+  this->chunkCounter = chunkPHI;
 
   /*
    * Collect clones of step size deriving values for all induction variables
@@ -285,44 +297,8 @@ void DOALL::rewireLoopToIterateChunks(LoopContent *LDI, DOALLTask *task) {
   /*
    * The exit condition value does not need to be computed each iteration and so
    * the value's derivation can be hoisted into the preheader.
-   *
-   * Instructions that the PDG states are independent can include PHI nodes.
-   * Assert that any PHIs are invariant. Hoist one of those values (if
-   * instructions) to the preheader.
    */
-  auto exitConditionValue =
-      this->fetchCloneInTask(task,
-                             loopGoverningIVAttr->getExitConditionValue());
-  assert(exitConditionValue != nullptr);
-  if (auto exitConditionInst = dyn_cast<Instruction>(exitConditionValue)) {
-    auto &derivation = ivUtility.getConditionValueDerivation();
-    for (auto I : derivation) {
-      assert(
-          invariantManager->isLoopInvariant(I)
-          && "DOALL exit condition value is not derived from loop invariant values!");
-
-      /*
-       * Fetch the clone of @I
-       */
-      auto cloneI = task->getCloneOfOriginalInstruction(I);
-
-      if (auto clonePHI = dyn_cast<PHINode>(cloneI)) {
-        auto usedValue = clonePHI->getIncomingValue(0);
-        clonePHI->replaceAllUsesWith(usedValue);
-        clonePHI->eraseFromParent();
-        cloneI = dyn_cast<Instruction>(usedValue);
-        if (!cloneI) {
-          continue;
-        }
-      }
-
-      cloneI->removeFromParent();
-      entryBuilder.Insert(cloneI);
-    }
-
-    exitConditionInst->removeFromParent();
-    entryBuilder.Insert(exitConditionInst);
-  }
+  this->hoistExitConditionValueDerivation(LDI, task, entryBuilder);
 
   /*
    * NOTE: When loop governing IV attribution allows for any other instructions
@@ -703,4 +679,61 @@ void DOALL::rewireLoopToIterateChunks(LoopContent *LDI, DOALLTask *task) {
       headerClone);
 }
 
+void DOALL::hoistExitConditionValueDerivation(LoopContent *LDI,
+                                              DOALLTask *task,
+                                              IRBuilder<> &entryBuilder) {
+
+  /*
+   * Fetch the loop governing IV.
+   */
+  auto invariantManager = LDI->getInvariantManager();
+  auto loopSummary = LDI->getLoopStructure();
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  LoopGoverningIVUtility ivUtility(loopSummary,
+                                   *allIVInfo,
+                                   *loopGoverningIVAttr);
+
+  /*
+   * Instructions that the PDG states are independent can include PHI nodes.
+   * Assert that any PHIs are invariant. Hoist one of those values (if
+   * instructions) to the preheader.
+   */
+  auto exitConditionValue =
+      this->fetchCloneInTask(task,
+                             loopGoverningIVAttr->getExitConditionValue());
+  assert(exitConditionValue != nullptr);
+  if (auto exitConditionInst = dyn_cast<Instruction>(exitConditionValue)) {
+    auto &derivation = ivUtility.getConditionValueDerivation();
+    for (auto I : derivation) {
+      assert(
+          invariantManager->isLoopInvariant(I)
+          && "DOALL exit condition value is not derived from loop invariant values!");
+
+      /*
+       * Fetch the clone of @I
+       */
+      auto cloneI = task->getCloneOfOriginalInstruction(I);
+
+      if (auto clonePHI = dyn_cast<PHINode>(cloneI)) {
+        auto usedValue = clonePHI->getIncomingValue(0);
+        clonePHI->replaceAllUsesWith(usedValue);
+        clonePHI->eraseFromParent();
+        cloneI = dyn_cast<Instruction>(usedValue);
+        if (!cloneI) {
+          continue;
+        }
+      }
+
+      cloneI->removeFromParent();
+      entryBuilder.Insert(cloneI);
+    }
+
+    exitConditionInst->removeFromParent();
+    entryBuilder.Insert(exitConditionInst);
+  }
+
+  return;
+}
+
 } // namespace arcana::gino
@@ -0,0 +1,765 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/noelle/core/InductionVariableSCC.hpp"
+#include "arcana/noelle/core/ReductionSCC.hpp"
+
+#include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+
+namespace arcana::gino {
+
+/*
+ * Check whether all users of @value that belong to the loop are in @users.
+ */
+static bool isUsedWithinTheLoopOnlyBy(LoopStructure *loopStructure,
+                                      Value *value,
+                                      const std::set<Value *> &users) {
+  for (auto user : value->users()) {
+    auto userInst = dyn_cast<Instruction>(user);
+    if ((userInst == nullptr)
+        || !loopStructure->isIncluded(userInst->getParent())) {
+      continue;
+    }
+    if (users.count(userInst) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Return the operator to combine the partial results of the accumulation
+ * given as input, which uses a value of @sccValues to read the current one.
+ * Floating-point accumulations need to allow reassociation unless
+ * @requiresReassociation is false.
+ */
+static bool getCombineOperatorOfAccumulation(
+    BinaryOperator *accumulation,
+    const std::set<Value *> &sccValues,
+    bool requiresReassociation,
+    Instruction::BinaryOps &combineOperator) {
+  auto isAccumulatorFirst = (sccValues.count(accumulation->getOperand(0)) > 0);
+  auto isAccumulatorSecond =
+      (sccValues.count(accumulation->getOperand(1)) > 0);
+  if (isAccumulatorFirst == isAccumulatorSecond) {
+    return false;
+  }
+
+  switch (accumulation->getOpcode()) {
+    case Instruction::Add:
+    case Instruction::Mul:
+    case Instruction::And:
+    case Instruction::Or:
+    case Instruction::Xor:
+      combineOperator = accumulation->getOpcode();
+      return true;
+    case Instruction::Sub:
+      combineOperator = Instruction::Add;
+      return isAccumulatorFirst;
+    case Instruction::FAdd:
+    case Instruction::FMul:
+      combineOperator = accumulation->getOpcode();
+      return !requiresReassociation || accumulation->hasAllowReassoc();
+    case Instruction::FSub:
+      combineOperator = Instruction::FAdd;
+      return isAccumulatorFirst
+             && (!requiresReassociation || accumulation->hasAllowReassoc());
+    default:
+      return false;
+  }
+}
+
+bool DOALL::isConditionalAccumulation(LoopStructure *loopStructure,
+                                      SCC *scc,
+                                      PHINode *headerPHI,
+                                      bool requiresReassociation,
+                                      Instruction::BinaryOps &combineOperator) {
+  auto loopHeader = loopStructure->getHeader();
+  auto loopPreHeader = loopStructure->getPreHeader();
+
+  /*
+   * The SCC must be composed by PHIs and selects that choose between
+   * accumulated values, and by accumulations that use the same combine
+   * operator.
+   */
+  std::set<Value *> sccValues;
+  for (auto nodePair : scc->internalNodePairs()) {
+    sccValues.insert(nodePair.first);
+  }
+  auto hasAccumulation = false;
+  for (auto value : sccValues) {
+    auto inst = dyn_cast<Instruction>(value);
+    if (inst == nullptr) {
+      return false;
+    }
+
+    /*
+     * Partial accumulations must not be read by the rest of the loop.
+     */
+    if (!isUsedWithinTheLoopOnlyBy(loopStructure, inst, sccValues)) {
+      return false;
+    }
+
+    if (auto phi = dyn_cast<PHINode>(inst)) {
+      if ((phi != headerPHI) && (phi->getParent() == loopHeader)) {
+        return false;
+      }
+      for (auto i = 0u; i < phi->getNumIncomingValues(); i++) {
+        if ((phi == headerPHI)
+            && (phi->getIncomingBlock(i) == loopPreHeader)) {
+          continue;
+        }
+        if (sccValues.count(phi->getIncomingValue(i)) == 0) {
+          return false;
+        }
+      }
+      continue;
+    }
+
+    if (auto select = dyn_cast<SelectInst>(inst)) {
+      if ((sccValues.count(select->getCondition()) > 0)
+          || (sccValues.count(select->getTrueValue()) == 0)
+          || (sccValues.count(select->getFalseValue()) == 0)) {
+        return false;
+      }
+      continue;
+    }
+
+    auto accumulation = dyn_cast<BinaryOperator>(inst);
+    if (accumulation == nullptr) {
+      return false;
+    }
+    Instruction::BinaryOps accumulationCombineOperator;
+    if (!getCombineOperatorOfAccumulation(accumulation,
+                                          sccValues,
+                                          requiresReassociation,
+                                          accumulationCombineOperator)) {
+      return false;
+    }
+    if (hasAccumulation && (accumulationCombineOperator != combineOperator)) {
+      return false;
+    }
+    combineOperator = accumulationCombineOperator;
+    hasAccumulation = true;
+  }
+
+  return hasAccumulation;
+}
+
+/*
+ * Return the select whose result is the only value that @headerPHI merges
+ * from the previous iteration.
+ */
+static SelectInst *getSelectOfHeaderPHI(LoopStructure *loopStructure,
+                                        SCC *scc,
+                                        PHINode *headerPHI) {
+  auto loopPreHeader = loopStructure->getPreHeader();
+  SelectInst *select = nullptr;
+  for (auto i = 0u; i < headerPHI->getNumIncomingValues(); i++) {
+    if (headerPHI->getIncomingBlock(i) == loopPreHeader) {
+      continue;
+    }
+    auto incomingSelect = dyn_cast<SelectInst>(headerPHI->getIncomingValue(i));
+    if ((incomingSelect == nullptr)
+        || ((select != nullptr) && (select != incomingSelect))) {
+      return nullptr;
+    }
+    select = incomingSelect;
+  }
+  if ((select == nullptr) || !scc->isInternal(select)) {
+    return nullptr;
+  }
+
+  return select;
+}
+
+/*
+ * Return the compare that decides whether the element of the current
+ * iteration replaces the one held by @headerPHI (e.g., x < min).
+ */
+static CmpInst *getCompareOfSelection(LoopStructure *loopStructure,
+                                      SCC *scc,
+                                      PHINode *headerPHI,
+                                      bool &selectsNewElementWhenTrue) {
+  if (scc->numInternalNodes() != 3) {
+    return nullptr;
+  }
+
+  /*
+   * The header PHI must merge the result of a single select.
+   */
+  auto select = getSelectOfHeaderPHI(loopStructure, scc, headerPHI);
+  if (select == nullptr) {
+    return nullptr;
+  }
+
+  /*
+   * The select must choose between the current element and the new one.
+   */
+  Value *newElement = nullptr;
+  if (select->getFalseValue() == headerPHI) {
+    newElement = select->getTrueValue();
+    selectsNewElementWhenTrue = true;
+  } else if (select->getTrueValue() == headerPHI) {
+    newElement = select->getFalseValue();
+    selectsNewElementWhenTrue = false;
+  } else {
+    return nullptr;
+  }
+  if (scc->isInternal(newElement)) {
+    return nullptr;
+  }
+
+  /*
+   * The condition of the select must order the two elements.
+   * Unordered floating-point comparisons are not handled because NaNs would
+   * make the order of the elements depend on how iterations are grouped.
+   */
+  auto compare = dyn_cast<CmpInst>(select->getCondition());
+  if ((compare == nullptr) || !scc->isInternal(compare)) {
+    return nullptr;
+  }
+  auto comparesElements =
+      ((compare->getOperand(0) == headerPHI)
+       && (compare->getOperand(1) == newElement))
+      || ((compare->getOperand(0) == newElement)
+          && (compare->getOperand(1) == headerPHI));
+  if (!comparesElements) {
+    return nullptr;
+  }
+  switch (compare->getPredicate()) {
+    case CmpInst::ICMP_SLT:
+    case CmpInst::ICMP_SLE:
+    case CmpInst::ICMP_SGT:
+    case CmpInst::ICMP_SGE:
+    case CmpInst::ICMP_ULT:
+    case CmpInst::ICMP_ULE:
+    case CmpInst::ICMP_UGT:
+    case CmpInst::ICMP_UGE:
+    case CmpInst::FCMP_OLT:
+    case CmpInst::FCMP_OLE:
+    case CmpInst::FCMP_OGT:
+    case CmpInst::FCMP_OGE:
+      break;
+    default:
+      return nullptr;
+  }
+
+  /*
+   * The selected element must not be read by the rest of the loop.
+   */
+  if (!isUsedWithinTheLoopOnlyBy(loopStructure, headerPHI, { compare, select })
+      || !isUsedWithinTheLoopOnlyBy(loopStructure, select, { headerPHI })) {
+    return nullptr;
+  }
+
+  return compare;
+}
+
+/*
+ * Return the select that assigns @headerPHI when a new element is selected
+ * (e.g., the index of the minimum).
+ */
+static SelectInst *getSelectOfVariableSelectedWithElement(
+    LoopStructure *loopStructure,
+    SCC *scc,
+    PHINode *headerPHI) {
+  if (scc->numInternalNodes() != 2) {
+    return nullptr;
+  }
+
+  /*
+   * The header PHI must merge the result of a single select that chooses
+   * between the current value and one computed outside the SCC.
+   */
+  auto select = getSelectOfHeaderPHI(loopStructure, scc, headerPHI);
+  if (select == nullptr) {
+    return nullptr;
+  }
+  if (scc->isInternal(select->getTrueValue())
+      == scc->isInternal(select->getFalseValue())) {
+    return nullptr;
+  }
+
+  /*
+   * The variable must not be read by the rest of the loop.
+   */
+  if (!isUsedWithinTheLoopOnlyBy(loopStructure, headerPHI, { select })
+      || !isUsedWithinTheLoopOnlyBy(loopStructure, select, { headerPHI })) {
+    return nullptr;
+  }
+
+  return select;
+}
+
+std::vector<CompositeReduction> DOALL::getCompositeReductions(
+    LoopContent *LDI) const {
+  std::vector<CompositeReduction> reductions;
+
+  /*
+   * Fetch the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopHeader = loopStructure->getHeader();
+  auto sccManager = LDI->getSCCManager();
+  auto sccdag = sccManager->getSCCDAG();
+
+  /*
+   * Ties between the elements selected by different task instances are
+   * broken by the iterations that selected them.
+   */
+  auto canBreakTies = this->canComputeIterations(LDI);
+
+  /*
+   * Identify the conditional accumulations and the selections.
+   */
+  auto deterministicReductions = this->getPHIsOfDeterministicReductions(LDI);
+  std::vector<PHINode *> otherPHIs;
+  for (auto &phi : loopHeader->phis()) {
+    if (deterministicReductions.count(&phi) > 0) {
+      continue;
+    }
+    auto scc = sccdag->sccOfValue(&phi);
+    auto sccInfo = sccManager->getSCCAttrs(scc);
+    if (isa<InductionVariableSCC>(sccInfo) || isa<ReductionSCC>(sccInfo)) {
+      continue;
+    }
+    CompositeReduction reduction;
+    reduction.headerPHI = &phi;
+    reduction.combineOperator = Instruction::BinaryOpsEnd;
+    reduction.compare = nullptr;
+    reduction.selectsNewElementWhenTrue = false;
+    reduction.values = nullptr;
+    reduction.iterations = nullptr;
+    if (DOALL::isConditionalAccumulation(loopStructure,
+                                         scc,
+                                         &phi,
+                                         true,
+                                         reduction.combineOperator)) {
+      reductions.push_back(reduction);
+      continue;
+    }
+    if (canBreakTies) {
+      reduction.compare =
+          getCompareOfSelection(loopStructure,
+                                scc,
+                                &phi,
+                                reduction.selectsNewElementWhenTrue);
+      if (reduction.compare != nullptr) {
+        reductions.push_back(reduction);
+        continue;
+      }
+    }
+    otherPHIs.push_back(&phi);
+  }
+
+  /*
+   * Identify the variables selected together with the elements.
+   */
+  std::map<CmpInst *, std::set<Value *>> selectsOfCompares;
+  for (auto &reduction : reductions) {
+    if (reduction.compare == nullptr) {
+      continue;
+    }
+    auto scc = sccdag->sccOfValue(reduction.headerPHI);
+    auto select =
+        getSelectOfHeaderPHI(loopStructure, scc, reduction.headerPHI);
+    selectsOfCompares[reduction.compare].insert(select);
+  }
+  for (auto phi : otherPHIs) {
+    auto scc = sccdag->sccOfValue(phi);
+    auto select = getSelectOfVariableSelectedWithElement(loopStructure,
+                                                         scc,
+                                                         phi);
+    if (select == nullptr) {
+      continue;
+    }
+    for (auto &reduction : reductions) {
+      if (select->getCondition() != reduction.compare) {
+        continue;
+      }
+      auto selectsNewValueWhenTrue = (select->getFalseValue() == phi);
+      if (selectsNewValueWhenTrue != reduction.selectsNewElementWhenTrue) {
+        break;
+      }
+      reduction.selectedWithPHIs.push_back(phi);
+      selectsOfCompares[reduction.compare].insert(select);
+      break;
+    }
+  }
+
+  /*
+   * The outcome of the comparisons must only be used to select.
+   */
+  std::vector<CompositeReduction> validReductions;
+  for (auto &reduction : reductions) {
+    if ((reduction.compare != nullptr)
+        && !isUsedWithinTheLoopOnlyBy(
+            loopStructure,
+            reduction.compare,
+            selectsOfCompares[reduction.compare])) {
+      continue;
+    }
+    validReductions.push_back(reduction);
+  }
+
+  return validReductions;
+}
+
+bool DOALL::isProducedByCompositeReduction(LoopContent *LDI,
+                                           uint32_t liveOutID) const {
+  auto loopEnv = LDI->getEnvironment();
+  auto producer = loopEnv->getProducer(liveOutID);
+  for (auto &reduction : this->getCompositeReductions(LDI)) {
+    if (producer == reduction.headerPHI) {
+      return true;
+    }
+    for (auto phi : reduction.selectedWithPHIs) {
+      if (producer == phi) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void DOALL::generateCodeToTrackCompositeReductions(LoopContent *LDI,
+                                                   DOALLTask *task) {
+
+  /*
+   * Collect the composite reductions.
+   */
+  this->compositeReductions = this->getCompositeReductions(LDI);
+  if (this->compositeReductions.size() == 0) {
+    return;
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Composite reductions:\n";
+    for (auto &reduction : this->compositeReductions) {
+      errs() << "DOALL:     " << *reduction.headerPHI << "\n";
+      for (auto phi : reduction.selectedWithPHIs) {
+        errs() << "DOALL:       Selected with " << *phi << "\n";
+      }
+    }
+  }
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto int64 = tm->getIntegerType(64);
+  auto zero = cm->getIntegerConstant(0, 64);
+  auto noIteration = cm->getIntegerConstant(-1, 64);
+
+  /*
+   * Fetch the loop.
+   */
+  auto environment = LDI->getEnvironment();
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopFunction = loopStructure->getFunction();
+  auto preheaderClone =
+      task->getCloneOfOriginalBasicBlock(loopStructure->getPreHeader());
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto maxCores = ltm->getMaximumNumberOfCores();
+
+  /*
+   * Define the function that adds a new live-in to the loop and that loads it
+   * within the task.
+   */
+  auto envUser = this->envBuilder->getUser(0);
+  IRBuilder<> taskEntryBuilder(task->getEntry()->getTerminator());
+  auto addLiveIn = [this, environment, envUser, &taskEntryBuilder](
+                       AllocaInst *alloca) -> Value * {
+    auto newLiveInEnvironmentID = environment->addLiveInValue(alloca, {});
+    this->envBuilder->addVariableToEnvironment(newLiveInEnvironmentID,
+                                               alloca->getType());
+    envUser->addLiveIn(newLiveInEnvironmentID);
+    auto envVarPtr =
+        envUser->createEnvironmentVariablePointer(taskEntryBuilder,
+                                                  newLiveInEnvironmentID,
+                                                  alloca->getType());
+    return taskEntryBuilder.CreateLoad(
+        envVarPtr->getType()->getPointerElementType(),
+        envVarPtr,
+        "noelle.environment_variable.live_in");
+  };
+
+  /*
+   * Define the function that allocates one slot per task instance for the
+   * value of a header PHI and that stores the value of the PHI in the slot
+   * of the current task instance when it leaves the loop.
+   */
+  IRBuilder<> functionEntryBuilder(&*loopFunction->begin()->begin());
+  auto trackValue = [this,
+                     task,
+                     maxCores,
+                     zero,
+                     addLiveIn,
+                     &functionEntryBuilder,
+                     &taskEntryBuilder](PHINode *phiClone,
+                                        const Twine &name) -> AllocaInst * {
+    auto slotsType = ArrayType::get(phiClone->getType(), maxCores);
+    auto slots = functionEntryBuilder.CreateAlloca(slotsType, nullptr, name);
+    auto slot =
+        taskEntryBuilder.CreateInBoundsGEP(slotsType,
+                                           addLiveIn(slots),
+                                           { zero, task->taskInstanceID });
+    for (auto i = 0; i < task->getNumberOfLastBlocks(); i++) {
+      auto bb = task->getLastBlock(i);
+      auto valueToStore =
+          this->fetchValueOfHeaderPHIWhenLeavingTask(phiClone, bb);
+      IRBuilder<> exitBuilder(bb->getTerminator());
+      exitBuilder.CreateStore(valueToStore, slot);
+    }
+
+    return slots;
+  };
+
+  /*
+   * Track the reductions.
+   */
+  IRBuilder<> builder(this->entryPointOfParallelizedLoop);
+  for (auto &reduction : this->compositeReductions) {
+    auto headerPHIClone =
+        cast<PHINode>(task->getCloneOfOriginalInstruction(reduction.headerPHI));
+
+    /*
+     * Conditional accumulations.
+     *
+     * Every task instance accumulates starting from the identity of the
+     * combine operator.
+     * Slots start with the identity as well so the ones of task instances
+     * that do not run do not change the result.
+     */
+    if (reduction.compare == nullptr) {
+      auto identity =
+          ConstantExpr::getBinOpIdentity(reduction.combineOperator,
+                                         headerPHIClone->getType());
+      headerPHIClone->setIncomingValueForBlock(preheaderClone, identity);
+      reduction.values = trackValue(headerPHIClone,
+                                    "noelle.doall.composite_reduction.values");
+      for (auto i = 0u; i < maxCores; i++) {
+        builder.CreateStore(
+            identity,
+            builder.CreateInBoundsGEP(
+                reduction.values->getAllocatedType(),
+                reduction.values,
+                { zero, cm->getIntegerConstant(i, 64) }));
+      }
+      continue;
+    }
+
+    /*
+     * Selections.
+     *
+     * Every task instance starts from the element the loop starts from, which
+     * is not selected by any iteration.
+     * Slots start without an iteration so the ones of task instances that do
+     * not run, or that never selected an element, are ignored.
+     */
+    reduction.values = trackValue(headerPHIClone,
+                                  "noelle.doall.composite_reduction.values");
+    for (auto phi : reduction.selectedWithPHIs) {
+      auto phiClone = cast<PHINode>(task->getCloneOfOriginalInstruction(phi));
+      reduction.selectedWithValues.push_back(
+          trackValue(phiClone,
+                     "noelle.doall.composite_reduction.selected_with"));
+    }
+
+    /*
+     * Track the iteration that selected the element.
+     */
+    auto iterationPHI = PHINode::Create(int64,
+                                        headerPHIClone->getNumIncomingValues(),
+                                        "selectedElementIteration",
+                                        headerPHIClone);
+    auto compareClone = task->getCloneOfOriginalInstruction(reduction.compare);
+    Instruction *selectClone = nullptr;
+    for (auto i = 0u; i < headerPHIClone->getNumIncomingValues(); i++) {
+      if (headerPHIClone->getIncomingBlock(i) != preheaderClone) {
+        selectClone = cast<Instruction>(headerPHIClone->getIncomingValue(i));
+        break;
+      }
+    }
+    assert(selectClone != nullptr);
+    IRBuilder<> selectBuilder(selectClone->getNextNode());
+    auto iteration =
+        this->generateCodeToComputeIteration(LDI, task, selectBuilder);
+    auto iterationSelect =
+        reduction.selectsNewElementWhenTrue
+            ? selectBuilder.CreateSelect(compareClone, iteration, iterationPHI)
+            : selectBuilder.CreateSelect(compareClone, iterationPHI, iteration);
+    for (auto i = 0u; i < headerPHIClone->getNumIncomingValues(); i++) {
+      auto incomingBB = headerPHIClone->getIncomingBlock(i);
+      if (incomingBB == preheaderClone) {
+        iterationPHI->addIncoming(noIteration, incomingBB);
+      } else {
+        iterationPHI->addIncoming(iterationSelect, incomingBB);
+      }
+    }
+    reduction.iterations =
+        trackValue(iterationPHI,
+                   "noelle.doall.composite_reduction.iterations");
+    builder.CreateMemSet(reduction.iterations,
+                         builder.getInt8(0xFF),
+                         maxCores * 8,
+                         reduction.iterations->getAlign());
+  }
+
+  return;
+}
+
+void DOALL::mergeCompositeReductions(LoopContent *LDI, IRBuilder<> &builder) {
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto int64 = tm->getIntegerType(64);
+  auto zero = cm->getIntegerConstant(0, 64);
+
+  /*
+   * Fetch the loop.
+   */
+  auto environment = LDI->getEnvironment();
+  auto loopPreHeader = LDI->getLoopStructure()->getPreHeader();
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto maxCores = ltm->getMaximumNumberOfCores();
+
+  /*
+   * Define the function that loads the slot of a task instance.
+   */
+  auto loadSlot = [&builder, cm, zero](AllocaInst *slots,
+                                       uint32_t taskInstance) -> Value * {
+    auto slotsType = cast<ArrayType>(slots->getAllocatedType());
+    auto slot = builder.CreateInBoundsGEP(
+        slotsType,
+        slots,
+        { zero, cm->getIntegerConstant(taskInstance, 64) });
+    return builder.CreateLoad(slotsType->getElementType(), slot);
+  };
+
+  /*
+   * Define the function that stores the final value of a header PHI to the
+   * live-out variables it produces.
+   */
+  auto storeLiveOut = [this, environment, &builder](PHINode *headerPHI,
+                                                    Value *value) {
+    for (auto envID : environment->getEnvIDsOfLiveOutVars()) {
+      if (environment->getProducer(envID) != headerPHI) {
+        continue;
+      }
+      auto envVar = this->envBuilder->getEnvironmentVariable(envID);
+      builder.CreateStore(value, envVar);
+    }
+
+    return;
+  };
+
+  for (auto &reduction : this->compositeReductions) {
+    Value *result =
+        reduction.headerPHI->getIncomingValueForBlock(loopPreHeader);
+
+    /*
+     * Conditional accumulations.
+     *
+     * Combine the value before the loop with the partial results of all task
+     * instances.
+     */
+    if (reduction.compare == nullptr) {
+      for (auto i = 0u; i < maxCores; i++) {
+        result = builder.CreateBinOp(reduction.combineOperator,
+                                     result,
+                                     loadSlot(reduction.values, i));
+      }
+      storeLiveOut(reduction.headerPHI, result);
+      continue;
+    }
+
+    /*
+     * Selections.
+     *
+     * Merge the elements selected by the task instances starting from the one
+     * before the loop.
+     * Between two elements, the one selected by the later iteration replaces
+     * the other if the comparison of the loop selects it.
+     * This replays what the sequential loop does between the two, so ties are
+     * broken like in the sequential execution (e.g., the lowest index wins
+     * for a strict comparison).
+     */
+    auto compareOperandOfCurrentElement =
+        (reduction.compare->getOperand(0) == reduction.headerPHI) ? 0 : 1;
+    Value *resultIteration = cm->getIntegerConstant(-1, 64);
+    std::vector<Value *> resultsSelectedWith;
+    for (auto phi : reduction.selectedWithPHIs) {
+      resultsSelectedWith.push_back(
+          phi->getIncomingValueForBlock(loopPreHeader));
+    }
+    for (auto i = 0u; i < maxCores; i++) {
+      auto value = loadSlot(reduction.values, i);
+      auto iteration = loadSlot(reduction.iterations, i);
+      auto hasSelected = builder.CreateICmpSGE(iteration, zero);
+      auto isLater = builder.CreateICmpSGT(iteration, resultIteration);
+
+      /*
+       * Compare the later element against the earlier one.
+       */
+      auto earlierValue = builder.CreateSelect(isLater, result, value);
+      auto laterValue = builder.CreateSelect(isLater, value, result);
+      auto compare = reduction.compare->clone();
+      compare->setOperand(compareOperandOfCurrentElement, earlierValue);
+      compare->setOperand(1 - compareOperandOfCurrentElement, laterValue);
+      builder.Insert(compare);
+      auto laterWins = reduction.selectsNewElementWhenTrue
+                           ? compare
+                           : builder.CreateNot(compare);
+      auto earlierWins = builder.CreateNot(laterWins);
+      auto slotWins = builder.CreateSelect(isLater, laterWins, earlierWins);
+      auto takeSlot = builder.CreateAnd(hasSelected, slotWins);
+
+      /*
+       * Select the winner.
+       */
+      result = builder.CreateSelect(takeSlot, value, result);
+      resultIteration =
+          builder.CreateSelect(takeSlot, iteration, resultIteration);
+      for (auto j = 0u; j < resultsSelectedWith.size(); j++) {
+        auto selectedWith = loadSlot(reduction.selectedWithValues[j], i);
+        resultsSelectedWith[j] = builder.CreateSelect(takeSlot,
+                                                      selectedWith,
+                                                      resultsSelectedWith[j]);
+      }
+    }
+    storeLiveOut(reduction.headerPHI, result);
+    for (auto j = 0u; j < resultsSelectedWith.size(); j++) {
+      storeLiveOut(reduction.selectedWithPHIs[j], resultsSelectedWith[j]);
+    }
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -0,0 +1,535 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/noelle/core/InductionVariableSCC.hpp"
+
+#include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+namespace arcana::gino {
+
+/*
+ * Number of iterations of the blocks whose partial sums are computed
+ * sequentially.
+ * Chunks are rounded up to a multiple of it, so every block is executed by a
+ * single task instance.
+ * It is a multiple of the number of iterations chunks get aligned to, which
+ * are at most the ones that write a whole cache line.
+ */
+static const uint64_t iterationsPerBlock = 256;
+
+/*
+ * Return the runtime function that combines the partial sums of the type
+ * given as input in a fixed tree order.
+ */
+static Function *getFunctionToCombinePartialSums(Module *program, Type *type) {
+  if (type->isDoubleTy()) {
+    return program->getFunction("NOELLE_reduceDoublesInTreeOrder");
+  }
+  if (type->isFloatTy()) {
+    return program->getFunction("NOELLE_reduceFloatsInTreeOrder");
+  }
+
+  return nullptr;
+}
+
+/*
+ * Fetch the condition on the loop governing IV to keep iterating the loop.
+ * The IV must move towards the value it is compared against.
+ */
+static bool getConditionToKeepIterating(LoopContent *LDI,
+                                        CmpInst::Predicate &predicate) {
+
+  /*
+   * Fetch the loop governing IV.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  if (loopGoverningIVAttr == nullptr) {
+    return false;
+  }
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto stepValue = dyn_cast_or_null<ConstantInt>(
+      loopGoverningIV->getSingleComputedStepValue());
+  if (stepValue == nullptr) {
+    return false;
+  }
+
+  /*
+   * The value the IV is compared against must be available before the loop.
+   */
+  auto exitValue = loopGoverningIVAttr->getExitConditionValue();
+  auto exitInst = dyn_cast<Instruction>(exitValue);
+  if ((exitInst != nullptr)
+      && loopStructure->isIncluded(exitInst->getParent())) {
+    return false;
+  }
+
+  /*
+   * Fetch the condition to keep iterating.
+   */
+  auto compare =
+      loopGoverningIVAttr->getHeaderCompareInstructionToComputeExitCondition();
+  if (compare->getOperand(0)
+      != loopGoverningIVAttr->getValueToCompareAgainstExitConditionValue()) {
+    return false;
+  }
+  auto headerBr =
+      dyn_cast<BranchInst>(loopStructure->getHeader()->getTerminator());
+  if ((headerBr == nullptr) || !headerBr->isConditional()
+      || (headerBr->getCondition() != compare)) {
+    return false;
+  }
+  auto keepsIteratingWhenTrue =
+      loopStructure->isIncluded(headerBr->getSuccessor(0));
+  predicate = keepsIteratingWhenTrue ? compare->getPredicate()
+                                     : compare->getInversePredicate();
+
+  /*
+   * Check the IV moves towards the value it is compared against.
+   */
+  switch (predicate) {
+    case CmpInst::ICMP_NE:
+      return true;
+    case CmpInst::ICMP_SLT:
+    case CmpInst::ICMP_SLE:
+    case CmpInst::ICMP_ULT:
+    case CmpInst::ICMP_ULE:
+      return !stepValue->isNegative();
+    case CmpInst::ICMP_SGT:
+    case CmpInst::ICMP_SGE:
+    case CmpInst::ICMP_UGT:
+    case CmpInst::ICMP_UGE:
+      return stepValue->isNegative();
+    default:
+      return false;
+  }
+}
+
+uint64_t DOALL::getIterationsPerDeterministicReductionBlock(void) {
+  return iterationsPerBlock;
+}
+
+std::set<PHINode *> DOALL::getPHIsOfDeterministicReductions(
+    LoopContent *LDI) const {
+  std::set<PHINode *> phis;
+
+  /*
+   * Check if deterministic reductions have been requested.
+   */
+  if (!this->useDeterministicReductions) {
+    return phis;
+  }
+
+  /*
+   * Blocks are identified by the iterations they include and the number of
+   * blocks is derived from the condition to keep iterating.
+   */
+  CmpInst::Predicate predicate;
+  if (!this->canComputeIterations(LDI)
+      || !getConditionToKeepIterating(LDI, predicate)) {
+    return phis;
+  }
+
+  /*
+   * Fetch the loop.
+   */
+  auto program = this->n.getProgram();
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopHeader = loopStructure->getHeader();
+  auto loopEnv = LDI->getEnvironment();
+  auto sccManager = LDI->getSCCManager();
+  auto sccdag = sccManager->getSCCDAG();
+
+  /*
+   * Identify the floating-point sums.
+   */
+  for (auto &phi : loopHeader->phis()) {
+    if (getFunctionToCombinePartialSums(program, phi.getType()) == nullptr) {
+      continue;
+    }
+    auto scc = sccdag->sccOfValue(&phi);
+    if (isa<InductionVariableSCC>(sccManager->getSCCAttrs(scc))) {
+      continue;
+    }
+    Instruction::BinaryOps combineOperator;
+    if (!DOALL::isConditionalAccumulation(loopStructure,
+                                          scc,
+                                          &phi,
+                                          false,
+                                          combineOperator)
+        || (combineOperator != Instruction::FAdd)) {
+      continue;
+    }
+
+    /*
+     * The sum can be used after the loop only if the value used includes the
+     * contributions of all iterations, which get added to the partial sums at
+     * their end.
+     * This is the header PHI if the header is the only block that leaves the
+     * loop, or the value given to the header by the latch that is the only
+     * block that leaves the loop.
+     */
+    auto isUsedAfterTheLoopOnlyAsTheSum = true;
+    for (auto envID : loopEnv->getEnvIDsOfLiveOutVars()) {
+      auto producer = loopEnv->getProducer(envID);
+      if (!scc->isInternal(producer)) {
+        continue;
+      }
+      BasicBlock *blockThatMustLeaveTheLoop = nullptr;
+      if (producer == &phi) {
+        blockThatMustLeaveTheLoop = loopHeader;
+      } else {
+        for (auto i = 0u; i < phi.getNumIncomingValues(); i++) {
+          if (phi.getIncomingValue(i) == producer) {
+            blockThatMustLeaveTheLoop = phi.getIncomingBlock(i);
+          }
+        }
+      }
+      for (auto exitEdge : loopStructure->getLoopExitEdges()) {
+        if (exitEdge.first != blockThatMustLeaveTheLoop) {
+          isUsedAfterTheLoopOnlyAsTheSum = false;
+        }
+      }
+      if (blockThatMustLeaveTheLoop == nullptr) {
+        isUsedAfterTheLoopOnlyAsTheSum = false;
+      }
+    }
+    if (!isUsedAfterTheLoopOnlyAsTheSum) {
+      continue;
+    }
+
+    phis.insert(&phi);
+  }
+
+  return phis;
+}
+
+bool DOALL::isProducedByDeterministicReduction(LoopContent *LDI,
+                                               uint32_t liveOutID) const {
+  auto loopEnv = LDI->getEnvironment();
+  auto producer = loopEnv->getProducer(liveOutID);
+  auto sccdag = LDI->getSCCManager()->getSCCDAG();
+  for (auto phi : this->getPHIsOfDeterministicReductions(LDI)) {
+    if (sccdag->sccOfValue(phi)->isInternal(producer)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Value *DOALL::generateCodeToComputeMaximumNumberOfIterations(
+    LoopContent *LDI,
+    IRBuilder<> &builder) {
+
+  /*
+   * Fetch the loop governing IV.
+   */
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto startValue = loopGoverningIV->getStartValue();
+  auto exitValue = loopGoverningIVAttr->getExitConditionValue();
+  auto stepValue =
+      cast<ConstantInt>(loopGoverningIV->getSingleComputedStepValue());
+  CmpInst::Predicate predicate;
+  auto hasCondition = getConditionToKeepIterating(LDI, predicate);
+  assert(hasCondition);
+
+  /*
+   * Compute the distance the IV travels.
+   * The loop does not iterate if the condition does not hold for the start
+   * value.
+   */
+  Value *distance = nullptr;
+  if (stepValue->isNegative()) {
+    distance = builder.CreateSub(startValue, exitValue);
+  } else {
+    distance = builder.CreateSub(exitValue, startValue);
+  }
+  if (predicate != CmpInst::ICMP_NE) {
+    auto doesIterate = builder.CreateICmp(predicate, startValue, exitValue);
+    distance = builder.CreateSelect(doesIterate,
+                                    distance,
+                                    ConstantInt::get(distance->getType(), 0));
+  }
+
+  /*
+   * Compute the number of iterations.
+   * Two more iterations cover the inclusive conditions and the conditions
+   * checked on the IV value of the next iteration.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto absoluteStep =
+      cm->getIntegerConstant(stepValue->getValue().abs().getZExtValue(), 64);
+  auto iterations =
+      builder.CreateUDiv(builder.CreateZExt(distance, tm->getIntegerType(64)),
+                         absoluteStep);
+
+  return builder.CreateAdd(iterations,
+                           cm->getIntegerConstant(2, 64),
+                           "maximumNumberOfIterations");
+}
+
+void DOALL::generateCodeToComputeReductionsInBlocks(LoopContent *LDI,
+                                                    DOALLTask *task) {
+  this->deterministicReductions.clear();
+
+  /*
+   * Collect the floating-point sums.
+   */
+  auto phis = this->getPHIsOfDeterministicReductions(LDI);
+  if (phis.size() == 0) {
+    return;
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Deterministic reductions:\n";
+    for (auto phi : phis) {
+      errs() << "DOALL:     " << *phi << "\n";
+    }
+  }
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto int64 = tm->getIntegerType(64);
+  auto voidPtrType = tm->getVoidPointerType();
+  auto blockSize = cm->getIntegerConstant(iterationsPerBlock, 64);
+
+  /*
+   * Fetch the loop and its environment.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto preheaderClone =
+      task->getCloneOfOriginalBasicBlock(loopStructure->getPreHeader());
+  auto &DL = loopStructure->getFunction()->getParent()->getDataLayout();
+  auto environment = LDI->getEnvironment();
+  auto envUser = this->envBuilder->getUser(0);
+
+  /*
+   * Compute the number of blocks.
+   * This only depends on the loop, so the blocks are the same no matter how
+   * many task instances run.
+   */
+  IRBuilder<> builder(this->entryPointOfParallelizedLoop);
+  auto maximumNumberOfIterations =
+      this->generateCodeToComputeMaximumNumberOfIterations(LDI, builder);
+  auto numberOfBlocks = builder.CreateAdd(
+      builder.CreateUDiv(maximumNumberOfIterations, blockSize),
+      cm->getIntegerConstant(1, 64),
+      "numberOfBlocks");
+
+  /*
+   * Fetch the allocator of the partial sums.
+   */
+  auto program = this->n.getProgram();
+  auto allocateFunction = program->getOrInsertFunction(
+      "NOELLE_allocatePartialSums",
+      FunctionType::get(voidPtrType, { int64, int64 }, false));
+  auto noBlock = cm->getIntegerConstant(-1, 64);
+  auto lastIterationOfBlock =
+      cm->getIntegerConstant(iterationsPerBlock - 1, 64);
+
+  /*
+   * Compute the sums in blocks.
+   */
+  IRBuilder<> taskEntryBuilder(task->getEntry()->getTerminator());
+  for (auto phi : phis) {
+    auto type = phi->getType();
+
+    /*
+     * Allocate one partial sum per block.
+     */
+    auto partialSums = builder.CreateBitCast(
+        builder.CreateCall(
+            allocateFunction,
+            { numberOfBlocks,
+              cm->getIntegerConstant(DL.getTypeAllocSize(type), 64) },
+            "noelle.doall.deterministic_reduction.partial_sums"),
+        PointerType::getUnqual(type));
+    this->deterministicReductions.push_back(
+        { phi, partialSums, numberOfBlocks });
+
+    /*
+     * The partial sums are a new live-in of the loop.
+     */
+    auto envID = environment->addLiveInValue(partialSums, {});
+    this->envBuilder->addVariableToEnvironment(envID, partialSums->getType());
+    envUser->addLiveIn(envID);
+    auto envVarPtr =
+        envUser->createEnvironmentVariablePointer(taskEntryBuilder,
+                                                  envID,
+                                                  partialSums->getType());
+    auto partialSumsInTask = taskEntryBuilder.CreateLoad(
+        envVarPtr->getType()->getPointerElementType(),
+        envVarPtr,
+        "noelle.environment_variable.live_in");
+
+    /*
+     * The sum of the current block is kept in the header PHI and it is stored
+     * to the partial sum of the block at the end of its last iteration.
+     * Iterations of a block run in order within a single task instance, so
+     * every partial sum is computed like the sequential loop does.
+     * The header also tracks the block whose sum has not been stored yet.
+     */
+    auto headerPHIClone =
+        cast<PHINode>(task->getCloneOfOriginalInstruction(phi));
+    auto identity = ConstantExpr::getBinOpIdentity(Instruction::FAdd, type);
+    auto pendingBlockPHI =
+        PHINode::Create(int64,
+                        headerPHIClone->getNumIncomingValues(),
+                        "noelle.doall.deterministic_reduction.pending_block",
+                        headerPHIClone);
+    std::vector<std::tuple<Instruction *, Value *, Value *, Value *>>
+        storesAtEndOfBlocks;
+    for (auto i = 0u; i < headerPHIClone->getNumIncomingValues(); i++) {
+      auto incomingBB = headerPHIClone->getIncomingBlock(i);
+      if (incomingBB == preheaderClone) {
+        headerPHIClone->setIncomingValue(i, identity);
+        pendingBlockPHI->addIncoming(noBlock, incomingBB);
+        continue;
+      }
+      auto sumOfBlock = headerPHIClone->getIncomingValue(i);
+      IRBuilder<> latchBuilder(incomingBB->getTerminator());
+      auto iteration =
+          this->generateCodeToComputeIteration(LDI, task, latchBuilder);
+      auto block = latchBuilder.CreateUDiv(iteration, blockSize);
+      auto endsBlock =
+          latchBuilder.CreateICmpEQ(latchBuilder.CreateURem(iteration,
+                                                            blockSize),
+                                    lastIterationOfBlock);
+      headerPHIClone->setIncomingValue(
+          i,
+          latchBuilder.CreateSelect(endsBlock, identity, sumOfBlock));
+      pendingBlockPHI->addIncoming(
+          latchBuilder.CreateSelect(endsBlock, noBlock, block),
+          incomingBB);
+      storesAtEndOfBlocks.push_back(
+          { incomingBB->getTerminator(), endsBlock, sumOfBlock, block });
+    }
+
+    /*
+     * Store the sum of a block when its last iteration ends.
+     */
+    for (auto &store : storesAtEndOfBlocks) {
+      auto storeTerminator = SplitBlockAndInsertIfThen(std::get<1>(store),
+                                                       std::get<0>(store),
+                                                       false);
+      IRBuilder<> storeBuilder(storeTerminator);
+      storeBuilder.CreateStore(
+          std::get<2>(store),
+          storeBuilder.CreateInBoundsGEP(type,
+                                         partialSumsInTask,
+                                         std::get<3>(store)));
+    }
+
+    /*
+     * Store the sum of the block left in the middle when the task instance
+     * leaves the loop.
+     */
+    for (auto i = 0; i < task->getNumberOfLastBlocks(); i++) {
+      auto bb = task->getLastBlock(i);
+      auto sumOfBlock =
+          this->fetchValueOfHeaderPHIWhenLeavingTask(headerPHIClone, bb);
+      auto pendingBlock =
+          this->fetchValueOfHeaderPHIWhenLeavingTask(pendingBlockPHI, bb);
+      IRBuilder<> exitBuilder(bb->getTerminator());
+      auto isPending = exitBuilder.CreateICmpNE(pendingBlock, noBlock);
+      auto storeTerminator =
+          SplitBlockAndInsertIfThen(isPending, bb->getTerminator(), false);
+      IRBuilder<> storeBuilder(storeTerminator);
+      storeBuilder.CreateStore(
+          sumOfBlock,
+          storeBuilder.CreateInBoundsGEP(type,
+                                         partialSumsInTask,
+                                         pendingBlock));
+    }
+  }
+
+  return;
+}
+
+void DOALL::combineDeterministicReductions(LoopContent *LDI,
+                                           IRBuilder<> &builder) {
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto voidPtrType = tm->getVoidPointerType();
+
+  /*
+   * Fetch the function to free the partial sums.
+   */
+  auto program = this->n.getProgram();
+  auto freeFunction = program->getOrInsertFunction(
+      "free",
+      FunctionType::get(tm->getVoidType(), { voidPtrType }, false));
+
+  /*
+   * Combine the partial sums in a fixed tree order and add the value the sum
+   * had before the loop.
+   */
+  auto environment = LDI->getEnvironment();
+  auto loopPreHeader = LDI->getLoopStructure()->getPreHeader();
+  auto sccdag = LDI->getSCCManager()->getSCCDAG();
+  for (auto &reduction : this->deterministicReductions) {
+    auto combineFunction =
+        getFunctionToCombinePartialSums(program,
+                                        reduction.headerPHI->getType());
+    assert(combineFunction != nullptr);
+    auto sumOfBlocks =
+        builder.CreateCall(combineFunction,
+                           { reduction.partials, reduction.numberOfBlocks });
+    auto initialValue =
+        reduction.headerPHI->getIncomingValueForBlock(loopPreHeader);
+    auto result = builder.CreateFAdd(initialValue, sumOfBlocks);
+
+    /*
+     * Store the sum to the live-out variables it produces.
+     */
+    auto scc = sccdag->sccOfValue(reduction.headerPHI);
+    for (auto envID : environment->getEnvIDsOfLiveOutVars()) {
+      if (!scc->isInternal(environment->getProducer(envID))) {
+        continue;
+      }
+      auto envVar = this->envBuilder->getEnvironmentVariable(envID);
+      builder.CreateStore(result, envVar);
+    }
+
+    /*
+     * Free the partial sums.
+     */
+    builder.CreateCall(freeFunction,
+                       { builder.CreateBitCast(reduction.partials,
+                                               voidPtrType) });
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -42,6 +42,32 @@ BasicBlock *DOALL::getBasicBlockExecutedOnlyByLastIterationBeforeExitingTask(
   TypesManager typesManager(*taskModule);
   ConstantsManager constantsManager(*taskModule, &typesManager);
 
+  /*
+   * Check if the chunks have been iterated by a two-level loop.
+   * In this case, the outer loop already computed whether the task has
+   * executed the last iteration.
+   */
+  assert(bb.size() > 0);
+  if (this->taskExecutedTheLastIteration != nullptr) {
+    auto addConditionalBranch = [this, &bb](BasicBlock *newBB,
+                                            BasicBlock *newJoinBB) {
+      IRBuilder<> lastBBBuilder(&bb);
+      lastBBBuilder.CreateCondBr(this->taskExecutedTheLastIteration,
+                                 newBB,
+                                 newJoinBB);
+
+      return;
+    };
+    auto cfgTransformer = this->noelle.getCFGTransformer();
+    auto newBB = cfgTransformer.branchToANewBasicBlockAndBack(
+        bb.getTerminator(),
+        "code_executed_only_by_the_last_loop_iteration",
+        "very_last_bb_before_exiting_task",
+        addConditionalBranch);
+
+    return newBB;
+  }
+
   /*
    * Collect clones of step size deriving values for all induction variables
    * of the top level loop
@@ -212,4 +238,66 @@ BasicBlock *DOALL::getBasicBlockExecutedOnlyByLastIterationBeforeExitingTask(
   return newBB;
 }
 
+bool DOALL::canComputeIterations(LoopContent *LDI) const {
+
+  /*
+   * Iterations are computed from the loop governing IV.
+   */
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  if (loopGoverningIVAttr == nullptr) {
+    return false;
+  }
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto loopGoverningIVType = loopGoverningIV->getLoopEntryPHI()->getType();
+  if (!loopGoverningIVType->isIntegerTy()
+      || (loopGoverningIVType->getIntegerBitWidth() > 64)) {
+    return false;
+  }
+  auto stepValue = dyn_cast_or_null<ConstantInt>(
+      loopGoverningIV->getSingleComputedStepValue());
+  if ((stepValue == nullptr) || stepValue->isZero()) {
+    return false;
+  }
+
+  return true;
+}
+
+Value *DOALL::generateCodeToComputeIteration(LoopContent *LDI,
+                                             DOALLTask *task,
+                                             IRBuilder<> &builder) {
+
+  /*
+   * Fetch the loop governing IV.
+   */
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto ivPHI =
+      task->getCloneOfOriginalInstruction(loopGoverningIV->getLoopEntryPHI());
+  auto startOfIV =
+      this->fetchCloneInTask(task, loopGoverningIV->getStartValue());
+  auto stepOfIV =
+      cast<ConstantInt>(loopGoverningIV->getSingleComputedStepValue());
+
+  /*
+   * Compute the distance from the first iteration of the loop.
+   * This is computed on the type of the IV to wrap around like the IV does.
+   */
+  auto ivType = ivPHI->getType();
+  Value *distance = nullptr;
+  if (stepOfIV->isNegative()) {
+    distance = builder.CreateSub(startOfIV, ivPHI);
+  } else {
+    distance = builder.CreateSub(ivPHI, startOfIV);
+  }
+  auto absoluteStep = ConstantInt::get(ivType, stepOfIV->getValue().abs());
+  auto iteration = builder.CreateUDiv(distance, absoluteStep);
+
+  auto tm = this->n.getTypesManager();
+  return builder.CreateZExtOrTrunc(iteration,
+                                   tm->getIntegerType(64),
+                                   "iteration");
+}
+
 } // namespace arcana::gino
@@ -0,0 +1,375 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+
+namespace arcana::gino {
+
+std::set<PHINode *> DOALL::getPHIsOfLastPrivateVariable(
+    LoopContent *LDI,
+    uint32_t liveOutID) const {
+  std::set<PHINode *> phis;
+
+  /*
+   * Fetch the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopHeader = loopStructure->getHeader();
+  auto loopEnv = LDI->getEnvironment();
+
+  /*
+   * The live-out variable must be a PHI of the header, which is the value
+   * used after the loop.
+   */
+  auto headerPHI = dyn_cast<PHINode>(loopEnv->getProducer(liveOutID));
+  if ((headerPHI == nullptr) || (headerPHI->getParent() != loopHeader)) {
+    return phis;
+  }
+
+  /*
+   * Assignments are ordered by their iteration.
+   */
+  if (!this->canComputeIterations(LDI)) {
+    return phis;
+  }
+
+  /*
+   * The SCC of the live-out variable must only select between the values
+   * assigned by loop iterations.
+   * So it must be composed only by PHIs and the header PHI must be the only
+   * one that merges the values across iterations.
+   */
+  auto sccManager = LDI->getSCCManager();
+  auto scc = sccManager->getSCCDAG()->sccOfValue(headerPHI);
+  std::set<PHINode *> sccPHIs;
+  for (auto nodePair : scc->internalNodePairs()) {
+    auto phi = dyn_cast<PHINode>(nodePair.first);
+    if (phi == nullptr) {
+      return phis;
+    }
+    if ((phi != headerPHI) && (phi->getParent() == loopHeader)) {
+      return phis;
+    }
+    sccPHIs.insert(phi);
+  }
+
+  /*
+   * The values of the variable must not be read within the loop.
+   * Otherwise iterations would depend on the assignments of previous ones.
+   */
+  for (auto phi : sccPHIs) {
+    for (auto user : phi->users()) {
+      auto userInst = dyn_cast<Instruction>(user);
+      if ((userInst == nullptr)
+          || !loopStructure->isIncluded(userInst->getParent())) {
+        continue;
+      }
+      if (!isa<PHINode>(userInst)
+          || (sccPHIs.count(cast<PHINode>(userInst)) == 0)) {
+        return phis;
+      }
+    }
+  }
+
+  return sccPHIs;
+}
+
+void DOALL::generateCodeToTrackLastPrivateVariables(LoopContent *LDI,
+                                                    DOALLTask *task) {
+  this->lastPrivateVariables.clear();
+
+  /*
+   * Collect the last-private live-out variables.
+   */
+  auto environment = LDI->getEnvironment();
+  std::map<uint32_t, std::set<PHINode *>> phisOfVariables;
+  for (auto envID : environment->getEnvIDsOfLiveOutVars()) {
+    auto phis = this->getPHIsOfLastPrivateVariable(LDI, envID);
+    if (phis.size() == 0) {
+      continue;
+    }
+    phisOfVariables[envID] = phis;
+  }
+  if (phisOfVariables.size() == 0) {
+    return;
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Last-private variables:\n";
+    for (auto &pair : phisOfVariables) {
+      errs() << "DOALL:     " << *environment->getProducer(pair.first)
+             << "\n";
+    }
+  }
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto int64 = tm->getIntegerType(64);
+  auto zero = cm->getIntegerConstant(0, 64);
+  auto noIteration = cm->getIntegerConstant(-1, 64);
+
+  /*
+   * Fetch the loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopFunction = loopStructure->getFunction();
+  auto preheaderClone =
+      task->getCloneOfOriginalBasicBlock(loopStructure->getPreHeader());
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto maxCores = ltm->getMaximumNumberOfCores();
+
+  /*
+   * Define the function that adds a new live-in to the loop and that loads it
+   * within the task.
+   */
+  auto envUser = this->envBuilder->getUser(0);
+  IRBuilder<> taskEntryBuilder(task->getEntry()->getTerminator());
+  auto addLiveIn = [this, environment, envUser, &taskEntryBuilder](
+                       AllocaInst *alloca) -> Value * {
+    auto newLiveInEnvironmentID = environment->addLiveInValue(alloca, {});
+    this->envBuilder->addVariableToEnvironment(newLiveInEnvironmentID,
+                                               alloca->getType());
+    envUser->addLiveIn(newLiveInEnvironmentID);
+    auto envVarPtr =
+        envUser->createEnvironmentVariablePointer(taskEntryBuilder,
+                                                  newLiveInEnvironmentID,
+                                                  alloca->getType());
+    return taskEntryBuilder.CreateLoad(
+        envVarPtr->getType()->getPointerElementType(),
+        envVarPtr,
+        "noelle.environment_variable.live_in");
+  };
+
+  /*
+   * Track the variables.
+   */
+  IRBuilder<> functionEntryBuilder(&*loopFunction->begin()->begin());
+  IRBuilder<> builder(this->entryPointOfParallelizedLoop);
+  for (auto &pair : phisOfVariables) {
+    auto envID = pair.first;
+    auto &phis = pair.second;
+    auto headerPHI = cast<PHINode>(environment->getProducer(envID));
+    auto headerPHIClone =
+        cast<PHINode>(task->getCloneOfOriginalInstruction(headerPHI));
+
+    /*
+     * Allocate one slot per task instance to store the last value assigned
+     * and the iteration that assigned it.
+     * Slots start without an iteration so the ones of task instances that do
+     * not run are ignored.
+     */
+    auto valuesType = ArrayType::get(headerPHI->getType(), maxCores);
+    auto iterationsType = ArrayType::get(int64, maxCores);
+    auto values =
+        functionEntryBuilder.CreateAlloca(valuesType,
+                                          nullptr,
+                                          "noelle.doall.last_private.values");
+    auto iterations = functionEntryBuilder.CreateAlloca(
+        iterationsType,
+        nullptr,
+        "noelle.doall.last_private.iterations");
+    builder.CreateMemSet(iterations,
+                         builder.getInt8(0xFF),
+                         maxCores * 8,
+                         iterations->getAlign());
+    this->lastPrivateVariables.push_back(
+        { envID, headerPHI, values, iterations });
+
+    /*
+     * Fetch the slots of the current task instance.
+     */
+    auto valueSlot =
+        taskEntryBuilder.CreateInBoundsGEP(valuesType,
+                                           addLiveIn(values),
+                                           { zero, task->taskInstanceID });
+    auto iterationSlot =
+        taskEntryBuilder.CreateInBoundsGEP(iterationsType,
+                                           addLiveIn(iterations),
+                                           { zero, task->taskInstanceID });
+
+    /*
+     * Track the iteration that assigned the value held by every PHI of the
+     * variable.
+     */
+    std::map<PHINode *, PHINode *> iterationOfPHIs;
+    for (auto phi : phis) {
+      auto phiClone = cast<PHINode>(task->getCloneOfOriginalInstruction(phi));
+      iterationOfPHIs[phiClone] =
+          PHINode::Create(int64,
+                          phiClone->getNumIncomingValues(),
+                          "lastAssignmentIteration",
+                          phiClone);
+    }
+    for (auto &phiPair : iterationOfPHIs) {
+      auto phiClone = phiPair.first;
+      auto iterationPHI = phiPair.second;
+      for (auto i = 0u; i < phiClone->getNumIncomingValues(); i++) {
+        auto incomingBB = phiClone->getIncomingBlock(i);
+        auto incomingValue = phiClone->getIncomingValue(i);
+
+        /*
+         * Check if the value comes from another PHI of the variable.
+         */
+        auto incomingPHI = dyn_cast<PHINode>(incomingValue);
+        if ((incomingPHI != nullptr) && (iterationOfPHIs.count(incomingPHI))) {
+          iterationPHI->addIncoming(iterationOfPHIs[incomingPHI], incomingBB);
+          continue;
+        }
+
+        /*
+         * Check if the value is the one before the loop.
+         */
+        if (incomingBB == preheaderClone) {
+          iterationPHI->addIncoming(noIteration, incomingBB);
+          continue;
+        }
+
+        /*
+         * The value has been assigned by the current iteration.
+         */
+        IRBuilder<> incomingBuilder(incomingBB->getTerminator());
+        auto iteration =
+            this->generateCodeToComputeIteration(LDI, task, incomingBuilder);
+        iterationPHI->addIncoming(iteration, incomingBB);
+      }
+    }
+
+    /*
+     * Store the last assignment of the task instance when it leaves the loop.
+     */
+    auto iterationOfHeaderPHI = iterationOfPHIs.at(headerPHIClone);
+    for (auto i = 0; i < task->getNumberOfLastBlocks(); i++) {
+      auto bb = task->getLastBlock(i);
+      auto valueToStore =
+          this->fetchValueOfHeaderPHIWhenLeavingTask(headerPHIClone, bb);
+      auto iterationToStore =
+          this->fetchValueOfHeaderPHIWhenLeavingTask(iterationOfHeaderPHI, bb);
+      IRBuilder<> exitBuilder(bb->getTerminator());
+      exitBuilder.CreateStore(valueToStore, valueSlot);
+      exitBuilder.CreateStore(iterationToStore, iterationSlot);
+    }
+  }
+
+  return;
+}
+
+void DOALL::mergeLastPrivateVariables(LoopContent *LDI, IRBuilder<> &builder) {
+
+  /*
+   * Fetch the managers.
+   */
+  auto tm = this->n.getTypesManager();
+  auto cm = this->n.getConstantsManager();
+  auto int64 = tm->getIntegerType(64);
+  auto zero = cm->getIntegerConstant(0, 64);
+
+  /*
+   * Select the value assigned by the latest iteration among all task
+   * instances.
+   */
+  auto loopPreHeader = LDI->getLoopStructure()->getPreHeader();
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto maxCores = ltm->getMaximumNumberOfCores();
+  for (auto &variable : this->lastPrivateVariables) {
+    auto type = variable.headerPHI->getType();
+    auto valuesType = variable.values->getAllocatedType();
+    auto iterationsType = variable.iterations->getAllocatedType();
+    Value *latestValue = nullptr;
+    Value *latestIteration = nullptr;
+    for (auto i = 0u; i < maxCores; i++) {
+      auto index = cm->getIntegerConstant(i, 64);
+      auto value = builder.CreateLoad(
+          type,
+          builder.CreateInBoundsGEP(valuesType,
+                                    variable.values,
+                                    { zero, index }));
+      auto iteration = builder.CreateLoad(
+          int64,
+          builder.CreateInBoundsGEP(iterationsType,
+                                    variable.iterations,
+                                    { zero, index }));
+      if (i == 0) {
+        latestValue = value;
+        latestIteration = iteration;
+        continue;
+      }
+      auto isLater = builder.CreateICmpSGT(iteration, latestIteration);
+      latestValue = builder.CreateSelect(isLater, value, latestValue);
+      latestIteration =
+          builder.CreateSelect(isLater, iteration, latestIteration);
+    }
+
+    /*
+     * If no iteration assigned the variable, then it keeps the value it had
+     * before the loop.
+     */
+    auto initialValue =
+        variable.headerPHI->getIncomingValueForBlock(loopPreHeader);
+    auto hasBeenAssigned = builder.CreateICmpSGE(latestIteration, zero);
+    auto envVar = this->envBuilder->getEnvironmentVariable(variable.envID);
+    builder.CreateStore(
+        builder.CreateSelect(hasBeenAssigned, latestValue, initialValue),
+        envVar);
+  }
+
+  return;
+}
+
+Value *DOALL::fetchValueOfHeaderPHIWhenLeavingTask(PHINode *headerPHIClone,
+                                                   BasicBlock *bb) {
+
+  /*
+   * Check if the task can leave the loop from a latch.
+   * In this case, the value to use is the one that would have reached the
+   * header.
+   */
+  auto isLeftFromALatch = false;
+  for (auto predBB : predecessors(bb)) {
+    if (headerPHIClone->getBasicBlockIndex(predBB) >= 0) {
+      isLeftFromALatch = true;
+      break;
+    }
+  }
+  if (!isLeftFromALatch) {
+    return headerPHIClone;
+  }
+
+  /*
+   * Merge the values of the predecessors.
+   */
+  IRBuilder<> phiBuilder(bb, bb->begin());
+  auto phi = phiBuilder.CreatePHI(headerPHIClone->getType(), 2);
+  for (auto predBB : predecessors(bb)) {
+    auto index = headerPHIClone->getBasicBlockIndex(predBB);
+    if (index >= 0) {
+      phi->addIncoming(headerPHIClone->getIncomingValue(index), predBB);
+    } else {
+      phi->addIncoming(headerPHIClone, predBB);
+    }
+  }
+
+  return phi;
+}
+
+} // namespace arcana::gino
@@ -48,18 +48,34 @@ void DOALL::invokeParallelizedLoop(LoopContent *LDI) {
 
   /*
    * Fetch the chunk size.
+   * Chunks are rounded to cover whole cache lines and vector registers of the
+   * data written by the loop.
    */
-  auto chunkSize = cm->getIntegerConstant(ltm->getChunkSize(), 64);
+  auto chunkSizeValue = this->getChunkSizeAlignedToTheWrittenData(LDI);
+
+  /*
+   * Blocks of iterations of deterministic reductions must not be split
+   * between task instances.
+   */
+  if (this->deterministicReductions.size() > 0) {
+    auto blockSize = this->getIterationsPerDeterministicReductionBlock();
+    chunkSizeValue = ((chunkSizeValue + blockSize - 1) / blockSize) * blockSize;
+  }
+  auto chunkSize = cm->getIntegerConstant(chunkSizeValue, 64);
 
   /*
    * Call the dispatcher that will dispatch the tasks that execute the
    * parallelized loop.
    */
   IRBuilder<> doallBuilder(this->entryPointOfParallelizedLoop);
+  std::vector<Value *> dispatcherArgs{ tasks[0]->getTaskBody(),
+                                       envPtr,
+                                       numCores,
+                                       chunkSize };
+  this->appendDispatcherArguments(LDI, doallBuilder, dispatcherArgs);
   auto doallCallInst = doallBuilder.CreateCall(
       this->taskDispatcher,
-      ArrayRef<Value *>(
-          { tasks[0]->getTaskBody(), envPtr, numCores, chunkSize }));
+      ArrayRef<Value *>(dispatcherArgs));
 
   /*
    * Get the return value of the dispatcher, which has the information about how
@@ -68,6 +84,11 @@ void DOALL::invokeParallelizedLoop(LoopContent *LDI) {
   auto numThreadsUsed =
       doallBuilder.CreateExtractValue(doallCallInst, (uint64_t)0);
 
+  /*
+   * Merge the results of the tasks that cannot be merged by reductions.
+   */
+  this->generateCodeToMergeTaskResults(LDI, doallBuilder);
+
   /*
    * Propagate the live-out variables computed within tasks to the code outside
    * the parallelized loop.
@@ -83,4 +104,33 @@ void DOALL::invokeParallelizedLoop(LoopContent *LDI) {
   afterDOALLBuilder.CreateBr(this->exitPointOfParallelizedLoop);
 }
 
+void DOALL::appendDispatcherArguments(LoopContent *LDI,
+                                      IRBuilder<> &builder,
+                                      std::vector<Value *> &arguments) {
+
+  /*
+   * The default dispatcher only needs the task, the environment, the number
+   * of cores, and the chunk size.
+   */
+  return;
+}
+
+void DOALL::generateCodeToMergeTaskResults(LoopContent *LDI,
+                                           IRBuilder<> &builder) {
+
+  /*
+   * Live-out variables are either reduced or stored by the task that executes
+   * the last iteration.
+   * What is left to merge are the last-private variables, the composite
+   * reductions, the floating-point sums computed in blocks, and the private
+   * copies of the arrays updated by reductions.
+   */
+  this->mergeLastPrivateVariables(LDI, builder);
+  this->mergeCompositeReductions(LDI, builder);
+  this->combineDeterministicReductions(LDI, builder);
+  this->combineArrayReductions(LDI, builder);
+
+  return;
+}
+
 } // namespace arcana::gino
@@ -65,7 +65,8 @@ bool DOALL::apply(LoopContent *LDI, Heuristics *h) {
   if (this->verbose != Verbosity::Disabled) {
     errs() << "DOALL: Start the parallelization\n";
     errs() << "DOALL:   Number of threads to extract = " << maxCores << "\n";
-    errs() << "DOALL:   Chunk size = " << ltm->getChunkSize() << "\n";
+    errs() << "DOALL:   Chunk size = "
+           << this->getChunkSizeAlignedToTheWrittenData(LDI) << "\n";
   }
 
   /*
@@ -95,8 +96,9 @@ bool DOALL::apply(LoopContent *LDI, Heuristics *h) {
     errs() << "DOALL:   Reduced variables:\n";
   }
   auto sccManager = LDI->getSCCManager();
-  auto isReducible =
-      [this, loopEnvironment, sccManager](uint32_t id, bool isLiveOut) -> bool {
+  auto isReducible = [this, LDI, loopEnvironment, sccManager](
+                         uint32_t id,
+                         bool isLiveOut) -> bool {
     if (!isLiveOut) {
       return false;
     }
@@ -104,6 +106,32 @@ bool DOALL::apply(LoopContent *LDI, Heuristics *h) {
     /*
      * We have a live-out variable.
      *
+     * Check if this is a last-private variable.
+     * These are not reducable because the value assigned by the latest
+     * iteration is selected after the parallelized loop.
+     */
+    if (this->getPHIsOfLastPrivateVariable(LDI, id).size() > 0) {
+      return false;
+    }
+
+    /*
+     * Check if this is produced by a composite reduction.
+     * These are merged after the parallelized loop by the code generated for
+     * them.
+     */
+    if (this->isProducedByCompositeReduction(LDI, id)) {
+      return false;
+    }
+
+    /*
+     * Check if this is a floating-point sum computed in blocks.
+     * These are combined in a fixed order after the parallelized loop.
+     */
+    if (this->isProducedByDeterministicReduction(LDI, id)) {
+      return false;
+    }
+
+    /*
      * Check if this is an IV.
      * IVs are not reducable because they get re-computed locally by each
      * thread.
@@ -218,6 +246,47 @@ bool DOALL::apply(LoopContent *LDI, Heuristics *h) {
     errs() << "\n";
   }
 
+  /*
+   * Replace the divisions of the loop-governing IV (e.g., the ones that
+   * recover the IVs of a collapsed loop nest) with per-chunk updates.
+   */
+  this->strengthReduceDivisionsOfTheLoopGoverningIV(LDI, doallTask);
+
+  /*
+   * Let every task instance update its own copy of the arrays updated by
+   * reductions.
+   */
+  this->privatizeArrayReductions(LDI, doallTask);
+
+  /*
+   * Perform the updates of memory locations shared between iterations
+   * atomically.
+   */
+  this->lowerSharedUpdates(LDI, doallTask);
+
+  /*
+   * Record the last value assigned to last-private variables by every task
+   * instance.
+   */
+  this->generateCodeToTrackLastPrivateVariables(LDI, doallTask);
+
+  /*
+   * Record the partial results of the composite reductions computed by every
+   * task instance.
+   */
+  this->generateCodeToTrackCompositeReductions(LDI, doallTask);
+
+  /*
+   * Compute the floating-point sums over blocks of iterations that do not
+   * depend on the number of task instances.
+   */
+  this->generateCodeToComputeReductionsInBlocks(LDI, doallTask);
+
+  /*
+   * Let the compiler know about the alignment of the data written by the loop.
+   */
+  this->assumeAlignmentOfTheWrittenData(LDI, doallTask);
+
   /*
    * Store final results to loop live-out variables. Note this occurs after
    * all other code is generated. Propagated PHIs through the generated
@@ -228,6 +297,12 @@ bool DOALL::apply(LoopContent *LDI, Heuristics *h) {
     errs() << "DOALL:  Stored live outs\n";
   }
 
+  /*
+   * Let the compiler know which memory the task can access through its
+   * live-in pointers.
+   */
+  this->propagateAliasInformationToTask(LDI, 0);
+
   /*
    * Add code to invoke the parallelized loop.
    */
@@ -242,6 +317,16 @@ bool DOALL::apply(LoopContent *LDI, Heuristics *h) {
     this->makePRVGsReentrant();
   }
 
+  /*
+   * Use the thread-caching allocator for the memory allocated by the task.
+   */
+  if (this->useThreadCachingAllocator) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "DOALL:  Use the thread-caching allocator\n";
+    }
+    this->substituteMemoryAllocators();
+  }
+
   /*
    * Final printing.
    */
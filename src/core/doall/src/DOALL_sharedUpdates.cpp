@@ -0,0 +1,479 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/noelle/core/LoopCarriedSCC.hpp"
+#include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+
+namespace arcana::gino {
+
+/*
+ * Extra cycles of an atomic update compared to a plain one.
+ */
+static const uint64_t extraCyclesPerAtomicUpdate = 20;
+
+/*
+ * Cycles to zero-initialize and to combine an element of a private copy of an
+ * array updated by reductions.
+ */
+static const uint64_t cyclesPerPrivateElement = 2;
+
+/*
+ * Return the atomic operator that performs the update given as input, which
+ * uses @load to read the element being updated.
+ * @needsLock is set when the update cannot be performed by a native atomic
+ * instruction.
+ */
+static bool getAtomicOperator(Instruction *update,
+                              LoadInst *load,
+                              AtomicRMWInst::BinOp &atomicOperator,
+                              bool &needsLock) {
+  atomicOperator = AtomicRMWInst::BAD_BINOP;
+  needsLock = false;
+
+  /*
+   * Check the element being updated is one operand of the update.
+   */
+  if (update->getNumOperands() < 2) {
+    return false;
+  }
+  auto isLoadFirst = (update->getOperand(0) == load);
+  auto isLoadSecond = (update->getOperand(1) == load);
+  if (isLoadFirst == isLoadSecond) {
+    return false;
+  }
+
+  /*
+   * Minimum and maximum.
+   */
+  if (auto intrinsic = dyn_cast<IntrinsicInst>(update)) {
+    switch (intrinsic->getIntrinsicID()) {
+      case Intrinsic::smin:
+        atomicOperator = AtomicRMWInst::Min;
+        break;
+      case Intrinsic::smax:
+        atomicOperator = AtomicRMWInst::Max;
+        break;
+      case Intrinsic::umin:
+        atomicOperator = AtomicRMWInst::UMin;
+        break;
+      case Intrinsic::umax:
+        atomicOperator = AtomicRMWInst::UMax;
+        break;
+      default:
+        return false;
+    }
+  } else if (auto binOp = dyn_cast<BinaryOperator>(update)) {
+
+    /*
+     * Associative and commutative operators.
+     */
+    switch (binOp->getOpcode()) {
+      case Instruction::Add:
+        atomicOperator = AtomicRMWInst::Add;
+        break;
+      case Instruction::Sub:
+        if (!isLoadFirst) {
+          return false;
+        }
+        atomicOperator = AtomicRMWInst::Sub;
+        break;
+      case Instruction::Or:
+        atomicOperator = AtomicRMWInst::Or;
+        break;
+      case Instruction::And:
+        atomicOperator = AtomicRMWInst::And;
+        break;
+      case Instruction::Xor:
+        atomicOperator = AtomicRMWInst::Xor;
+        break;
+      case Instruction::Mul:
+        needsLock = true;
+        break;
+      case Instruction::FAdd:
+        if (!binOp->hasAllowReassoc()) {
+          return false;
+        }
+        atomicOperator = AtomicRMWInst::FAdd;
+        break;
+      case Instruction::FSub:
+        if (!isLoadFirst || !binOp->hasAllowReassoc()) {
+          return false;
+        }
+        atomicOperator = AtomicRMWInst::FSub;
+        break;
+      case Instruction::FMul:
+        if (!binOp->hasAllowReassoc()) {
+          return false;
+        }
+        needsLock = true;
+        break;
+      default:
+        return false;
+    }
+  } else {
+    return false;
+  }
+
+  /*
+   * Native atomic instructions only support integers of power-of-two bytes
+   * and floats of the hardware.
+   */
+  auto type = load->getType();
+  if (auto intType = dyn_cast<IntegerType>(type)) {
+    auto bits = intType->getBitWidth();
+    if ((bits < 8) || (bits > 64) || ((bits & (bits - 1)) != 0)) {
+      needsLock = true;
+    }
+  } else if (!type->isFloatTy() && !type->isDoubleTy()) {
+    needsLock = true;
+  }
+  if (needsLock) {
+    atomicOperator = AtomicRMWInst::BAD_BINOP;
+  }
+
+  return true;
+}
+
+/*
+ * Check if the updates given as input can be reordered between iterations,
+ * which requires them to be performed in the same way.
+ */
+static bool canBeReorderedWith(const SharedUpdate &u1, const SharedUpdate &u2) {
+  if ((u1.load->getType() != u2.load->getType())
+      || (u1.needsLock != u2.needsLock)) {
+    return false;
+  }
+
+  /*
+   * Atomic additions and subtractions can be reordered.
+   */
+  if (!u1.needsLock) {
+    auto normalize = [](AtomicRMWInst::BinOp op) -> AtomicRMWInst::BinOp {
+      if (op == AtomicRMWInst::Sub) {
+        return AtomicRMWInst::Add;
+      }
+      if (op == AtomicRMWInst::FSub) {
+        return AtomicRMWInst::FAdd;
+      }
+      return op;
+    };
+    return normalize(u1.atomicOperator) == normalize(u2.atomicOperator);
+  }
+
+  /*
+   * Updates protected by locks must use the same operator.
+   */
+  if (u1.update->getOpcode() != u2.update->getOpcode()) {
+    return false;
+  }
+  auto intrinsic1 = dyn_cast<IntrinsicInst>(u1.update);
+  auto intrinsic2 = dyn_cast<IntrinsicInst>(u2.update);
+  if ((intrinsic1 != nullptr) && (intrinsic2 != nullptr)) {
+    return intrinsic1->getIntrinsicID() == intrinsic2->getIntrinsicID();
+  }
+
+  return true;
+}
+
+std::vector<SharedUpdate> DOALL::getSharedUpdates(LoopContent *LDI) const {
+  std::vector<SharedUpdate> updates;
+  if (!this->useAtomicUpdates) {
+    return updates;
+  }
+
+  /*
+   * Calls could access the shared elements without going through their
+   * updates.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  for (auto inst : loopStructure->getInstructions()) {
+    if (isa<CallBase>(inst) && inst->mayReadOrWriteMemory()) {
+      return updates;
+    }
+  }
+
+  /*
+   * Collect the updates of memory locations.
+   * An update loads an element, combines it with a value through an
+   * associative and commutative operator, and stores the result back to the
+   * same element without writing memory in between.
+   */
+  auto program = this->n.getProgram();
+  auto areLocksAvailable =
+      (program->getFunction("NOELLE_lockStripe") != nullptr)
+      && (program->getFunction("NOELLE_unlockStripe") != nullptr);
+  std::vector<SharedUpdate> candidates;
+  for (auto inst : loopStructure->getInstructions()) {
+    auto storeInst = dyn_cast<StoreInst>(inst);
+    if ((storeInst == nullptr) || !storeInst->isSimple()) {
+      continue;
+    }
+    auto update = dyn_cast<Instruction>(storeInst->getValueOperand());
+    if ((update == nullptr) || !update->hasOneUse()
+        || (update->getParent() != storeInst->getParent())) {
+      continue;
+    }
+    LoadInst *loadInst = nullptr;
+    for (auto &op : update->operands()) {
+      auto opLoad = dyn_cast<LoadInst>(op.get());
+      if ((opLoad != nullptr)
+          && (opLoad->getPointerOperand() == storeInst->getPointerOperand())) {
+        loadInst = opLoad;
+        break;
+      }
+    }
+    if ((loadInst == nullptr) || !loadInst->isSimple()
+        || !loadInst->hasOneUse()
+        || (loadInst->getParent() != storeInst->getParent())) {
+      continue;
+    }
+    auto writesInBetween = false;
+    for (auto i = loadInst->getNextNode(); i != storeInst;
+         i = i->getNextNode()) {
+      writesInBetween |= i->mayWriteToMemory();
+    }
+    if (writesInBetween) {
+      continue;
+    }
+    SharedUpdate candidate;
+    candidate.load = loadInst;
+    candidate.update = update;
+    candidate.store = storeInst;
+    if (!getAtomicOperator(update,
+                           loadInst,
+                           candidate.atomicOperator,
+                           candidate.needsLock)) {
+      continue;
+    }
+    if (candidate.needsLock && !areLocksAvailable) {
+      continue;
+    }
+    candidates.push_back(candidate);
+  }
+
+  /*
+   * Keep the updates that block DOALL.
+   * The other ones are performed on disjoint elements between iterations.
+   */
+  auto sccManager = LDI->getSCCManager();
+  auto blockingSCCs = DOALL::getSCCsThatBlockDOALLToBeApplicable(LDI, this->n);
+  std::set<Instruction *> accessesToKeep;
+  for (auto scc : blockingSCCs) {
+    auto sccInfo = dyn_cast<LoopCarriedSCC>(sccManager->getSCCAttrs(scc));
+    if ((sccInfo == nullptr)
+        || !DOALL::isDueToSharedUpdates(sccInfo, candidates)) {
+      continue;
+    }
+    for (auto dep : sccInfo->getLoopCarriedDependences()) {
+      if (auto inst = dyn_cast<Instruction>(dep->getSrc())) {
+        accessesToKeep.insert(inst);
+      }
+      if (auto inst = dyn_cast<Instruction>(dep->getDst())) {
+        accessesToKeep.insert(inst);
+      }
+    }
+  }
+  for (auto &candidate : candidates) {
+    if (accessesToKeep.count(candidate.load)
+        || accessesToKeep.count(candidate.store)) {
+      updates.push_back(candidate);
+    }
+  }
+
+  return updates;
+}
+
+bool DOALL::isDueToSharedUpdates(LoopCarriedSCC *sccInfo,
+                                 const std::vector<SharedUpdate> &updates) {
+  if (updates.size() == 0) {
+    return false;
+  }
+
+  /*
+   * Map the memory accesses of the updates to their updates.
+   */
+  std::unordered_map<Instruction *, const SharedUpdate *> accesses;
+  for (auto &update : updates) {
+    accesses[update.load] = &update;
+    accesses[update.store] = &update;
+  }
+
+  /*
+   * Check if all loop-carried data dependences of the SCC are between
+   * updates that can be reordered.
+   */
+  for (auto dep : sccInfo->getLoopCarriedDependences()) {
+    if (isa<ControlDependence<Value, Value>>(dep)) {
+      continue;
+    }
+    auto fromInst = dyn_cast<Instruction>(dep->getSrc());
+    auto toInst = dyn_cast<Instruction>(dep->getDst());
+    if (!isa<MemoryDependence<Value, Value>>(dep) || (fromInst == nullptr)
+        || (toInst == nullptr) || (accesses.count(fromInst) == 0)
+        || (accesses.count(toInst) == 0)) {
+      return false;
+    }
+    if (!canBeReorderedWith(*accesses[fromInst], *accesses[toInst])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool DOALL::isCheaperToUpdateAtomically(
+    LoopContent *LDI,
+    const ArrayReduction &reduction,
+    const std::vector<SharedUpdate> &updates) const {
+  if (updates.size() == 0) {
+    return false;
+  }
+
+  /*
+   * Check all updates of the array can be performed atomically.
+   */
+  std::set<Instruction *> atomicAccesses;
+  for (auto &update : updates) {
+    atomicAccesses.insert(update.load);
+    atomicAccesses.insert(update.store);
+  }
+  for (auto access : reduction.accesses) {
+    if (atomicAccesses.count(access) == 0) {
+      return false;
+    }
+  }
+
+  /*
+   * Without profiles, we keep privatizing the array.
+   */
+  auto profiles = this->n.getProfiles();
+  auto loopStructure = LDI->getLoopStructure();
+  if (!profiles->isAvailable()) {
+    return false;
+  }
+
+  /*
+   * Compare the extra cost of the atomic updates with the cost of
+   * initializing and combining the private copies of the array.
+   */
+  auto &DL = loopStructure->getFunction()->getParent()->getDataLayout();
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto maxCores = ltm->getMaximumNumberOfCores();
+  auto iterations =
+      profiles->getAverageLoopIterationsPerInvocation(loopStructure);
+  auto updatesPerIteration = reduction.accesses.size() / 2;
+  auto atomicCost = iterations * updatesPerIteration
+                    * extraCyclesPerAtomicUpdate;
+  auto elements = reduction.size / DL.getTypeAllocSize(reduction.elementType);
+  auto privatizationCost = elements * maxCores * cyclesPerPrivateElement;
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:     Array " << *reduction.object << ": atomic updates "
+           << atomicCost << " cycles, private copies " << privatizationCost
+           << " cycles\n";
+  }
+
+  return atomicCost < privatizationCost;
+}
+
+void DOALL::lowerSharedUpdates(LoopContent *LDI, DOALLTask *task) {
+
+  /*
+   * Fetch the updates that are not redirected to private copies of arrays.
+   */
+  std::set<Instruction *> privatizedAccesses;
+  for (auto &reduction : this->arrayReductions) {
+    privatizedAccesses.insert(reduction.accesses.begin(),
+                              reduction.accesses.end());
+  }
+  this->sharedUpdates.clear();
+  for (auto &update : this->getSharedUpdates(LDI)) {
+    if (privatizedAccesses.count(update.store) == 0) {
+      this->sharedUpdates.push_back(update);
+    }
+  }
+  if (this->sharedUpdates.size() == 0) {
+    return;
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Shared updates:\n";
+    for (auto &update : this->sharedUpdates) {
+      errs() << "DOALL:     " << *update.store
+             << (update.needsLock ? " (striped lock)\n" : " (atomic)\n");
+    }
+  }
+
+  /*
+   * Fetch the runtime functions that protect the updates without native
+   * atomic instructions.
+   */
+  auto program = this->n.getProgram();
+  auto lockFunction = program->getFunction("NOELLE_lockStripe");
+  auto unlockFunction = program->getFunction("NOELLE_unlockStripe");
+  auto tm = this->n.getTypesManager();
+  auto voidPtrType = tm->getVoidPointerType();
+
+  for (auto &update : this->sharedUpdates) {
+    auto loadInTask =
+        cast<LoadInst>(task->getCloneOfOriginalInstruction(update.load));
+    auto updateInTask = task->getCloneOfOriginalInstruction(update.update);
+    auto storeInTask =
+        cast<StoreInst>(task->getCloneOfOriginalInstruction(update.store));
+    auto ptr = storeInTask->getPointerOperand();
+
+    /*
+     * Hold the lock of the element while updating it.
+     */
+    if (update.needsLock) {
+      IRBuilder<> lockBuilder(loadInTask);
+      lockBuilder.CreateCall(lockFunction,
+                             { lockBuilder.CreatePointerCast(ptr,
+                                                             voidPtrType) });
+      IRBuilder<> unlockBuilder(storeInTask->getNextNode());
+      unlockBuilder.CreateCall(
+          unlockFunction,
+          { unlockBuilder.CreatePointerCast(ptr, voidPtrType) });
+      continue;
+    }
+
+    /*
+     * Replace the update with an atomic one.
+     * No ordering is needed because the updated elements are read only after
+     * all task instances completed.
+     */
+    auto operand = (updateInTask->getOperand(0) == loadInTask)
+                       ? updateInTask->getOperand(1)
+                       : updateInTask->getOperand(0);
+    IRBuilder<> builder(storeInTask);
+    builder.CreateAtomicRMW(update.atomicOperator,
+                            ptr,
+                            operand,
+                            storeInTask->getAlign(),
+                            AtomicOrdering::Monotonic);
+    storeInTask->eraseFromParent();
+    updateInTask->eraseFromParent();
+    loadInTask->eraseFromParent();
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+
+namespace arcana::gino {
+
+void DOALL::strengthReduceDivisionsOfTheLoopGoverningIV(LoopContent *LDI,
+                                                        DOALLTask *task) {
+
+  /*
+   * The quotient and the remainder can be updated incrementally only while
+   * the iterations of a chunk are executed.
+   * Hence, we need to know when a new chunk starts.
+   */
+  if (this->chunkCounter == nullptr) {
+    return;
+  }
+
+  /*
+   * Fetch the loop-governing IV, which must be incremented by one.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  if (loopGoverningIVAttr == nullptr) {
+    return;
+  }
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto step = dyn_cast_or_null<ConstantInt>(
+      loopGoverningIV->getSingleComputedStepValue());
+  if ((step == nullptr) || !step->isOne()) {
+    return;
+  }
+  auto ivPHI = cast<PHINode>(
+      this->fetchCloneInTask(task, loopGoverningIV->getLoopEntryPHI()));
+
+  /*
+   * Collect the divisions of the IV by values that do not change within the
+   * loop (e.g., the ones that recover the IVs of a collapsed loop nest).
+   * Divisions by constants are left to the backend.
+   */
+  std::unordered_set<BasicBlock *> loopBBs;
+  for (auto bb : loopStructure->getBasicBlocks()) {
+    loopBBs.insert(task->getCloneOfOriginalBasicBlock(bb));
+  }
+  std::map<Value *, std::vector<BinaryOperator *>> divisionsByDivisor;
+  for (auto user : ivPHI->users()) {
+    auto division = dyn_cast<BinaryOperator>(user);
+    if ((division == nullptr) || (division->getOperand(0) != ivPHI)
+        || !loopBBs.count(division->getParent())) {
+      continue;
+    }
+    if ((division->getOpcode() != Instruction::UDiv)
+        && (division->getOpcode() != Instruction::URem)) {
+      continue;
+    }
+    auto divisor = division->getOperand(1);
+    if (isa<Constant>(divisor)) {
+      continue;
+    }
+    if (auto divisorInst = dyn_cast<Instruction>(divisor)) {
+      if (loopBBs.count(divisorInst->getParent())) {
+        continue;
+      }
+    }
+    divisionsByDivisor[divisor].push_back(division);
+  }
+  if (divisionsByDivisor.size() == 0) {
+    return;
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Strength reduce the divisions of the loop-governing IV "
+           << "by " << divisionsByDivisor.size() << " values\n";
+  }
+
+  /*
+   * Fetch the blocks of the task we need.
+   */
+  auto loopHeader = loopStructure->getHeader();
+  auto loopPreHeader = loopStructure->getPreHeader();
+  auto headerClone = task->getCloneOfOriginalBasicBlock(loopHeader);
+  auto preheaderClone = task->getCloneOfOriginalBasicBlock(loopPreHeader);
+  auto ivType = ivPHI->getType();
+  auto zero = ConstantInt::get(ivType, 0);
+  auto one = ConstantInt::get(ivType, 1);
+
+  /*
+   * Check whether the current iteration is the first one of a chunk.
+   */
+  IRBuilder<> headerBuilder(headerClone->getFirstNonPHI());
+  auto isFirstIterationOfChunk = headerBuilder.CreateICmpEQ(
+      this->chunkCounter,
+      ConstantInt::get(this->chunkCounter->getType(), 0));
+
+  for (auto &pair : divisionsByDivisor) {
+    auto divisor = pair.first;
+
+    /*
+     * Compute the quotient and the remainder with a division only at the
+     * beginning of a chunk.
+     * The other iterations of the chunk update them from the previous ones.
+     */
+    auto quotientPHI =
+        PHINode::Create(ivType, 2, "quotient", &*headerClone->begin());
+    auto remainderPHI =
+        PHINode::Create(ivType, 2, "remainder", &*headerClone->begin());
+    auto quotient =
+        headerBuilder.CreateSelect(isFirstIterationOfChunk,
+                                   headerBuilder.CreateUDiv(ivPHI, divisor),
+                                   quotientPHI);
+    auto remainder =
+        headerBuilder.CreateSelect(isFirstIterationOfChunk,
+                                   headerBuilder.CreateURem(ivPHI, divisor),
+                                   remainderPHI);
+
+    /*
+     * Update the quotient and the remainder for the next iteration.
+     */
+    for (auto i = 0u; i < ivPHI->getNumIncomingValues(); i++) {
+      auto incomingBB = ivPHI->getIncomingBlock(i);
+      if (incomingBB == preheaderClone) {
+        quotientPHI->addIncoming(zero, incomingBB);
+        remainderPHI->addIncoming(zero, incomingBB);
+        continue;
+      }
+      IRBuilder<> latchBuilder(incomingBB->getTerminator());
+      auto nextRemainder = latchBuilder.CreateAdd(remainder, one);
+      auto wraps = latchBuilder.CreateICmpEQ(nextRemainder, divisor);
+      auto carry = latchBuilder.CreateZExt(wraps, ivType);
+      auto nextQuotient = latchBuilder.CreateAdd(quotient, carry);
+      nextRemainder = latchBuilder.CreateSelect(wraps, zero, nextRemainder);
+      quotientPHI->addIncoming(nextQuotient, incomingBB);
+      remainderPHI->addIncoming(nextRemainder, incomingBB);
+    }
+
+    /*
+     * Replace the divisions.
+     */
+    for (auto division : pair.second) {
+      if (division->getOpcode() == Instruction::UDiv) {
+        division->replaceAllUsesWith(quotient);
+      } else {
+        division->replaceAllUsesWith(remainder);
+      }
+      division->eraseFromParent();
+    }
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -0,0 +1,435 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/noelle/core/LoopIterationSCC.hpp"
+#include "arcana/noelle/core/PeriodicVariableSCC.hpp"
+#include "arcana/noelle/core/ReductionSCC.hpp"
+#include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLTask.hpp"
+#include "llvm/IR/IRBuilder.h"
+
+namespace arcana::gino {
+
+/*
+ * Return the predicate that, applied to the loop governing IV and the exit
+ * condition value, keeps the loop iterating.
+ */
+static CmpInst::Predicate getPredicateToKeepIterating(LoopContent *LDI) {
+  auto loopStructure = LDI->getLoopStructure();
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  auto cmpInst =
+      loopGoverningIVAttr->getHeaderCompareInstructionToComputeExitCondition();
+  auto brInst = loopGoverningIVAttr->getHeaderBrInst();
+
+  auto predicate = cmpInst->getPredicate();
+  if (!loopStructure->isIncluded(brInst->getSuccessor(0))) {
+    predicate = cmpInst->getInversePredicate();
+  }
+
+  return predicate;
+}
+
+bool DOALL::canIterateTwoLevelChunks(LoopContent *LDI) const {
+
+  /*
+   * Fetch loop and IV information.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopHeader = loopStructure->getHeader();
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto invariantManager = LDI->getInvariantManager();
+  auto sccManager = LDI->getSCCManager();
+  auto sccdag = sccManager->getSCCDAG();
+
+  /*
+   * The loop must have a single latch and a single exit, which is taken from
+   * the header.
+   */
+  if (loopStructure->getLatches().size() != 1) {
+    return false;
+  }
+  auto exitEdges = loopStructure->getLoopExitEdges();
+  if (exitEdges.size() != 1) {
+    return false;
+  }
+  if (exitEdges.begin()->first != loopHeader) {
+    return false;
+  }
+
+  /*
+   * The loop governing IV must be an integer with a constant step, and it must
+   * be compared against the exit condition value before executing the body.
+   */
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  if (loopGoverningIVAttr == nullptr) {
+    return false;
+  }
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto loopGoverningPHI = loopGoverningIV->getLoopEntryPHI();
+  auto loopGoverningIVType = loopGoverningPHI->getType();
+  if (!loopGoverningIVType->isIntegerTy()
+      || (loopGoverningIVType->getIntegerBitWidth() > 64)) {
+    return false;
+  }
+  auto stepValue = dyn_cast_or_null<ConstantInt>(
+      loopGoverningIV->getSingleComputedStepValue());
+  if ((stepValue == nullptr) || stepValue->isZero()) {
+    return false;
+  }
+  if (loopGoverningIVAttr->getValueToCompareAgainstExitConditionValue()
+      != loopGoverningPHI) {
+    return false;
+  }
+  auto cmpInst =
+      loopGoverningIVAttr->getHeaderCompareInstructionToComputeExitCondition();
+  if ((cmpInst->getOperand(0) != loopGoverningPHI)
+      || (cmpInst->getOperand(1)
+          != loopGoverningIVAttr->getExitConditionValue())) {
+    return false;
+  }
+
+  /*
+   * The predicate that keeps the loop iterating must match the direction of
+   * the IV.
+   */
+  switch (getPredicateToKeepIterating(LDI)) {
+    case CmpInst::ICMP_NE:
+      break;
+    case CmpInst::ICMP_SLT:
+    case CmpInst::ICMP_SLE:
+    case CmpInst::ICMP_ULT:
+    case CmpInst::ICMP_ULE:
+      if (stepValue->isNegative()) {
+        return false;
+      }
+      break;
+    case CmpInst::ICMP_SGT:
+    case CmpInst::ICMP_SGE:
+    case CmpInst::ICMP_UGT:
+    case CmpInst::ICMP_UGE:
+      if (!stepValue->isNegative()) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+  }
+
+  /*
+   * Periodic variables are rewired by following the per-iteration chunk
+   * selection.
+   */
+  for (auto scc : sccdag->getSCCs()) {
+    auto sccInfo = sccManager->getSCCAttrs(scc);
+    if (isa<PeriodicVariableSCC>(sccInfo)) {
+      return false;
+    }
+  }
+
+  /*
+   * The header must only include instructions that can run once more than the
+   * iterations of a chunk:
+   * 1) IV instructions, including the comparison and branch of the loop
+   *    governing IV
+   * 2) PHIs of reducible variables whose accumulation is outside the header
+   * 3) Loop invariant instructions that belong to independent-execution SCCs
+   */
+  std::unordered_set<Instruction *> repeatableInstructions;
+  for (auto ivInfo : allIVInfo->getInductionVariables(*loopStructure)) {
+    for (auto I : ivInfo->getAllInstructions()) {
+      repeatableInstructions.insert(I);
+    }
+  }
+  repeatableInstructions.insert(cmpInst);
+  repeatableInstructions.insert(loopGoverningIVAttr->getHeaderBrInst());
+  for (auto sccInfo : sccManager->getSCCsWithLoopCarriedDataDependencies()) {
+    auto reductionSCC = dyn_cast<ReductionSCC>(sccInfo);
+    if (reductionSCC == nullptr) {
+      continue;
+    }
+    auto headerPHI =
+        reductionSCC->getPhiThatAccumulatesValuesBetweenLoopIterations();
+    if (headerPHI->getParent() != loopHeader) {
+      return false;
+    }
+    for (auto nodePair : sccInfo->getSCC()->internalNodePairs()) {
+      auto inst = cast<Instruction>(nodePair.first);
+      if ((inst != headerPHI) && (inst->getParent() == loopHeader)) {
+        return false;
+      }
+    }
+    repeatableInstructions.insert(headerPHI);
+  }
+  for (auto &I : *loopHeader) {
+    if (repeatableInstructions.find(&I) != repeatableInstructions.end()) {
+      continue;
+    }
+    auto scc = sccdag->sccOfValue(&I);
+    auto sccInfo = sccManager->getSCCAttrs(scc);
+    if (!isa<LoopIterationSCC>(sccInfo)
+        || !invariantManager->isLoopInvariant(&I)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void DOALL::rewireLoopToIterateTwoLevelChunks(LoopContent *LDI,
+                                              DOALLTask *task) {
+
+  /*
+   * Fetch loop and IV information.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopHeader = loopStructure->getHeader();
+  auto loopLatch = *loopStructure->getLatches().begin();
+  auto headerClone = task->getCloneOfOriginalBasicBlock(loopHeader);
+  auto latchClone = task->getCloneOfOriginalBasicBlock(loopLatch);
+  auto allIVInfo = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = allIVInfo->getLoopGoverningInductionVariable();
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto sccManager = LDI->getSCCManager();
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << "DOALL:   Iterate over chunks with a two-level loop\n";
+  }
+
+  /*
+   * Fetch the task.
+   */
+  auto taskFunction = task->getTaskBody();
+  auto &cxt = taskFunction->getContext();
+  auto entryBlock = task->getEntry();
+  auto lastBlock = task->getLastBlock(0);
+  auto chunkCounterType = task->chunkSizeArg->getType();
+  auto zeroValue = ConstantInt::get(chunkCounterType, 0);
+  auto onesValue = ConstantInt::get(chunkCounterType, 1);
+
+  /*
+   * Create the outer loop that iterates over the chunks of the task:
+   *
+   * entry:
+   *   compute the number of iterations of the loop
+   *   br chunk_preheader
+   *
+   * chunk_preheader:
+   *   set the IVs to the first iteration of the current chunk
+   *   br header
+   *
+   * header (inner loop over the iterations of the current chunk):
+   *   br (iteration within chunk < iterations of chunk), body, chunk_latch
+   *
+   * chunk_latch:
+   *   br (next chunk < iterations of the loop), chunk_preheader, last block
+   *
+   * The entry jumps to the header. Move the incoming values of the header PHIs
+   * to the new chunk preheader.
+   */
+  auto chunkPreheader =
+      BasicBlock::Create(cxt, "chunk_preheader", taskFunction);
+  auto chunkLatch = BasicBlock::Create(cxt, "chunk_latch", taskFunction);
+  auto jumpToLoop = cast<BranchInst>(entryBlock->getTerminator());
+  assert(jumpToLoop->getSuccessor(0) == headerClone);
+  jumpToLoop->setSuccessor(0, chunkPreheader);
+  headerClone->replacePhiUsesWith(entryBlock, chunkPreheader);
+  IRBuilder<> entryBuilder(jumpToLoop);
+  IRBuilder<> chunkPreheaderBuilder(chunkPreheader);
+  auto jumpToHeader = chunkPreheaderBuilder.CreateBr(headerClone);
+  chunkPreheaderBuilder.SetInsertPoint(jumpToHeader);
+  IRBuilder<> chunkLatchBuilder(chunkLatch);
+
+  /*
+   * Collect clones of step size deriving values for all induction variables
+   * of the parallelized loop.
+   */
+  auto clonedStepSizeMap =
+      this->cloneIVStepValueComputation(LDI, 0, entryBuilder);
+
+  /*
+   * The exit condition value does not need to be computed each iteration and so
+   * the value's derivation can be hoisted into the entry.
+   */
+  this->hoistExitConditionValueDerivation(LDI, task, entryBuilder);
+
+  /*
+   * Compute the number of iterations of the loop:
+   *    = (|exit_value - start_value| + |step| - 1) / |step|
+   *
+   * where exit_value is incremented by one step when the predicate that keeps
+   * the loop iterating is not strict.
+   */
+  auto startValue =
+      this->fetchCloneInTask(task, loopGoverningIV->getStartValue());
+  auto exitConditionValue =
+      this->fetchCloneInTask(task,
+                             loopGoverningIVAttr->getExitConditionValue());
+  assert(startValue != nullptr);
+  assert(exitConditionValue != nullptr);
+  auto stepValue =
+      cast<ConstantInt>(loopGoverningIV->getSingleComputedStepValue());
+  auto absoluteStep =
+      ConstantInt::get(chunkCounterType,
+                       stepValue->getValue().abs().getZExtValue());
+  auto predicate = getPredicateToKeepIterating(LDI);
+  auto hasIterations =
+      entryBuilder.CreateICmp(predicate, startValue, exitConditionValue);
+  auto distance =
+      stepValue->isNegative()
+          ? entryBuilder.CreateSub(startValue, exitConditionValue)
+          : entryBuilder.CreateSub(exitConditionValue, startValue);
+  auto distance64 = entryBuilder.CreateZExtOrTrunc(distance, chunkCounterType);
+  if ((predicate == CmpInst::ICMP_SLE) || (predicate == CmpInst::ICMP_ULE)
+      || (predicate == CmpInst::ICMP_SGE) || (predicate == CmpInst::ICMP_UGE)) {
+    distance64 = entryBuilder.CreateAdd(distance64, onesValue);
+  }
+  auto roundedDistance = entryBuilder.CreateAdd(
+      distance64,
+      entryBuilder.CreateSub(absoluteStep, onesValue));
+  auto numberOfIterations = entryBuilder.CreateSelect(
+      hasIterations,
+      entryBuilder.CreateUDiv(roundedDistance, absoluteStep),
+      zeroValue,
+      "numberOfIterations");
+
+  /*
+   * Compute the first iteration of the first chunk of the task and the
+   * distance between two chunks of the task.
+   */
+  auto firstChunk = entryBuilder.CreateMul(task->taskInstanceID,
+                                           task->chunkSizeArg,
+                                           "coreIdx_X_chunkSize");
+  auto chunkStepSize = entryBuilder.CreateMul(task->numTaskInstances,
+                                              task->chunkSizeArg,
+                                              "numCores_X_chunkSize");
+
+  /*
+   * Compute the iterations of the current chunk.
+   * Tasks that have no chunk to execute enter the inner loop for zero
+   * iterations starting from the first iteration of the loop.
+   */
+  auto chunkStart =
+      chunkPreheaderBuilder.CreatePHI(chunkCounterType, 2, "chunkStart");
+  auto hasChunk =
+      chunkPreheaderBuilder.CreateICmpULT(chunkStart, numberOfIterations);
+  auto remainingIterations =
+      chunkPreheaderBuilder.CreateSub(numberOfIterations, chunkStart);
+  auto isChunkFull = chunkPreheaderBuilder.CreateICmpULT(task->chunkSizeArg,
+                                                         remainingIterations);
+  auto iterationsOfChunk = chunkPreheaderBuilder.CreateSelect(
+      hasChunk,
+      chunkPreheaderBuilder.CreateSelect(isChunkFull,
+                                         task->chunkSizeArg,
+                                         remainingIterations),
+      zeroValue,
+      "iterationsOfChunk");
+  auto firstIterationOfChunk =
+      chunkPreheaderBuilder.CreateSelect(hasChunk, chunkStart, zeroValue);
+
+  /*
+   * Set the start value of the IVs to the first iteration of the current
+   * chunk:
+   *    = original_start + (original_step_size * first_iteration_of_chunk)
+   */
+  for (auto ivInfo : allIVInfo->getInductionVariables(*loopStructure)) {
+    auto startOfIV = this->fetchCloneInTask(task, ivInfo->getStartValue());
+    auto stepOfIV = clonedStepSizeMap.at(ivInfo);
+    auto ivPHI =
+        cast<PHINode>(this->fetchCloneInTask(task, ivInfo->getLoopEntryPHI()));
+    auto startOfChunk =
+        IVUtility::computeInductionVariableValueForIteration(
+            chunkPreheader,
+            ivPHI,
+            startOfIV,
+            stepOfIV,
+            firstIterationOfChunk);
+    ivPHI->setIncomingValueForBlock(chunkPreheader, startOfChunk);
+  }
+
+  /*
+   * Carry the reducible variables across the chunks of the task.
+   */
+  for (auto sccInfo : sccManager->getSCCsWithLoopCarriedDataDependencies()) {
+    auto reductionSCC = dyn_cast<ReductionSCC>(sccInfo);
+    if (reductionSCC == nullptr) {
+      continue;
+    }
+    auto headerPHI =
+        reductionSCC->getPhiThatAccumulatesValuesBetweenLoopIterations();
+    auto headerPHIClone =
+        cast<PHINode>(task->getCloneOfOriginalInstruction(headerPHI));
+    auto initialValue =
+        headerPHIClone->getIncomingValueForBlock(chunkPreheader);
+    chunkPreheaderBuilder.SetInsertPoint(chunkStart->getNextNode());
+    auto accumulatorPHI =
+        chunkPreheaderBuilder.CreatePHI(headerPHIClone->getType(), 2);
+    accumulatorPHI->addIncoming(initialValue, entryBlock);
+    accumulatorPHI->addIncoming(headerPHIClone, chunkLatch);
+    headerPHIClone->setIncomingValueForBlock(chunkPreheader, accumulatorPHI);
+  }
+
+  /*
+   * Generate the counted inner loop.
+   */
+  IRBuilder<> headerBuilder(headerClone);
+  headerBuilder.SetInsertPoint(&*headerClone->begin());
+  auto iterationWithinChunk =
+      headerBuilder.CreatePHI(chunkCounterType, 2, "iterationWithinChunk");
+  IRBuilder<> latchBuilder(latchClone->getTerminator());
+  auto nextIterationWithinChunk =
+      latchBuilder.CreateAdd(iterationWithinChunk, onesValue);
+  iterationWithinChunk->addIncoming(zeroValue, chunkPreheader);
+  iterationWithinChunk->addIncoming(nextIterationWithinChunk, latchClone);
+  auto brInst = cast<BranchInst>(task->getCloneOfOriginalInstruction(
+      loopGoverningIVAttr->getHeaderBrInst()));
+  auto bodyBlock = (brInst->getSuccessor(0) == lastBlock)
+                       ? brInst->getSuccessor(1)
+                       : brInst->getSuccessor(0);
+  headerBuilder.SetInsertPoint(brInst);
+  auto isWithinChunk =
+      headerBuilder.CreateICmpULT(iterationWithinChunk, iterationsOfChunk);
+  brInst->setCondition(isWithinChunk);
+  brInst->setSuccessor(0, bodyBlock);
+  brInst->setSuccessor(1, chunkLatch);
+
+  /*
+   * Jump to the next chunk of the task, if any.
+   * The task executed the last iteration of the loop if it belongs to the
+   * current chunk.
+   */
+  auto nextChunk = chunkLatchBuilder.CreateAdd(chunkStart, chunkStepSize);
+  auto offsetOfLastIteration = chunkLatchBuilder.CreateSub(
+      chunkLatchBuilder.CreateSub(numberOfIterations, onesValue),
+      chunkStart);
+  this->taskExecutedTheLastIteration =
+      chunkLatchBuilder.CreateICmpULT(offsetOfLastIteration,
+                                      task->chunkSizeArg,
+                                      "isLastLoopIteration");
+  auto isThereANextChunk =
+      chunkLatchBuilder.CreateICmpULT(nextChunk, numberOfIterations);
+  chunkLatchBuilder.CreateCondBr(isThereANextChunk, chunkPreheader, lastBlock);
+  chunkStart->addIncoming(firstChunk, entryBlock);
+  chunkStart->addIncoming(nextChunk, chunkLatch);
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -368,6 +368,12 @@ bool DSWP::apply(LoopContent *LDI, Heuristics *h) {
       errs() << "DSWP:  Stored live out instructions\n";
     }
 
+    /*
+     * Let the compiler know which memory the stage can access through its
+     * live-in pointers.
+     */
+    this->propagateAliasInformationToTask(LDI, i);
+
     /*
      * Inline recursively calls to queues.
      */
@@ -391,6 +397,16 @@ bool DSWP::apply(LoopContent *LDI, Heuristics *h) {
   }
   createPipelineFromStages(LDI, this->noelle);
 
+  /*
+   * Use the thread-caching allocator for the memory allocated by the stages.
+   */
+  if (this->useThreadCachingAllocator) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "DSWP:  Use the thread-caching allocator\n";
+    }
+    this->substituteMemoryAllocators();
+  }
+
   delete this->originalFunctionDS;
 
   /*
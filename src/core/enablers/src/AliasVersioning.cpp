@@ -0,0 +1,168 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "EnablersManager.hpp"
+#include "arcana/noelle/core/LoopCarriedSCC.hpp"
+#include "arcana/gino/core/DOALL.hpp"
+#include "llvm/Analysis/LoopAccessAnalysis.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
+#include "llvm/Transforms/Utils/LoopVersioning.h"
+
+namespace arcana::gino {
+
+/*
+ * Loop metadata that marks both versions of a loop that has been versioned
+ * already.
+ */
+static const char *versionedLoopMetadata = "noelle.enablers.alias.versioned";
+
+/*
+ * Check whether DOALL is blocked only by loop-carried memory dependences
+ * between accesses to different objects, which may alias.
+ */
+static bool isBlockedOnlyByMayAliasDependences(LoopContent *LDI, Noelle &par) {
+
+  /*
+   * Fetch the SCCs that block DOALL.
+   */
+  auto sccManager = LDI->getSCCManager();
+  auto blockingSCCs = DOALL::getSCCsThatBlockDOALLToBeApplicable(LDI, par);
+  if (blockingSCCs.size() == 0) {
+    return false;
+  }
+
+  for (auto scc : blockingSCCs) {
+    auto sccInfo = dyn_cast<LoopCarriedSCC>(sccManager->getSCCAttrs(scc));
+    if (sccInfo == nullptr) {
+      return false;
+    }
+    for (auto dep : sccInfo->getLoopCarriedDependences()) {
+
+      /*
+       * Check the dependence is between memory accesses.
+       */
+      if (!isa<MemoryDependence<Value, Value>>(dep)) {
+        return false;
+      }
+      auto srcPtr = getLoadStorePointerOperand(dep->getSrc());
+      auto dstPtr = getLoadStorePointerOperand(dep->getDst());
+      if ((srcPtr == nullptr) || (dstPtr == nullptr)) {
+        return false;
+      }
+
+      /*
+       * Check the accesses are to different objects.
+       * A dependence within the same object cannot be removed by checking
+       * for overlaps at run time.
+       */
+      auto srcObject = getUnderlyingObject(srcPtr);
+      auto dstObject = getUnderlyingObject(dstPtr);
+      if (srcObject == dstObject) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool EnablersManager::applyAliasVersioning(LoopContent *LDI, Noelle &par) {
+  assert(LDI != nullptr);
+
+  /*
+   * Fetch the LLVM loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto f = loopStructure->getFunction();
+  auto &LI = getAnalysis<LoopInfoWrapperPass>(*f).getLoopInfo();
+  auto &DT = getAnalysis<DominatorTreeWrapperPass>(*f).getDomTree();
+  auto loop = LI.getLoopFor(loopStructure->getHeader());
+  assert(loop != nullptr);
+
+  /*
+   * Check the loop has not been versioned already.
+   */
+  if (findStringMetadataForLoop(loop, versionedLoopMetadata).hasValue()) {
+    return false;
+  }
+
+  /*
+   * Check the loop has the shape required to be versioned.
+   */
+  if (!loop->isInnermost() || !loop->isLoopSimplifyForm()
+      || (loop->getExitBlock() == nullptr) || !loop->isLCSSAForm(DT)) {
+    return false;
+  }
+  auto IVManager = LDI->getInductionVariableManager();
+  if (IVManager->getLoopGoverningInductionVariable() == nullptr) {
+    return false;
+  }
+
+  /*
+   * Check DOALL is blocked only by dependences between objects that may
+   * alias.
+   */
+  if (!isBlockedOnlyByMayAliasDependences(LDI, par)) {
+    return false;
+  }
+  errs() << "EnablersManager:       DOALL is blocked only by may-alias "
+            "dependences\n";
+
+  /*
+   * Compute the ranges of memory accessed by the loop from the SCEVs of the
+   * affine accesses.
+   * These are the checks that the loop vectorizer uses.
+   */
+  auto &SE = getAnalysis<ScalarEvolutionWrapperPass>(*f).getSE();
+  auto &AA = getAnalysis<AAResultsWrapperPass>(*f).getAAResults();
+  auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(*f);
+  LoopAccessInfo LAI(loop, &SE, &TLI, &AA, &DT, &LI);
+  if (!LAI.canVectorizeMemory()
+      || (LAI.getNumRuntimePointerChecks() == 0)) {
+    errs() << "EnablersManager:       The accessed ranges cannot be "
+              "computed\n";
+    return false;
+  }
+  errs() << "EnablersManager:       Version the loop with "
+         << LAI.getNumRuntimePointerChecks() << " overlap checks\n";
+
+  /*
+   * Version the loop.
+   *
+   * The original loop runs when no range overlaps and its accesses to
+   * different objects are annotated as not aliasing.
+   * This enables the dependence analysis to remove the dependences that
+   * block DOALL.
+   * The clone of the loop runs otherwise.
+   */
+  auto &checks = LAI.getRuntimePointerChecking()->getChecks();
+  LoopVersioning versioning(LAI, checks, loop, &LI, &DT, &SE);
+  versioning.versionLoop();
+  versioning.annotateLoopWithNoAlias();
+  addStringMetadataToLoop(versioning.getVersionedLoop(), versionedLoopMetadata);
+  addStringMetadataToLoop(versioning.getNonVersionedLoop(),
+                          versionedLoopMetadata);
+
+  return true;
+}
+
+} // namespace arcana::gino
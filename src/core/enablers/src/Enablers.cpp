@@ -65,6 +65,52 @@ bool EnablersManager::applyEnablers(
     }
   }
 
+  /*
+   * Version loops that are DOALL when their pointers do not alias.
+   */
+  if (this->enableAliasVersioning) {
+    errs() << "EnablersManager:     Try to version the loop for aliasing\n";
+    if (this->applyAliasVersioning(LDI, par)) {
+      errs() << "EnablersManager:       The loop has been versioned\n";
+      return true;
+    }
+  }
+
+  /*
+   * Version loops that are DOALL when their indirect accesses go through
+   * distinct indices.
+   */
+  if (this->enableInspectorExecutor) {
+    errs() << "EnablersManager:     Try to inspect the indices of the loop\n";
+    if (this->applyInspectorExecutor(LDI, par)) {
+      errs() << "EnablersManager:       The loop has been versioned\n";
+      return true;
+    }
+  }
+
+  /*
+   * Turn loops that chase pointers into counted loops over the pointers they
+   * visit.
+   */
+  if (this->enablePointerChasing) {
+    errs() << "EnablersManager:     Try to materialize the chased pointers\n";
+    if (this->applyPointerChasingMaterialization(LDI, par)) {
+      errs() << "EnablersManager:       The pointers have been materialized\n";
+      return true;
+    }
+  }
+
+  /*
+   * Collapse perfect loop nests to expose more iterations to DOALL.
+   */
+  if (this->enableLoopCollapsing) {
+    errs() << "EnablersManager:     Try to collapse the loop nest\n";
+    if (this->applyLoopCollapsing(LDI, par)) {
+      errs() << "EnablersManager:       The loop nest has been collapsed\n";
+      return true;
+    }
+  }
+
   /*
    * Run the extraction.
    */
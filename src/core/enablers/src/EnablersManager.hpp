@@ -50,6 +50,10 @@ private:
    * Fields
    */
   bool enableEnablers;
+  bool enableLoopCollapsing;
+  bool enableAliasVersioning;
+  bool enableInspectorExecutor;
+  bool enablePointerChasing;
 
   /*
    * Methods
@@ -71,6 +75,14 @@ private:
                              LoopTransformer &LoopTransformer);
 
   bool applyDevirtualizer(LoopContent *LDI, Noelle &par, LoopTransformer &lt);
+
+  bool applyLoopCollapsing(LoopContent *LDI, Noelle &par);
+
+  bool applyAliasVersioning(LoopContent *LDI, Noelle &par);
+
+  bool applyInspectorExecutor(LoopContent *LDI, Noelle &par);
+
+  bool applyPointerChasingMaterialization(LoopContent *LDI, Noelle &par);
 };
 
 } // namespace arcana::gino
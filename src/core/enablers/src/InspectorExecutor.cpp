@@ -0,0 +1,468 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "EnablersManager.hpp"
+#include "arcana/noelle/core/LoopCarriedSCC.hpp"
+#include "arcana/gino/core/DOALL.hpp"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+
+namespace arcana::gino {
+
+/*
+ * Loop metadata that marks both versions of a loop that has been versioned
+ * by the inspector-executor already.
+ */
+static const char *inspectedLoopMetadata = "noelle.enablers.inspected";
+
+/*
+ * Name of the locations that cache the verdicts of the inspector.
+ */
+static const char *inspectorVerdictName = "noelle.inspector.verdict";
+
+/*
+ * An access to @array at the position stored in @indices at the current
+ * iteration (i.e., array[indices[i]]).
+ */
+struct IndirectAccess {
+  Value *array = nullptr;
+  Type *elementType = nullptr;
+  Value *indices = nullptr;
+  GetElementPtrInst *indexAddress = nullptr;
+};
+
+static Value *stripIntegerCasts(Value *v) {
+  while (isa<SExtInst>(v) || isa<ZExtInst>(v)) {
+    v = cast<CastInst>(v)->getOperand(0);
+  }
+  return v;
+}
+
+static bool getIndirectAccess(Instruction *inst,
+                              LoopStructure *loop,
+                              PHINode *ivPHI,
+                              IndirectAccess &access) {
+
+  /*
+   * Check the address of the access is array[index].
+   */
+  auto ptr = getLoadStorePointerOperand(inst);
+  auto gep = dyn_cast_or_null<GetElementPtrInst>(ptr);
+  if ((gep == nullptr) || (gep->getNumIndices() != 1)) {
+    return false;
+  }
+
+  /*
+   * Check the index is indices[i] where i is the loop-governing IV.
+   */
+  auto indexLoad = dyn_cast<LoadInst>(stripIntegerCasts(gep->getOperand(1)));
+  if (indexLoad == nullptr) {
+    return false;
+  }
+  auto indexAddress =
+      dyn_cast<GetElementPtrInst>(indexLoad->getPointerOperand());
+  if ((indexAddress == nullptr) || (indexAddress->getNumIndices() != 1)
+      || (stripIntegerCasts(indexAddress->getOperand(1)) != ivPHI)) {
+    return false;
+  }
+
+  /*
+   * Check neither the array nor the indices change within the loop.
+   */
+  auto array = gep->getPointerOperand();
+  auto indices = indexAddress->getPointerOperand();
+  for (auto base : { array, indices }) {
+    auto baseInst = dyn_cast<Instruction>(base);
+    if ((baseInst != nullptr) && loop->isIncluded(baseInst)) {
+      return false;
+    }
+  }
+  access.array = array;
+  access.elementType = gep->getSourceElementType();
+  access.indices = indices;
+  access.indexAddress = indexAddress;
+
+  return true;
+}
+
+/*
+ * Check if @inst may write the memory object @indicesObject.
+ * Calls to functions with a body do not count because the instructions of
+ * their bodies are checked instead.
+ */
+static bool mayWriteIndices(Instruction *inst, Value *indicesObject) {
+  if (!inst->mayWriteToMemory()) {
+    return false;
+  }
+
+  /*
+   * Fetch the memory written by the instruction, if we know it.
+   */
+  Value *writtenPtr = nullptr;
+  if (auto storeInst = dyn_cast<StoreInst>(inst)) {
+    writtenPtr = storeInst->getPointerOperand();
+  } else if (auto rmwInst = dyn_cast<AtomicRMWInst>(inst)) {
+    writtenPtr = rmwInst->getPointerOperand();
+  } else if (auto cmpXchgInst = dyn_cast<AtomicCmpXchgInst>(inst)) {
+    writtenPtr = cmpXchgInst->getPointerOperand();
+  } else if (auto memInst = dyn_cast<MemIntrinsic>(inst)) {
+    writtenPtr = memInst->getRawDest();
+  } else if (auto callInst = dyn_cast<CallBase>(inst)) {
+    if (callInst->isLifetimeStartOrEnd()
+        || isa<DbgInfoIntrinsic>(callInst)) {
+      return false;
+    }
+    auto callee = callInst->getCalledFunction();
+    if ((callee != nullptr) && !callee->isDeclaration()) {
+      return false;
+    }
+    return true;
+  }
+  if (writtenPtr == nullptr) {
+    return true;
+  }
+
+  /*
+   * Distinct objects do not alias, and stack objects that are never captured
+   * can only be written through their own pointers.
+   */
+  auto writtenObject = getUnderlyingObject(writtenPtr);
+  if (writtenObject->getName().startswith(inspectorVerdictName)) {
+    return false;
+  }
+  if (writtenObject == indicesObject) {
+    return true;
+  }
+  if (isIdentifiedObject(writtenObject) && isIdentifiedObject(indicesObject)) {
+    return false;
+  }
+  if (isa<AllocaInst>(writtenObject)
+      && !PointerMayBeCaptured(writtenObject, true, true)) {
+    return false;
+  }
+
+  return true;
+}
+
+bool EnablersManager::applyInspectorExecutor(LoopContent *LDI, Noelle &par) {
+  assert(LDI != nullptr);
+
+  /*
+   * Fetch the LLVM loop.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto f = loopStructure->getFunction();
+  auto &LI = getAnalysis<LoopInfoWrapperPass>(*f).getLoopInfo();
+  auto &DT = getAnalysis<DominatorTreeWrapperPass>(*f).getDomTree();
+  auto &SE = getAnalysis<ScalarEvolutionWrapperPass>(*f).getSE();
+  auto loop = LI.getLoopFor(loopStructure->getHeader());
+  assert(loop != nullptr);
+
+  /*
+   * Check the loop has not been versioned already and that it has the shape
+   * required to be versioned.
+   */
+  if (findStringMetadataForLoop(loop, inspectedLoopMetadata).hasValue()) {
+    return false;
+  }
+  if (!loop->isLoopSimplifyForm() || (loop->getExitBlock() == nullptr)
+      || !loop->isLCSSAForm(DT)) {
+    return false;
+  }
+
+  /*
+   * Fetch the loop-governing IV, which must be incremented by one.
+   */
+  auto IVManager = LDI->getInductionVariableManager();
+  auto loopGoverningIVAttr = IVManager->getLoopGoverningInductionVariable();
+  if (loopGoverningIVAttr == nullptr) {
+    return false;
+  }
+  auto loopGoverningIV = loopGoverningIVAttr->getInductionVariable();
+  auto step = dyn_cast_or_null<ConstantInt>(
+      loopGoverningIV->getSingleComputedStepValue());
+  if ((step == nullptr) || !step->isOne()) {
+    return false;
+  }
+  auto ivPHI = loopGoverningIV->getLoopEntryPHI();
+
+  /*
+   * Check DOALL is blocked only by dependences between indirect accesses to
+   * the same array through the same indices.
+   */
+  auto sccManager = LDI->getSCCManager();
+  auto blockingSCCs = DOALL::getSCCsThatBlockDOALLToBeApplicable(LDI, par);
+  if (blockingSCCs.size() == 0) {
+    return false;
+  }
+  std::map<Value *, GetElementPtrInst *> inspectedIndices;
+  std::map<Instruction *, std::pair<Value *, Value *>> accessesToTag;
+  for (auto scc : blockingSCCs) {
+    auto sccInfo = dyn_cast<LoopCarriedSCC>(sccManager->getSCCAttrs(scc));
+    if (sccInfo == nullptr) {
+      return false;
+    }
+    for (auto dep : sccInfo->getLoopCarriedDependences()) {
+      if (!isa<MemoryDependence<Value, Value>>(dep)) {
+        return false;
+      }
+      auto srcInst = dyn_cast<Instruction>(dep->getSrc());
+      auto dstInst = dyn_cast<Instruction>(dep->getDst());
+      if ((srcInst == nullptr) || (dstInst == nullptr)) {
+        return false;
+      }
+      IndirectAccess srcAccess;
+      IndirectAccess dstAccess;
+      if (!getIndirectAccess(srcInst, loopStructure, ivPHI, srcAccess)
+          || !getIndirectAccess(dstInst, loopStructure, ivPHI, dstAccess)) {
+        return false;
+      }
+      if ((srcAccess.array != dstAccess.array)
+          || (srcAccess.elementType != dstAccess.elementType)
+          || (srcAccess.indices != dstAccess.indices)) {
+        return false;
+      }
+      inspectedIndices[srcAccess.indices] = srcAccess.indexAddress;
+      auto arrayAndIndices =
+          std::make_pair(srcAccess.array, srcAccess.indices);
+      accessesToTag[srcInst] = arrayAndIndices;
+      accessesToTag[dstInst] = arrayAndIndices;
+    }
+  }
+
+  /*
+   * Compute the number of iterations of the loop.
+   * When the latch decides whether to iterate again, the body runs once more
+   * than the number of backedges taken. When the header does, the body runs
+   * once per backedge, so the accesses must not be in the header.
+   */
+  auto backedgeTakenCount = SE.getBackedgeTakenCount(loop);
+  if (isa<SCEVCouldNotCompute>(backedgeTakenCount)) {
+    return false;
+  }
+  auto header = loop->getHeader();
+  auto bodyRunsWithTheLastBackedge = loop->isRotatedForm();
+  if (!bodyRunsWithTheLastBackedge) {
+    if (loop->getExitingBlock() != header) {
+      return false;
+    }
+    for (auto &pair : accessesToTag) {
+      if (pair.first->getParent() == header) {
+        return false;
+      }
+    }
+  }
+  errs() << "EnablersManager:       DOALL is blocked only by accesses through "
+         << inspectedIndices.size() << " index arrays\n";
+
+  /*
+   * Inspect the indices before entering the loop.
+   * The inspector checks that every index array has no duplicates within the
+   * iterations of the loop.
+   */
+  auto preheader = loop->getLoopPreheader();
+  auto &DL = f->getParent()->getDataLayout();
+  auto &context = f->getContext();
+  auto int32 = IntegerType::get(context, 32);
+  auto int64 = IntegerType::get(context, 64);
+  auto int8Ptr = PointerType::getUnqual(IntegerType::get(context, 8));
+  auto program = f->getParent();
+  auto inspector = program->getOrInsertFunction(
+      "NOELLE_areIndicesDistinct",
+      FunctionType::get(int32, { int8Ptr, int64, int64, int8Ptr }, false));
+
+  /*
+   * Every call to the inspector caches its verdict in a location of its own.
+   * The location mirrors InspectorVerdict_t of the runtime: the indices, their
+   * number, the verdict, and whether the indices have been written since.
+   */
+  auto verdictType = StructType::get(context, { int8Ptr, int64, int32, int32 });
+  std::map<GlobalVariable *, Value *> verdictsOfIndices;
+  SCEVExpander expander(SE, DL, "inspector");
+  auto tripCountSCEV = SE.getZeroExtendExpr(backedgeTakenCount, int64);
+  if (bodyRunsWithTheLastBackedge) {
+    tripCountSCEV = SE.getAddExpr(tripCountSCEV, SE.getOne(int64));
+  }
+  auto tripCount =
+      expander.expandCodeFor(tripCountSCEV, int64, preheader->getTerminator());
+  IRBuilder<> builder(preheader->getTerminator());
+  auto firstIteration = ivPHI->getIncomingValueForBlock(preheader);
+  Value *areDistinct = builder.getTrue();
+  for (auto &pair : inspectedIndices) {
+    auto indexAddress = pair.second;
+    auto indexPosition = indexAddress->getOperand(1);
+    auto firstPosition = builder.CreateIntCast(firstIteration,
+                                               indexPosition->getType(),
+                                               !isa<ZExtInst>(indexPosition));
+    auto firstIndex =
+        builder.CreateGEP(indexAddress->getSourceElementType(),
+                          pair.first,
+                          firstPosition);
+    auto indexSize = DL.getTypeAllocSize(indexAddress->getResultElementType());
+    auto verdictLocation =
+        new GlobalVariable(*program,
+                           verdictType,
+                           false,
+                           GlobalValue::InternalLinkage,
+                           ConstantAggregateZero::get(verdictType),
+                           inspectorVerdictName);
+    verdictsOfIndices[verdictLocation] = getUnderlyingObject(pair.first);
+    auto verdict = builder.CreateCall(
+        inspector,
+        { builder.CreatePointerCast(firstIndex, int8Ptr),
+          tripCount,
+          ConstantInt::get(int64, indexSize),
+          builder.CreatePointerCast(verdictLocation, int8Ptr) });
+    areDistinct = builder.CreateAnd(
+        areDistinct,
+        builder.CreateICmpNE(verdict, ConstantInt::get(int32, 0)));
+  }
+
+  /*
+   * Clone the loop.
+   * The original loop runs when the indices are distinct and its clone runs
+   * otherwise.
+   */
+  auto inspectorBB = preheader;
+  auto newPreheader = SplitBlock(inspectorBB,
+                                 inspectorBB->getTerminator(),
+                                 &DT,
+                                 &LI,
+                                 nullptr,
+                                 "executor");
+  ValueToValueMapTy VMap;
+  SmallVector<BasicBlock *, 8> clonedBBs;
+  auto clonedLoop = cloneLoopWithPreheader(newPreheader,
+                                           inspectorBB,
+                                           loop,
+                                           VMap,
+                                           ".sequential",
+                                           &LI,
+                                           &DT,
+                                           clonedBBs);
+  remapInstructionsInBlocks(clonedBBs, VMap);
+  auto clonedPreheader = cast<BasicBlock>(VMap[newPreheader]);
+  auto jumpToLoop = inspectorBB->getTerminator();
+  BranchInst::Create(newPreheader, clonedPreheader, areDistinct, inspectorBB);
+  jumpToLoop->eraseFromParent();
+
+  /*
+   * Merge the values that leave the two versions of the loop.
+   */
+  auto exitBB = loop->getExitBlock();
+  for (auto &phi : exitBB->phis()) {
+    for (auto exitingBB : loop->blocks()) {
+      auto index = phi.getBasicBlockIndex(exitingBB);
+      if (index < 0) {
+        continue;
+      }
+      auto value = phi.getIncomingValue(index);
+      Value *clonedValue = value;
+      if (VMap.count(value)) {
+        clonedValue = VMap[value];
+      }
+      phi.addIncoming(clonedValue, cast<BasicBlock>(VMap[exitingBB]));
+    }
+  }
+  DT.changeImmediateDominator(exitBB, inspectorBB);
+
+  /*
+   * Tag the accesses of the original loop that go through the inspected
+   * indices, one tag per array and index array.
+   * DOALL does not consider dependences between accesses with the same tag.
+   */
+  std::map<std::pair<Value *, Value *>, MDNode *> tags;
+  for (auto &pair : accessesToTag) {
+    auto &tag = tags[pair.second];
+    if (tag == nullptr) {
+      tag = MDNode::getDistinct(context, {});
+    }
+    pair.first->setMetadata(DOALL::getInspectedIndicesMetadataName(), tag);
+  }
+  addStringMetadataToLoop(loop, inspectedLoopMetadata);
+  addStringMetadataToLoop(clonedLoop, inspectedLoopMetadata);
+
+  /*
+   * Invalidate the cached verdicts after every instruction of the program
+   * that may write the inspected indices.
+   * The two versions of the loop do not write them: their accesses would
+   * have blocked the inspector-executor otherwise.
+   */
+  std::set<BasicBlock *> blocksOfTheLoops(loop->block_begin(),
+                                          loop->block_end());
+  blocksOfTheLoops.insert(clonedBBs.begin(), clonedBBs.end());
+  std::vector<std::pair<Instruction *, GlobalVariable *>> writers;
+  for (auto &F : *program) {
+    for (auto &inst : instructions(F)) {
+      if (blocksOfTheLoops.count(inst.getParent()) > 0) {
+        continue;
+      }
+      if (auto callInst = dyn_cast<CallBase>(&inst)) {
+        if (callInst->getCalledOperand() == inspector.getCallee()) {
+          continue;
+        }
+      }
+      for (auto &pair : verdictsOfIndices) {
+        if (mayWriteIndices(&inst, pair.second)) {
+          writers.push_back(std::make_pair(&inst, pair.first));
+        }
+      }
+    }
+  }
+  auto one = ConstantInt::get(int32, 1);
+  for (auto &pair : writers) {
+    auto writer = pair.first;
+    auto hasBeenWritten = ConstantExpr::getInBoundsGetElementPtr(
+        verdictType,
+        pair.second,
+        ArrayRef<Constant *>{ ConstantInt::get(int32, 0),
+                              ConstantInt::get(int32, 3) });
+    std::vector<Instruction *> insertPoints;
+    if (auto invokeInst = dyn_cast<InvokeInst>(writer)) {
+      auto normalDest = invokeInst->getNormalDest();
+      auto unwindDest = invokeInst->getUnwindDest();
+      insertPoints.push_back(&*normalDest->getFirstInsertionPt());
+      insertPoints.push_back(&*unwindDest->getFirstInsertionPt());
+    } else {
+      assert(!writer->isTerminator());
+      insertPoints.push_back(writer->getNextNode());
+    }
+    for (auto insertPoint : insertPoints) {
+      IRBuilder<> writerBuilder(insertPoint);
+      auto store =
+          writerBuilder.CreateAlignedStore(one, hasBeenWritten, Align(4));
+      store->setAtomic(AtomicOrdering::Monotonic);
+    }
+  }
+  errs() << "EnablersManager:       " << writers.size()
+         << " instructions may write the inspected indices\n";
+
+  return true;
+}
+
+} // namespace arcana::gino
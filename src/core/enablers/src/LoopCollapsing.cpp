@@ -0,0 +1,392 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "EnablersManager.hpp"
+#include "arcana/gino/core/DOALL.hpp"
+#include "llvm/Analysis/ValueTracking.h"
+
+namespace arcana::gino {
+
+/*
+ * A loop that can be collapsed has the following shape:
+ *
+ * header:
+ *   iv = phi [start, preheader], [iv + 1, latch]
+ *   br (iv PREDICATE end), body, exit
+ *
+ * where PREDICATE is slt, ult, or ne and both start and end are defined
+ * outside the loop nest.
+ */
+struct CollapsibleIV {
+  PHINode *phi;
+  Value *start;
+  Value *end;
+  Instruction *increment;
+  ICmpInst *compare;
+  CmpInst::Predicate predicate;
+  BasicBlock *body;
+  BasicBlock *exit;
+};
+
+static bool isDefinedOutside(Value *v, LoopStructure *loop) {
+  auto inst = dyn_cast<Instruction>(v);
+  if (inst == nullptr) {
+    return true;
+  }
+  return !loop->isIncluded(inst);
+}
+
+static bool getCollapsibleIV(LoopStructure *loop,
+                             LoopStructure *nest,
+                             CollapsibleIV &iv) {
+
+  /*
+   * Check the loop has a pre-header and a single latch.
+   */
+  auto header = loop->getHeader();
+  auto preheader = loop->getPreHeader();
+  auto latches = loop->getLatches();
+  if ((preheader == nullptr) || (latches.size() != 1)) {
+    return false;
+  }
+  auto latch = *latches.begin();
+
+  /*
+   * The only PHI of the header must be the induction variable.
+   */
+  auto firstNonPHI = header->getFirstNonPHI();
+  if (!isa<PHINode>(&*header->begin())
+      || (firstNonPHI->getPrevNode() != &*header->begin())) {
+    return false;
+  }
+  iv.phi = cast<PHINode>(&*header->begin());
+  if (!iv.phi->getType()->isIntegerTy()
+      || (iv.phi->getNumIncomingValues() != 2)) {
+    return false;
+  }
+  iv.start = iv.phi->getIncomingValueForBlock(preheader);
+
+  /*
+   * The induction variable must be incremented by one.
+   */
+  auto next = iv.phi->getIncomingValueForBlock(latch);
+  auto increment = dyn_cast<BinaryOperator>(next);
+  if ((increment == nullptr)
+      || (increment->getOpcode() != Instruction::Add)) {
+    return false;
+  }
+  auto otherOperand = (increment->getOperand(0) == iv.phi)
+                          ? increment->getOperand(1)
+                          : increment->getOperand(0);
+  auto step = dyn_cast<ConstantInt>(otherOperand);
+  if ((step == nullptr) || !step->isOne() || !increment->hasOneUse()) {
+    return false;
+  }
+  iv.increment = increment;
+
+  /*
+   * The header must exit the loop by comparing the induction variable with a
+   * value.
+   */
+  auto br = dyn_cast<BranchInst>(header->getTerminator());
+  if ((br == nullptr) || !br->isConditional()) {
+    return false;
+  }
+  iv.compare = dyn_cast<ICmpInst>(br->getCondition());
+  if ((iv.compare == nullptr) || !iv.compare->hasOneUse()) {
+    return false;
+  }
+  iv.predicate = iv.compare->getPredicate();
+  if (iv.compare->getOperand(0) == iv.phi) {
+    iv.end = iv.compare->getOperand(1);
+  } else if (iv.compare->getOperand(1) == iv.phi) {
+    iv.end = iv.compare->getOperand(0);
+    iv.predicate = CmpInst::getSwappedPredicate(iv.predicate);
+  } else {
+    return false;
+  }
+  if (loop->isIncluded(br->getSuccessor(0))) {
+    iv.body = br->getSuccessor(0);
+    iv.exit = br->getSuccessor(1);
+  } else {
+    iv.body = br->getSuccessor(1);
+    iv.exit = br->getSuccessor(0);
+    iv.predicate = CmpInst::getInversePredicate(iv.predicate);
+  }
+  if (loop->isIncluded(iv.exit)) {
+    return false;
+  }
+  if ((iv.predicate != CmpInst::ICMP_SLT) && (iv.predicate != CmpInst::ICMP_ULT)
+      && (iv.predicate != CmpInst::ICMP_NE)) {
+    return false;
+  }
+
+  /*
+   * The bounds must not change within the loop nest.
+   */
+  if (!isDefinedOutside(iv.start, nest) || !isDefinedOutside(iv.end, nest)) {
+    return false;
+  }
+
+  return true;
+}
+
+static Value *computeTripCount(IRBuilder<> &builder,
+                               CollapsibleIV &iv,
+                               IntegerType *type) {
+
+  /*
+   * A loop that iterates until its induction variable becomes the end value
+   * runs end - start times modulo the width of the induction variable, whatever
+   * the signedness of its bounds.
+   */
+  if (iv.predicate == CmpInst::ICMP_NE) {
+    return builder.CreateZExt(builder.CreateSub(iv.end, iv.start), type);
+  }
+
+  /*
+   * Extend the bounds to the type of the collapsed induction variable.
+   */
+  auto isSigned = (iv.predicate == CmpInst::ICMP_SLT);
+  auto start = isSigned ? builder.CreateSExt(iv.start, type)
+                        : builder.CreateZExt(iv.start, type);
+  auto end = isSigned ? builder.CreateSExt(iv.end, type)
+                      : builder.CreateZExt(iv.end, type);
+  auto trips = builder.CreateSub(end, start);
+
+  /*
+   * The loop does not execute when its start value is already past the end.
+   */
+  auto isEmpty = isSigned ? builder.CreateICmpSLE(end, start)
+                          : builder.CreateICmpULE(end, start);
+  auto tripCount =
+      builder.CreateSelect(isEmpty, ConstantInt::get(type, 0), trips);
+
+  return tripCount;
+}
+
+bool EnablersManager::applyLoopCollapsing(LoopContent *LDI, Noelle &par) {
+  assert(LDI != nullptr);
+
+  /*
+   * Check the loop includes exactly one loop, which does not include others.
+   */
+  auto outerLoop = LDI->getLoopStructure();
+  auto loopNode = LDI->getLoopHierarchyStructures();
+  auto children = loopNode->getChildren();
+  if (children.size() != 1) {
+    return false;
+  }
+  auto innerNode = *children.begin();
+  if (innerNode->getChildren().size() != 0) {
+    return false;
+  }
+  auto innerLoop = innerNode->getLoop();
+
+  /*
+   * Check both loops are counted ones with bounds that do not change within
+   * the nest.
+   */
+  CollapsibleIV outerIV;
+  CollapsibleIV innerIV;
+  if (!getCollapsibleIV(outerLoop, outerLoop, outerIV)
+      || !getCollapsibleIV(innerLoop, outerLoop, innerIV)) {
+    return false;
+  }
+  if ((outerLoop->numberOfExitBasicBlocks() != 1)
+      || (innerLoop->numberOfExitBasicBlocks() != 1)
+      || !outerLoop->isIncluded(innerIV.exit)) {
+    return false;
+  }
+  auto exitBB = outerIV.exit;
+  if (isa<PHINode>(&*exitBB->begin())) {
+    return false;
+  }
+  errs() << "EnablersManager:       Both loops of the nest are counted\n";
+
+  /*
+   * Check the nest is perfect.
+   *
+   * The outer loop can only include the inner loop, the bookkeeping of its
+   * induction variable, and side-effect free computations that lead to the
+   * inner loop (e.g., the address of a row). The latter are re-computed by
+   * every iteration of the collapsed loop.
+   */
+  auto outerHeader = outerLoop->getHeader();
+  auto innerHeader = innerLoop->getHeader();
+  std::vector<BasicBlock *> bookkeepingBBs;
+  std::vector<Instruction *> instsToSink;
+  auto bb = outerHeader;
+  auto beforeInnerLoop = true;
+  std::unordered_set<BasicBlock *> visitedBBs;
+  while (bb != outerHeader || bookkeepingBBs.empty()) {
+    if (visitedBBs.count(bb) || !outerLoop->isIncluded(bb)) {
+      return false;
+    }
+    visitedBBs.insert(bb);
+    bookkeepingBBs.push_back(bb);
+    for (auto &inst : *bb) {
+      if ((&inst == outerIV.phi) || (&inst == outerIV.increment)
+          || (&inst == outerIV.compare) || (&inst == bb->getTerminator())) {
+        continue;
+      }
+      if (!beforeInnerLoop || isa<PHINode>(&inst)
+          || inst.mayReadOrWriteMemory() || inst.mayHaveSideEffects()
+          || !isSafeToSpeculativelyExecute(&inst)) {
+        errs() << "EnablersManager:       The nest is not perfect\n";
+        return false;
+      }
+      instsToSink.push_back(&inst);
+    }
+
+    /*
+     * Move to the next block of the outer loop.
+     */
+    BasicBlock *succBB = nullptr;
+    if (bb == outerHeader) {
+      succBB = outerIV.body;
+    } else {
+      auto br = dyn_cast<BranchInst>(bb->getTerminator());
+      if ((br == nullptr) || br->isConditional()) {
+        return false;
+      }
+      succBB = br->getSuccessor(0);
+    }
+    if (succBB == innerHeader) {
+      if (!beforeInnerLoop) {
+        return false;
+      }
+      beforeInnerLoop = false;
+      succBB = innerIV.exit;
+    }
+    bb = succBB;
+  }
+  auto numberOfOuterBBs =
+      bookkeepingBBs.size() + innerLoop->getBasicBlocks().size();
+  if (beforeInnerLoop
+      || (numberOfOuterBBs != outerLoop->getBasicBlocks().size())) {
+    return false;
+  }
+
+  /*
+   * Check no value computed within the nest is used outside the nest.
+   */
+  for (auto nestBB : outerLoop->getBasicBlocks()) {
+    for (auto &inst : *nestBB) {
+      for (auto user : inst.users()) {
+        auto userInst = dyn_cast<Instruction>(user);
+        if ((userInst == nullptr) || !outerLoop->isIncluded(userInst)) {
+          return false;
+        }
+      }
+    }
+  }
+
+  /*
+   * Check every iteration of the collapsed loop is independent.
+   */
+  DOALL doall{ par };
+  auto innerLDI = par.getLoopContent(innerLoop);
+  if (!doall.canBeAppliedToLoop(LDI, nullptr)
+      || !doall.canBeAppliedToLoop(innerLDI, nullptr)) {
+    errs() << "EnablersManager:       The nest is not DOALL\n";
+    return false;
+  }
+  errs() << "EnablersManager:       Collapse the perfect nest\n";
+
+  /*
+   * Compute the number of iterations of the collapsed loop before entering
+   * the nest.
+   *
+   * The divisor used to recover the induction variable of the inner loop is
+   * never zero because the header of the collapsed loop computes it before
+   * checking whether there are iterations left.
+   */
+  auto &context = outerHeader->getContext();
+  auto int64 = IntegerType::get(context, 64);
+  auto outerPreheader = outerLoop->getPreHeader();
+  IRBuilder<> preheaderBuilder(outerPreheader->getTerminator());
+  auto outerTrips = computeTripCount(preheaderBuilder, outerIV, int64);
+  auto innerTrips = computeTripCount(preheaderBuilder, innerIV, int64);
+  auto totalTrips = preheaderBuilder.CreateMul(outerTrips, innerTrips);
+  auto zero = ConstantInt::get(int64, 0);
+  auto one = ConstantInt::get(int64, 1);
+  auto isInnerEmpty = preheaderBuilder.CreateICmpEQ(innerTrips, zero);
+  auto divisor = preheaderBuilder.CreateSelect(isInnerEmpty, one, innerTrips);
+
+  /*
+   * Create the induction variable of the collapsed loop in the header of the
+   * inner loop.
+   */
+  auto innerLatch = *innerLoop->getLatches().begin();
+  auto firstInst = innerHeader->getFirstNonPHI();
+  auto collapsedIV =
+      PHINode::Create(int64, 2, "collapsed.iv", &*innerHeader->begin());
+  IRBuilder<> latchBuilder(innerLatch->getTerminator());
+  auto collapsedIVNext = latchBuilder.CreateAdd(collapsedIV, one);
+  collapsedIV->addIncoming(zero, outerPreheader);
+  collapsedIV->addIncoming(collapsedIVNext, innerLatch);
+
+  /*
+   * Recover the original induction variables.
+   */
+  IRBuilder<> headerBuilder(firstInst);
+  auto outerIteration = headerBuilder.CreateUDiv(collapsedIV, divisor);
+  auto innerIteration = headerBuilder.CreateURem(collapsedIV, divisor);
+  auto outerValue = headerBuilder.CreateAdd(
+      outerIV.start,
+      headerBuilder.CreateTrunc(outerIteration, outerIV.phi->getType()));
+  auto innerValue = headerBuilder.CreateAdd(
+      innerIV.start,
+      headerBuilder.CreateTrunc(innerIteration, innerIV.phi->getType()));
+  for (auto inst : instsToSink) {
+    inst->moveBefore(firstInst);
+  }
+  auto keepIterating = headerBuilder.CreateICmpULT(collapsedIV, totalTrips);
+  outerIV.phi->replaceAllUsesWith(outerValue);
+  innerIV.phi->replaceAllUsesWith(innerValue);
+
+  /*
+   * Exit the nest from the header of the collapsed loop.
+   */
+  auto innerHeaderBr = innerHeader->getTerminator();
+  BranchInst::Create(innerIV.body, exitBB, keepIterating, innerHeader);
+  innerHeaderBr->eraseFromParent();
+  innerIV.phi->eraseFromParent();
+  innerIV.increment->eraseFromParent();
+  innerIV.compare->eraseFromParent();
+
+  /*
+   * Jump directly to the collapsed loop and remove the bookkeeping of the
+   * outer loop.
+   */
+  outerPreheader->getTerminator()->replaceUsesOfWith(outerHeader, innerHeader);
+  for (auto bookkeepingBB : bookkeepingBBs) {
+    bookkeepingBB->dropAllReferences();
+  }
+  for (auto bookkeepingBB : bookkeepingBBs) {
+    bookkeepingBB->eraseFromParent();
+  }
+
+  return true;
+}
+
+} // namespace arcana::gino
@@ -28,10 +28,38 @@ static cl::opt<bool> DisableEnablers("noelle-disable-enablers",
                                      cl::ZeroOrMore,
                                      cl::Hidden,
                                      cl::desc("Disable all enablers"));
+static cl::opt<bool> EnableLoopCollapsing(
+    "noelle-enablers-loop-collapsing",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Collapse perfect nests of DOALL loops"));
+static cl::opt<bool> EnableAliasVersioning(
+    "noelle-enablers-alias-versioning",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Version loops with run-time checks for overlapping accesses"));
+static cl::opt<bool> EnableInspectorExecutor(
+    "noelle-enablers-inspector-executor",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Version loops with run-time checks for duplicated indices"));
+static cl::opt<bool> EnablePointerChasing(
+    "noelle-enablers-pointer-chasing",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Materialize the pointers chased by loops before running them"));
 
 bool EnablersManager::doInitialization(Module &M) {
   this->enableEnablers =
       (DisableEnablers.getNumOccurrences() == 0) ? true : false;
+  this->enableLoopCollapsing =
+      (EnableLoopCollapsing.getNumOccurrences() > 0) ? true : false;
+  this->enableAliasVersioning =
+      (EnableAliasVersioning.getNumOccurrences() > 0) ? true : false;
+  this->enableInspectorExecutor =
+      (EnableInspectorExecutor.getNumOccurrences() > 0) ? true : false;
+  this->enablePointerChasing =
+      (EnablePointerChasing.getNumOccurrences() > 0) ? true : false;
 
   return false;
 }
@@ -45,6 +73,8 @@ void EnablersManager::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<DominatorTreeWrapperPass>();
   AU.addRequired<ScalarEvolutionWrapperPass>();
   AU.addRequired<AssumptionCacheTracker>();
+  AU.addRequired<AAResultsWrapperPass>();
+  AU.addRequired<TargetLibraryInfoWrapperPass>();
 
   /*
    * Noelle framework.
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "EnablersManager.hpp"
+#include "arcana/gino/core/DOALL.hpp"
+#include "llvm/Analysis/ValueTracking.h"
+
+namespace arcana::gino {
+
+/*
+ * A loop that chases pointers has the following shape:
+ *
+ * header:
+ *   p = phi [head, preheader], [next, latch]
+ *   br (p == null), exit, body
+ * ...
+ *   next = load (p + offset)
+ */
+struct PointerChasing {
+  PHINode *phi;
+  LoadInst *next;
+  int64_t nextOffset;
+  ICmpInst *compare;
+  BasicBlock *body;
+  BasicBlock *exit;
+};
+
+static bool getPointerChasing(LoopContent *LDI,
+                              DominatorTree &DT,
+                              PointerChasing &chasing) {
+
+  /*
+   * Check the loop has a pre-header, a single latch, and a single exit block.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto header = loopStructure->getHeader();
+  auto preheader = loopStructure->getPreHeader();
+  auto latches = loopStructure->getLatches();
+  if ((preheader == nullptr) || (latches.size() != 1)
+      || (loopStructure->numberOfExitBasicBlocks() != 1)) {
+    return false;
+  }
+  auto latch = *latches.begin();
+  auto br = dyn_cast<BranchInst>(header->getTerminator());
+  if ((br == nullptr) || !br->isConditional()) {
+    return false;
+  }
+
+  /*
+   * Check the header exits the loop when a pointer becomes null.
+   */
+  chasing.compare = dyn_cast<ICmpInst>(br->getCondition());
+  if ((chasing.compare == nullptr) || !chasing.compare->hasOneUse()
+      || !chasing.compare->isEquality()
+      || !isa<ConstantPointerNull>(chasing.compare->getOperand(1))) {
+    return false;
+  }
+  chasing.phi = dyn_cast<PHINode>(chasing.compare->getOperand(0));
+  if ((chasing.phi == nullptr) || (chasing.phi->getParent() != header)
+      || (chasing.phi->getNumIncomingValues() != 2)) {
+    return false;
+  }
+  auto exitsWhenTrue =
+      (chasing.compare->getPredicate() == CmpInst::ICMP_EQ);
+  chasing.exit = br->getSuccessor(exitsWhenTrue ? 0 : 1);
+  chasing.body = br->getSuccessor(exitsWhenTrue ? 1 : 0);
+  if (loopStructure->isIncluded(chasing.exit)
+      || !loopStructure->isIncluded(chasing.body)
+      || (chasing.body->getSinglePredecessor() != header)
+      || (chasing.exit->getSinglePredecessor() != header)) {
+    return false;
+  }
+
+  /*
+   * Check the header is the only block that exits the loop.
+   * A loop that breaks out of the list walk would otherwise skip the release
+   * of the materialized list.
+   */
+  for (auto exitEdge : loopStructure->getLoopExitEdges()) {
+    if (exitEdge.first != header) {
+      return false;
+    }
+  }
+
+  /*
+   * Check the next pointer is loaded from a constant offset of the current
+   * one at every iteration.
+   */
+  chasing.next =
+      dyn_cast<LoadInst>(chasing.phi->getIncomingValueForBlock(latch));
+  if ((chasing.next == nullptr) || !chasing.next->isSimple()
+      || !DT.dominates(chasing.next->getParent(), latch)) {
+    return false;
+  }
+  auto &DL = header->getModule()->getDataLayout();
+  auto nextPtr = chasing.next->getPointerOperand();
+  auto base = GetPointerBaseWithConstantOffset(nextPtr, chasing.nextOffset, DL);
+  if (base->stripPointerCasts() != chasing.phi) {
+    return false;
+  }
+
+  /*
+   * Check the pointer is only used by the body of the loop.
+   */
+  for (auto user : chasing.phi->users()) {
+    auto userInst = cast<Instruction>(user);
+    if ((userInst != chasing.compare)
+        && ((userInst->getParent() == header)
+            || !loopStructure->isIncluded(userInst))) {
+      return false;
+    }
+  }
+
+  /*
+   * Check the loop does not write the next pointers.
+   */
+  auto loopDG = LDI->getLoopDG();
+  auto nextNode = loopDG->fetchNode(chasing.next);
+  for (auto dep : nextNode->getIncomingEdges()) {
+    if (!isa<MemoryDependence<Value, Value>>(dep)) {
+      continue;
+    }
+    auto srcInst = dyn_cast<Instruction>(dep->getSrc());
+    if ((srcInst != nullptr) && loopStructure->isIncluded(srcInst)
+        && srcInst->mayWriteToMemory()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool EnablersManager::applyPointerChasingMaterialization(LoopContent *LDI,
+                                                         Noelle &par) {
+  assert(LDI != nullptr);
+
+  /*
+   * Loops with a loop-governing IV do not need to be materialized.
+   */
+  auto IVManager = LDI->getInductionVariableManager();
+  if (IVManager->getLoopGoverningInductionVariable() != nullptr) {
+    return false;
+  }
+
+  /*
+   * Check the loop chases pointers.
+   */
+  auto loopStructure = LDI->getLoopStructure();
+  auto f = loopStructure->getFunction();
+  auto &DT = getAnalysis<DominatorTreeWrapperPass>(*f).getDomTree();
+  PointerChasing chasing;
+  if (!getPointerChasing(LDI, DT, chasing)) {
+    return false;
+  }
+
+  /*
+   * Check that chasing pointers is the only reason DOALL is blocked.
+   */
+  auto sccManager = LDI->getSCCManager();
+  auto chasingSCC = sccManager->getSCCDAG()->sccOfValue(chasing.phi);
+  for (auto scc : DOALL::getSCCsThatBlockDOALLToBeApplicable(LDI, par)) {
+    if (scc != chasingSCC) {
+      return false;
+    }
+  }
+  errs() << "EnablersManager:       The loop chases pointers at offset "
+         << chasing.nextOffset << "\n";
+
+  /*
+   * Materialize the pointers before entering the loop.
+   * The runtime chases them sequentially and stores them in a vector, whose
+   * storage is reused if the same list is traversed again.
+   */
+  auto &context = f->getContext();
+  auto int64 = IntegerType::get(context, 64);
+  auto int8Ptr = PointerType::getUnqual(IntegerType::get(context, 8));
+  auto nodesType = PointerType::getUnqual(int8Ptr);
+  auto materializeFunction = f->getParent()->getOrInsertFunction(
+      "NOELLE_materializeList",
+      FunctionType::get(int64,
+                        { int8Ptr, int64, PointerType::getUnqual(nodesType) },
+                        false));
+  IRBuilder<> entryBuilder(&*f->getEntryBlock().getFirstInsertionPt());
+  auto nodesPtr = entryBuilder.CreateAlloca(nodesType);
+  auto preheader = loopStructure->getPreHeader();
+  IRBuilder<> preheaderBuilder(preheader->getTerminator());
+  auto head = chasing.phi->getIncomingValueForBlock(preheader);
+  auto numberOfNodes = preheaderBuilder.CreateCall(
+      materializeFunction,
+      { preheaderBuilder.CreatePointerCast(head, int8Ptr),
+        ConstantInt::get(int64, chasing.nextOffset),
+        nodesPtr });
+  auto nodes = preheaderBuilder.CreateLoad(nodesType, nodesPtr);
+
+  /*
+   * Release the materialized pointers when the loop exits.
+   */
+  auto releaseFunction = f->getParent()->getOrInsertFunction(
+      "NOELLE_releaseList",
+      FunctionType::get(Type::getVoidTy(context), { nodesType }, false));
+  IRBuilder<> exitBuilder(&*chasing.exit->getFirstInsertionPt());
+  exitBuilder.CreateCall(releaseFunction, { nodes });
+
+  /*
+   * Iterate over the materialized pointers.
+   */
+  auto header = loopStructure->getHeader();
+  auto latch = *loopStructure->getLatches().begin();
+  auto iterationIV = PHINode::Create(int64, 2, "node.index", &*header->begin());
+  IRBuilder<> latchBuilder(latch->getTerminator());
+  auto nextIteration =
+      latchBuilder.CreateAdd(iterationIV, ConstantInt::get(int64, 1));
+  iterationIV->addIncoming(ConstantInt::get(int64, 0), preheader);
+  iterationIV->addIncoming(nextIteration, latch);
+  IRBuilder<> headerBuilder(chasing.compare);
+  auto keepIterating = headerBuilder.CreateICmpULT(iterationIV, numberOfNodes);
+  auto br = cast<BranchInst>(header->getTerminator());
+  BranchInst::Create(chasing.body, chasing.exit, keepIterating, header);
+  br->eraseFromParent();
+  chasing.compare->eraseFromParent();
+
+  /*
+   * Load the pointer of the current iteration at the beginning of the body.
+   */
+  IRBuilder<> bodyBuilder(&*chasing.body->getFirstInsertionPt());
+  auto nodePtr = bodyBuilder.CreateInBoundsGEP(int8Ptr, nodes, iterationIV);
+  auto node = bodyBuilder.CreatePointerCast(
+      bodyBuilder.CreateLoad(int8Ptr, nodePtr),
+      chasing.phi->getType());
+  chasing.phi->replaceAllUsesWith(node);
+  chasing.phi->eraseFromParent();
+  if (chasing.next->use_empty()) {
+    chasing.next->eraseFromParent();
+  }
+
+  return true;
+}
+
+} // namespace arcana::gino
@@ -54,6 +54,21 @@ public:
 
   bool doesHaveASequentialPrologue(LoopContent *LDI) const;
 
+  void enableValueForwarding(void);
+
+  void enableAtomicSequentialSegments(void);
+
+  void enableDependenceDistances(void);
+
+  /*
+   * Use the optimizations below even without profiles.
+   */
+  void enableIterationBatching(uint32_t iterationBatchFactor);
+
+  void enableHelperThreads(void);
+
+  void enableSynchronizationSkipping(void);
+
   uint32_t getMinimumNumberOfIdleCores(void) const override;
 
   std::string getName(void) const override;
@@ -109,13 +124,45 @@ protected:
       LoopContent *originalLDI,
       LoopContent *LDI,
       DataFlowResult *reachabilityDFR,
+      HELIXTask *helixTask,
+      Heuristics *h);
+
+  void partitionSequentialSegments(
+      LoopContent *LDI,
+      Heuristics *h,
+      std::unordered_map<SCC *, SCC *> &taskToOriginalSCCs,
+      std::function<bool(SCC *scc)> requiresSequentialSegment);
+
+  bool canUseCriticalSections(LoopContent *LDI,
+                              std::vector<SequentialSegment *> *sss);
+
+  void identifyAtomicSequentialSegments(LoopContent *LDI,
+                                        std::vector<SequentialSegment *> *sss);
+
+  void lowerAtomicSequentialSegments(std::vector<SequentialSegment *> *sss);
+
+  void computeDependenceDistances(LoopContent *LDI,
+                                  std::vector<SequentialSegment *> *sss,
+                                  HELIXTask *helixTask);
+
+  void identifyRarelyEnteredSequentialSegments(
+      LoopContent *LDI,
+      std::vector<SequentialSegment *> *sss,
       HELIXTask *helixTask);
 
+  bool canEnterSequentialSegment(SequentialSegment *ss,
+                                 Instruction *justAfterEntry,
+                                 BasicBlock *loopHeader);
+
+  void trackIterationIndex(LoopContent *LDI, HELIXTask *helixTask);
+
+  bool usesIterationCounters(uint32_t ssID) const;
+
   void squeezeSequentialSegments(LoopContent *LDI,
                                  std::vector<SequentialSegment *> *sss,
                                  DataFlowResult *reachabilityDFR);
 
-  void scheduleSequentialSegments(LoopContent *LDI,
+  bool scheduleSequentialSegments(LoopContent *LDI,
                                   std::vector<SequentialSegment *> *sss,
                                   DataFlowResult *reachabilityDFR);
 
@@ -123,6 +170,18 @@ protected:
                            std::vector<SequentialSegment *> *sss,
                            HELIXTask *helixTask);
 
+  SequentialSegment *getSequentialSegmentThatStoresSpill(
+      SpilledLoopCarriedDependence *spill,
+      std::vector<SequentialSegment *> *sss);
+
+  void layOutSpilledValues(LoopContent *LDI,
+                           std::vector<SequentialSegment *> *sss,
+                           HELIXTask *helixTask);
+
+  void forwardSpilledValuesWithSignals(LoopContent *LDI,
+                                       std::vector<SequentialSegment *> *sss,
+                                       HELIXTask *helixTask);
+
   virtual CallInst *injectWaitCall(IRBuilder<> &builder, uint32_t ssID);
 
   virtual CallInst *injectSignalCall(IRBuilder<> &builder, uint32_t ssID);
@@ -145,24 +204,61 @@ protected:
 
   void rewireLoopForPeriodicVariables(LoopContent *LDI);
 
+  uint32_t computeIterationBatchFactor(LoopContent *LDI);
+
+  void batchIterations(LoopContent *LDI);
+
+  bool shouldUseHelperThreads(LoopContent *LDI,
+                              uint64_t numberOfSequentialSegments);
+
   BasicBlock *getBasicBlockExecutedOnlyByLastIterationBeforeExitingTask(
       LoopContent *LDI,
       uint32_t taskIndex,
       BasicBlock &bb) override;
 
+  /*
+   * Cycles needed to hand a sequential segment to the next core.
+   */
+  static constexpr double cyclesPerHandoff = 200;
+
+  /*
+   * Largest fraction of iterations that enter a sequential segment for the
+   * other iterations to skip its synchronization.
+   */
+  static constexpr double maximumEntryFrequencyToSkipSynchronization = 0.1;
+
   /*
    * Fields
    */
   Function *waitSSCall, *signalSSCall;
+  Function *waitIterationSSCall, *signalIterationSSCall;
+  Function *waitPrecedingIterationsSSCall;
   LoopContent *originalLDI;
   LoopEnvironmentBuilder *loopCarriedLoopEnvironmentBuilder;
+  Value *loopCarriedArray;
   std::unordered_set<SpilledLoopCarriedDependence *> spills;
   std::unordered_map<Instruction *, Instruction *>
       lastIterationExecutionDuplicateMap;
   BasicBlock *lastIterationExecutionBlock;
+  uint32_t iterationBatchFactor;
+  uint32_t forcedIterationBatchFactor;
+  bool alwaysUseHelperThreads;
+  bool alwaysSkipSynchronization;
+  PHINode *iterationBatchIndex;
+  Value *isLastIterationOfBatch;
+  PHINode *iterationIndex;
+  std::unordered_map<uint32_t, uint64_t> ssDistances;
+  std::unordered_map<uint32_t, Value *> ssProducerPtrs;
+  std::unordered_set<uint32_t> rarelyEnteredSSs;
+  std::unordered_set<uint32_t> atomicSSs;
+  bool useCriticalSections;
+  bool forwardSpilledValues;
+  bool useAtomicSequentialSegments;
+  bool useDependenceDistances;
   bool enableInliner;
   Function *taskDispatcherSS;
   Function *taskDispatcherCS;
+  Function *taskDispatcherSSWithHelpers;
   void squeezeSequentialSegment(LoopContent *LDI,
                                 DataFlowResult *reachabilityDFR,
                                 SequentialSegment *ss);
@@ -173,6 +269,7 @@ private:
   std::string prefixString;
   std::vector<Value *> ssPastPtrs;
   std::vector<Value *> ssFuturePtrs;
+  std::unordered_set<BasicBlock *> taskLoopBlocks;
 };
 
 } // namespace arcana::gino
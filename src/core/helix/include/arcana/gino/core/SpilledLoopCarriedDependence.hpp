@@ -37,6 +37,7 @@ public:
   Value *clonedInitialValue;
   std::unordered_set<LoadInst *> environmentLoads;
   std::unordered_set<StoreInst *> environmentStores;
+  StoreInst *environmentInitialStore;
 
 private:
   PHINode *originalLoopCarriedPHI;
@@ -30,7 +30,19 @@ HELIX::HELIX(Noelle &n, bool forceParallelization)
   : ParallelizationTechniqueForLoopsWithLoopCarriedDataDependences{ n,
                                                                     forceParallelization },
     loopCarriedLoopEnvironmentBuilder{ nullptr },
+    loopCarriedArray{ nullptr },
     lastIterationExecutionBlock{ nullptr },
+    iterationBatchFactor{ 1 },
+    forcedIterationBatchFactor{ 0 },
+    alwaysUseHelperThreads{ false },
+    alwaysSkipSynchronization{ false },
+    iterationBatchIndex{ nullptr },
+    isLastIterationOfBatch{ nullptr },
+    iterationIndex{ nullptr },
+    useCriticalSections{ false },
+    forwardSpilledValues{ false },
+    useAtomicSequentialSegments{ false },
+    useDependenceDistances{ false },
     enableInliner{ true },
     prefixString{ "HELIX: " } {
 
@@ -48,8 +60,15 @@ HELIX::HELIX(Noelle &n, bool forceParallelization)
   this->taskDispatcherCS =
       program->getFunction("NOELLE_HELIX_dispatcher_criticalSections");
   assert(this->taskDispatcherCS != nullptr);
+  this->taskDispatcherSSWithHelpers = program->getFunction(
+      "NOELLE_HELIX_dispatcher_sequentialSegmentsWithHelpers");
+  assert(this->taskDispatcherSSWithHelpers != nullptr);
   this->waitSSCall = program->getFunction("HELIX_wait");
   this->signalSSCall = program->getFunction("HELIX_signal");
+  this->waitIterationSSCall = program->getFunction("HELIX_waitForIteration");
+  this->signalIterationSSCall = program->getFunction("HELIX_signalIteration");
+  this->waitPrecedingIterationsSSCall =
+      program->getFunction("HELIX_waitForPrecedingIterations");
 
   return;
 }
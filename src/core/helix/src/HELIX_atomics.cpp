@@ -0,0 +1,277 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/HELIX.hpp"
+#include "llvm/IR/PatternMatch.h"
+
+using namespace llvm::PatternMatch;
+
+namespace arcana::gino {
+
+/*
+ * An update of a memory location that can be executed by a single atomic
+ * instruction.
+ */
+struct AtomicUpdate {
+  LoadInst *load;
+  StoreInst *store;
+  AtomicRMWInst::BinOp op;
+  Value *operand;
+  std::unordered_set<Instruction *> updateInstructions;
+};
+
+/*
+ * Check if @ss only reads a location of at most a machine word, combines it
+ * with a value computed outside @ss through a commutative operator, and writes
+ * it back (e.g., *p += x, *p = max(*p, x)).
+ */
+static bool isAtomicUpdate(SequentialSegment *ss,
+                           const DataLayout &DL,
+                           AtomicUpdate &update) {
+
+  /*
+   * Fetch the only load and the only store of the sequential segment.
+   */
+  auto ssInstructions = ss->getInstructions();
+  LoadInst *load = nullptr;
+  StoreInst *store = nullptr;
+  for (auto inst : ssInstructions) {
+    if (auto l = dyn_cast<LoadInst>(inst)) {
+      if (load != nullptr) {
+        return false;
+      }
+      load = l;
+    } else if (auto s = dyn_cast<StoreInst>(inst)) {
+      if (store != nullptr) {
+        return false;
+      }
+      store = s;
+    }
+  }
+  if ((load == nullptr) || (store == nullptr) || !load->isSimple()
+      || !store->isSimple()
+      || (load->getPointerOperand() != store->getPointerOperand())) {
+    return false;
+  }
+
+  /*
+   * The location must fit in a machine word.
+   */
+  auto type = load->getType();
+  auto bits = DL.getTypeStoreSizeInBits(type).getFixedSize();
+  if ((type != store->getValueOperand()->getType())
+      || (bits > DL.getPointerSizeInBits())) {
+    return false;
+  }
+
+  /*
+   * Identify the operator that combines the loaded value with the other one.
+   */
+  auto newValue = store->getValueOperand();
+  Value *operand = nullptr;
+  auto op = AtomicRMWInst::BAD_BINOP;
+  if (auto binOp = dyn_cast<BinaryOperator>(newValue)) {
+    if ((binOp->getOperand(0) == load) == (binOp->getOperand(1) == load)) {
+      return false;
+    }
+    operand = (binOp->getOperand(0) == load) ? binOp->getOperand(1)
+                                             : binOp->getOperand(0);
+    switch (binOp->getOpcode()) {
+      case Instruction::Add:
+        op = AtomicRMWInst::Add;
+        break;
+      case Instruction::And:
+        op = AtomicRMWInst::And;
+        break;
+      case Instruction::Or:
+        op = AtomicRMWInst::Or;
+        break;
+      case Instruction::Xor:
+        op = AtomicRMWInst::Xor;
+        break;
+      case Instruction::FAdd:
+        if (binOp->isAssociative()) {
+          op = AtomicRMWInst::FAdd;
+        }
+        break;
+      default:
+        break;
+    }
+  } else if (match(newValue, m_c_SMax(m_Specific(load), m_Value(operand)))) {
+    op = AtomicRMWInst::Max;
+  } else if (match(newValue, m_c_SMin(m_Specific(load), m_Value(operand)))) {
+    op = AtomicRMWInst::Min;
+  } else if (match(newValue, m_c_UMax(m_Specific(load), m_Value(operand)))) {
+    op = AtomicRMWInst::UMax;
+  } else if (match(newValue, m_c_UMin(m_Specific(load), m_Value(operand)))) {
+    op = AtomicRMWInst::UMin;
+  }
+  if (op == AtomicRMWInst::BAD_BINOP) {
+    return false;
+  }
+  if (op != AtomicRMWInst::FAdd) {
+    if (!type->isIntegerTy() || (bits < 8) || !isPowerOf2_64(bits)) {
+      return false;
+    }
+  } else if (!type->isFloatTy() && !type->isDoubleTy()) {
+    return false;
+  }
+
+  /*
+   * Collect the instructions that compute the new value.
+   * A min/max is a select fed by a compare.
+   */
+  std::unordered_set<Instruction *> updateInstructions;
+  auto newValueInst = cast<Instruction>(newValue);
+  updateInstructions.insert(newValueInst);
+  if (auto select = dyn_cast<SelectInst>(newValueInst)) {
+    auto compare = dyn_cast<CmpInst>(select->getCondition());
+    if (compare == nullptr) {
+      return false;
+    }
+    updateInstructions.insert(compare);
+  }
+
+  /*
+   * The sequential segment must not include anything else, and the loaded and
+   * the new values must not be used anywhere else.
+   */
+  if (ssInstructions.size() != (updateInstructions.size() + 2)) {
+    return false;
+  }
+  for (auto inst : updateInstructions) {
+    if (ssInstructions.find(inst) == ssInstructions.end()) {
+      return false;
+    }
+  }
+  if (ssInstructions.find(dyn_cast<Instruction>(operand))
+      != ssInstructions.end()) {
+    return false;
+  }
+  for (auto user : load->users()) {
+    if (updateInstructions.find(cast<Instruction>(user))
+        == updateInstructions.end()) {
+      return false;
+    }
+  }
+  for (auto inst : updateInstructions) {
+    for (auto user : inst->users()) {
+      auto userInst = cast<Instruction>(user);
+      if ((userInst != store)
+          && (updateInstructions.find(userInst) == updateInstructions.end())) {
+        return false;
+      }
+    }
+  }
+
+  update.load = load;
+  update.store = store;
+  update.op = op;
+  update.operand = operand;
+  update.updateInstructions = updateInstructions;
+
+  return true;
+}
+
+void HELIX::enableAtomicSequentialSegments(void) {
+  this->useAtomicSequentialSegments = true;
+
+  return;
+}
+
+void HELIX::identifyAtomicSequentialSegments(
+    LoopContent *LDI,
+    std::vector<SequentialSegment *> *sss) {
+  this->atomicSSs.clear();
+  if (!this->useAtomicSequentialSegments) {
+    return;
+  }
+
+  /*
+   * The code executed only by the last iteration must run after every update.
+   */
+  if (this->lastIterationExecutionBlock != nullptr) {
+    return;
+  }
+
+  /*
+   * Identify the sequential segments that are a single atomic update.
+   */
+  auto &DL = this->noelle.getProgram()->getDataLayout();
+  for (auto ss : *sss) {
+    AtomicUpdate update;
+    if (!isAtomicUpdate(ss, DL, update)) {
+      continue;
+    }
+    this->atomicSSs.insert(ss->getID());
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << this->prefixString << "  Sequential segment " << ss->getID()
+             << " is a single commutative update: use "
+             << AtomicRMWInst::getOperationName(update.op) << "\n";
+    }
+  }
+
+  return;
+}
+
+void HELIX::lowerAtomicSequentialSegments(
+    std::vector<SequentialSegment *> *sss) {
+  auto &DL = this->noelle.getProgram()->getDataLayout();
+  for (auto ss : *sss) {
+    if (this->atomicSSs.find(ss->getID()) == this->atomicSSs.end()) {
+      continue;
+    }
+    AtomicUpdate update;
+    if (!isAtomicUpdate(ss, DL, update)) {
+      errs() << this->prefixString << "ERROR = sequential segment "
+             << ss->getID() << " is no longer a single update\n";
+      abort();
+    }
+
+    /*
+     * Replace the update with an atomic instruction.
+     * The update does not order any other memory access, so it can be relaxed.
+     */
+    IRBuilder<> builder(update.store);
+    builder.CreateAtomicRMW(update.op,
+                            update.store->getPointerOperand(),
+                            update.operand,
+                            update.store->getAlign(),
+                            AtomicOrdering::Monotonic);
+
+    /*
+     * Remove the original update.
+     */
+    auto newValue = cast<Instruction>(update.store->getValueOperand());
+    update.store->eraseFromParent();
+    newValue->eraseFromParent();
+    for (auto inst : update.updateInstructions) {
+      if (inst != newValue) {
+        inst->eraseFromParent();
+      }
+    }
+    update.load->eraseFromParent();
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
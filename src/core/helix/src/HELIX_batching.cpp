@@ -0,0 +1,200 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cmath>
+#include "arcana/noelle/core/PeriodicVariableSCC.hpp"
+#include "arcana/gino/core/HELIX.hpp"
+
+namespace arcana::gino {
+
+/*
+ * Maximum number of consecutive iterations executed by a core per turn.
+ */
+static const uint32_t maximumIterationBatchFactor = 64;
+
+void HELIX::enableIterationBatching(uint32_t iterationBatchFactor) {
+  this->forcedIterationBatchFactor =
+      std::min(iterationBatchFactor, maximumIterationBatchFactor);
+
+  return;
+}
+
+void HELIX::enableHelperThreads(void) {
+  this->alwaysUseHelperThreads = true;
+
+  return;
+}
+
+uint32_t HELIX::computeIterationBatchFactor(LoopContent *LDI) {
+
+  /*
+   * Periodic variables are rewired assuming a core executes one iteration per
+   * turn.
+   */
+  auto sccManager = LDI->getSCCManager();
+  if (sccManager->getSCCsOfKind(GenericSCC::SCCKind::PERIODIC_VARIABLE).size()
+      > 0) {
+    return 1;
+  }
+
+  /*
+   * Check if the number of iterations to batch has been chosen already.
+   */
+  if (this->forcedIterationBatchFactor > 1) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << this->prefixString << "  Batch "
+             << this->forcedIterationBatchFactor << " iterations\n";
+    }
+    return this->forcedIterationBatchFactor;
+  }
+
+  /*
+   * Without profiles, iterations are not batched.
+   */
+  auto profiles = this->noelle.getProfiles();
+  auto loopStructure = LDI->getLoopStructure();
+  if (!profiles->isAvailable() || !profiles->hasBeenExecuted(loopStructure)) {
+    return 1;
+  }
+
+  /*
+   * Batch enough iterations to amortize a handoff over the instructions that
+   * run sequentially in a batch.
+   */
+  auto instructionsPerIteration =
+      profiles->getAverageTotalInstructionsPerIteration(loopStructure);
+  auto sequentialInstructionsPerIteration =
+      instructionsPerIteration
+      * this->computeSequentialFractionOfExecution(LDI);
+  if (sequentialInstructionsPerIteration < 1) {
+    return 1;
+  }
+  auto batchFactor = (uint64_t)std::ceil(cyclesPerHandoff
+                                         / sequentialInstructionsPerIteration);
+
+  /*
+   * Every core must still get at least one batch per invocation.
+   */
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto cores = std::max<uint64_t>(ltm->getMaximumNumberOfCores(), 1);
+  auto iterations =
+      profiles->getAverageLoopIterationsPerInvocation(loopStructure);
+  batchFactor = std::min<uint64_t>(batchFactor, iterations / cores);
+  batchFactor = std::min<uint64_t>(batchFactor, maximumIterationBatchFactor);
+  batchFactor = std::max<uint64_t>(batchFactor, 1);
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << this->prefixString << "  " << sequentialInstructionsPerIteration
+           << " sequential instructions out of " << instructionsPerIteration
+           << " per iteration: batch " << batchFactor << " iterations\n";
+  }
+
+  return batchFactor;
+}
+
+void HELIX::batchIterations(LoopContent *LDI) {
+  assert(this->iterationBatchFactor > 1);
+
+  /*
+   * Fetch the header, pre-header, and latches of the loop within the task.
+   */
+  auto task = static_cast<HELIXTask *>(this->tasks[0]);
+  auto loopStructure = LDI->getLoopStructure();
+  auto headerClone =
+      task->getCloneOfOriginalBasicBlock(loopStructure->getHeader());
+  std::unordered_set<BasicBlock *> latchClones;
+  for (auto latch : loopStructure->getLatches()) {
+    latchClones.insert(task->getCloneOfOriginalBasicBlock(latch));
+  }
+
+  /*
+   * Track the position of the current iteration within its batch.
+   */
+  auto tm = this->noelle.getTypesManager();
+  auto int64 = tm->getIntegerType(64);
+  auto cm = this->noelle.getConstantsManager();
+  auto const0 = cm->getIntegerConstant(0, int64);
+  auto const1 = cm->getIntegerConstant(1, int64);
+  auto lastIndex =
+      cm->getIntegerConstant(this->iterationBatchFactor - 1, int64);
+  IRBuilder<> headerBuilder(&*headerClone->begin());
+  auto batchIndex = headerBuilder.CreatePHI(int64, 2, "batch.index");
+  this->iterationBatchIndex = batchIndex;
+  headerBuilder.SetInsertPoint(headerClone->getFirstNonPHI());
+  this->isLastIterationOfBatch =
+      headerBuilder.CreateICmpEQ(batchIndex, lastIndex);
+  for (auto pred : predecessors(headerClone)) {
+    if (latchClones.find(pred) == latchClones.end()) {
+      batchIndex->addIncoming(const0, pred);
+      continue;
+    }
+    IRBuilder<> latchBuilder(pred->getTerminator());
+    auto nextIndex =
+        latchBuilder.CreateSelect(this->isLastIterationOfBatch,
+                                  const0,
+                                  latchBuilder.CreateAdd(batchIndex, const1));
+    batchIndex->addIncoming(nextIndex, pred);
+  }
+
+  return;
+}
+
+bool HELIX::shouldUseHelperThreads(LoopContent *LDI,
+                                   uint64_t numberOfSequentialSegments) {
+
+  /*
+   * Helpers prefetch the lines of sequential segments, so there must be some.
+   */
+  if (numberOfSequentialSegments == 0) {
+    return false;
+  }
+  if (this->alwaysUseHelperThreads) {
+    return true;
+  }
+
+  /*
+   * Without profiles, we cannot tell how long cores wait for each other.
+   */
+  auto profiles = this->noelle.getProfiles();
+  auto loopStructure = LDI->getLoopStructure();
+  if (!profiles->isAvailable() || !profiles->hasBeenExecuted(loopStructure)) {
+    return false;
+  }
+
+  /*
+   * Helpers pay off when the handoffs of a batch take at least as long as the
+   * instructions of that batch.
+   */
+  auto instructionsPerBatch =
+      profiles->getAverageTotalInstructionsPerIteration(loopStructure)
+      * this->iterationBatchFactor;
+  auto cyclesWaitedPerBatch = cyclesPerHandoff * numberOfSequentialSegments;
+  auto useHelpers = cyclesWaitedPerBatch >= instructionsPerBatch;
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << this->prefixString << "  " << cyclesWaitedPerBatch
+           << " cycles waited per " << instructionsPerBatch
+           << " instructions: helper threads "
+           << (useHelpers ? "enabled" : "disabled") << "\n";
+  }
+
+  return useHelpers;
+}
+
+} // namespace arcana::gino
@@ -0,0 +1,313 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/HELIX.hpp"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/ADT/Triple.h"
+#include <numeric>
+
+namespace arcana::gino {
+
+/*
+ * Return the number of iterations between the two ends of every loop-carried
+ * memory dependence of the sequential segment.
+ * The distance is 1 when it cannot be proved to be larger.
+ */
+static uint64_t computeDependenceDistance(SequentialSegment *ss,
+                                          HELIXTask *helixTask,
+                                          ScalarEvolution &SE,
+                                          Loop *originalLoop,
+                                          const DataLayout &DL) {
+
+  /*
+   * Collect the memory accesses of the sequential segment.
+   * Only plain loads and stores of the original loop are analyzable.
+   */
+  std::vector<Instruction *> accesses;
+  for (auto cloneI : ss->getInstructions()) {
+    if (isa<PHINode>(cloneI) || cloneI->isTerminator()) {
+      return 1;
+    }
+    if (!cloneI->mayReadOrWriteMemory()) {
+      continue;
+    }
+    auto originalI = helixTask->getOriginalInstructionOfClone(cloneI);
+    if (originalI == nullptr) {
+      return 1;
+    }
+    if (auto load = dyn_cast<LoadInst>(originalI)) {
+      if (!load->isSimple()) {
+        return 1;
+      }
+    } else if (auto store = dyn_cast<StoreInst>(originalI)) {
+      if (!store->isSimple()) {
+        return 1;
+      }
+    } else {
+      return 1;
+    }
+    accesses.push_back(originalI);
+  }
+
+  /*
+   * Each pair of accesses that includes a store must walk the same memory
+   * with the same stride.
+   * Their distance is then the constant offset between them in strides.
+   * Waiting for iteration i - d only orders iteration i after i - 2d, i - 3d,
+   * ..., so d must divide the distance of every pair (e.g., distances 4 and 6
+   * give d = 2).
+   */
+  auto getAccessType = [](Instruction *i) -> Type * {
+    if (auto store = dyn_cast<StoreInst>(i)) {
+      return store->getValueOperand()->getType();
+    }
+    return i->getType();
+  };
+  uint64_t distance = 0;
+  for (auto i = 0u; i < accesses.size(); i++) {
+    for (auto j = i; j < accesses.size(); j++) {
+      auto a = accesses[i];
+      auto b = accesses[j];
+      if (!isa<StoreInst>(a) && !isa<StoreInst>(b)) {
+        continue;
+      }
+
+      /*
+       * Fetch the evolution of the two addresses.
+       */
+      auto aSCEV = dyn_cast<SCEVAddRecExpr>(
+          SE.getSCEV(getLoadStorePointerOperand(a)));
+      auto bSCEV = dyn_cast<SCEVAddRecExpr>(
+          SE.getSCEV(getLoadStorePointerOperand(b)));
+      if ((aSCEV == nullptr) || (bSCEV == nullptr)
+          || (aSCEV->getLoop() != originalLoop)
+          || (bSCEV->getLoop() != originalLoop) || !aSCEV->isAffine()
+          || !bSCEV->isAffine()) {
+        return 1;
+      }
+      auto aStep = dyn_cast<SCEVConstant>(aSCEV->getStepRecurrence(SE));
+      auto bStep = dyn_cast<SCEVConstant>(bSCEV->getStepRecurrence(SE));
+      if ((aStep == nullptr) || (bStep == nullptr)
+          || (aStep->getAPInt() != bStep->getAPInt())) {
+        return 1;
+      }
+
+      /*
+       * Accesses of consecutive iterations must not overlap.
+       */
+      auto step = aStep->getAPInt().getSExtValue();
+      auto aSize = DL.getTypeStoreSize(getAccessType(a)).getFixedSize();
+      auto bSize = DL.getTypeStoreSize(getAccessType(b)).getFixedSize();
+      if ((step == 0) || (aSize != bSize)
+          || ((uint64_t)std::abs(step) < aSize)) {
+        return 1;
+      }
+
+      /*
+       * Compute the number of iterations between the two accesses.
+       */
+      auto diff = dyn_cast<SCEVConstant>(SE.getMinusSCEV(aSCEV, bSCEV));
+      if (diff == nullptr) {
+        return 1;
+      }
+      auto bytes = diff->getAPInt().getSExtValue();
+      if ((bytes % step) != 0) {
+        return 1;
+      }
+      uint64_t iterations = std::abs(bytes / step);
+      if (iterations == 0) {
+        continue;
+      }
+      distance = std::gcd(distance, iterations);
+    }
+  }
+  if (distance == 0) {
+    return 1;
+  }
+
+  return distance;
+}
+
+void HELIX::enableDependenceDistances(void) {
+  this->useDependenceDistances = true;
+
+  return;
+}
+
+void HELIX::computeDependenceDistances(LoopContent *LDI,
+                                       std::vector<SequentialSegment *> *sss,
+                                       HELIXTask *helixTask) {
+  this->ssDistances.clear();
+  this->ssProducerPtrs.clear();
+  this->iterationIndex = nullptr;
+  if (!this->useDependenceDistances) {
+    return;
+  }
+
+  /*
+   * Critical sections do not order iterations.
+   * A batch of iterations synchronizes once, so it cannot wait for a single
+   * iteration.
+   * The code executed only by the last iteration must run after every other
+   * iteration.
+   */
+  if ((sss->size() == 0) || this->useCriticalSections
+      || (this->iterationBatchFactor > 1)
+      || (this->lastIterationExecutionBlock != nullptr)) {
+    return;
+  }
+
+  /*
+   * Fetch the sequential segment that decides whether the loop continues.
+   * It must keep synchronizing with the previous iteration.
+   */
+  auto preambleSCC =
+      this->getTheSequentialSCCThatCreatesTheSequentialPrologue(LDI);
+
+  /*
+   * Compute the scalar evolution of the original loop.
+   */
+  auto program = this->noelle.getProgram();
+  auto &DL = program->getDataLayout();
+  auto originalHeader = this->originalLDI->getLoopStructure()->getHeader();
+  auto &originalFunction = *originalHeader->getParent();
+  DominatorTree DT(originalFunction);
+  LoopInfo LI(DT);
+  AssumptionCache AC(originalFunction);
+  TargetLibraryInfoImpl TLII(Triple(program->getTargetTriple()));
+  TargetLibraryInfo TLI(TLII);
+  ScalarEvolution SE(originalFunction, TLI, AC, DT, LI);
+  auto originalLoop = LI.getLoopFor(originalHeader);
+  assert(originalLoop != nullptr);
+
+  /*
+   * Compute the dependence distance of each sequential segment.
+   */
+  for (auto ss : *sss) {
+    auto isPreamble = false;
+    for (auto scc : ss->getSCCs()) {
+      isPreamble |= (scc == preambleSCC);
+    }
+    if (isPreamble
+        || (this->atomicSSs.find(ss->getID()) != this->atomicSSs.end())) {
+      continue;
+    }
+    auto distance = computeDependenceDistance(ss,
+                                              helixTask,
+                                              SE,
+                                              originalLoop,
+                                              DL);
+    if (distance <= 1) {
+      continue;
+    }
+    this->ssDistances[ss->getID()] = distance;
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << this->prefixString << "  Sequential segment " << ss->getID()
+             << " has dependence distance " << distance << "\n";
+    }
+  }
+  if (this->ssDistances.size() == 0) {
+    return;
+  }
+
+  /*
+   * Track the index of the current iteration.
+   */
+  this->trackIterationIndex(LDI, helixTask);
+
+  /*
+   * Compute the line of each sequential segment in the array of the core that
+   * executes the iteration d positions back.
+   * The arrays of the cores are contiguous.
+   */
+  auto tm = this->noelle.getTypesManager();
+  auto int64 = tm->getIntegerType(64);
+  IRBuilder<> entryBuilder{ helixTask->getEntry()->getTerminator() };
+  auto core = entryBuilder.CreateZExtOrTrunc(helixTask->coreArg, int64);
+  auto numCores = entryBuilder.CreateZExtOrTrunc(helixTask->numCoresArg, int64);
+  auto lineBytes = Architecture::getCacheLineBytes();
+  auto ssArraySize = ConstantInt::get(int64, sss->size() * lineBytes);
+  auto ownArray = entryBuilder.CreatePtrToInt(helixTask->ssPastArrayArg, int64);
+  auto firstArray =
+      entryBuilder.CreateSub(ownArray,
+                             entryBuilder.CreateMul(core, ssArraySize));
+  for (auto ssDistance : this->ssDistances) {
+    auto ssID = ssDistance.first;
+    auto distance = ConstantInt::get(int64, ssDistance.second);
+    auto back = entryBuilder.CreateURem(distance, numCores);
+    auto producer = entryBuilder.CreateURem(
+        entryBuilder.CreateSub(entryBuilder.CreateAdd(core, numCores), back),
+        numCores);
+    auto producerArray =
+        entryBuilder.CreateAdd(firstArray,
+                               entryBuilder.CreateMul(producer, ssArraySize));
+    auto producerLine = entryBuilder.CreateAdd(
+        producerArray,
+        ConstantInt::get(int64, ssID * lineBytes));
+    this->ssProducerPtrs[ssID] =
+        entryBuilder.CreateIntToPtr(producerLine,
+                                    helixTask->ssPastArrayArg->getType());
+  }
+
+  return;
+}
+
+void HELIX::trackIterationIndex(LoopContent *LDI, HELIXTask *helixTask) {
+  if (this->iterationIndex != nullptr) {
+    return;
+  }
+
+  /*
+   * Core c executes iterations c, c + N, c + 2N, ...
+   */
+  auto tm = this->noelle.getTypesManager();
+  auto int64 = tm->getIntegerType(64);
+  auto loopStructure = LDI->getLoopStructure();
+  auto loopHeader = loopStructure->getHeader();
+  auto loopLatches = loopStructure->getLatches();
+  IRBuilder<> entryBuilder{ helixTask->getEntry()->getTerminator() };
+  auto core = entryBuilder.CreateZExtOrTrunc(helixTask->coreArg, int64);
+  auto numCores = entryBuilder.CreateZExtOrTrunc(helixTask->numCoresArg, int64);
+  IRBuilder<> headerBuilder(&*loopHeader->begin());
+  auto index = headerBuilder.CreatePHI(int64, 2, "iteration.index");
+  this->iterationIndex = index;
+  for (auto pred : predecessors(loopHeader)) {
+    if (loopLatches.find(pred) == loopLatches.end()) {
+      index->addIncoming(core, pred);
+      continue;
+    }
+    IRBuilder<> latchBuilder(pred->getTerminator());
+    index->addIncoming(latchBuilder.CreateAdd(index, numCores), pred);
+  }
+
+  return;
+}
+
+bool HELIX::usesIterationCounters(uint32_t ssID) const {
+  return (this->ssDistances.find(ssID) != this->ssDistances.end())
+         || (this->rarelyEnteredSSs.find(ssID) != this->rarelyEnteredSSs.end());
+}
+
+} // namespace arcana::gino
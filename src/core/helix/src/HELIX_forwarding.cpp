@@ -0,0 +1,165 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/HELIX.hpp"
+
+namespace arcana::gino {
+
+/*
+ * Offset within the line of a sequential segment of the first value
+ * forwarded with its signal.
+ * The bytes before it hold the synchronization word.
+ */
+static const uint64_t firstForwardedValueOffset = 8;
+
+void HELIX::enableValueForwarding(void) {
+  this->forwardSpilledValues = true;
+
+  return;
+}
+
+void HELIX::forwardSpilledValuesWithSignals(
+    LoopContent *LDI,
+    std::vector<SequentialSegment *> *sss,
+    HELIXTask *helixTask) {
+  if (!this->forwardSpilledValues) {
+    return;
+  }
+
+  /*
+   * Fetch the data layout and the types.
+   */
+  auto program = this->noelle.getProgram();
+  auto &DL = program->getDataLayout();
+  auto tm = this->noelle.getTypesManager();
+  auto int8 = tm->getIntegerType(8);
+  auto lineBytes = Architecture::getCacheLineBytes();
+
+  /*
+   * Assign the spilled values to the line of the sequential segment that
+   * stores them.
+   * A value that does not fit in the line remains in the loop-carried
+   * environment.
+   */
+  IRBuilder<> entryBuilder{ helixTask->getEntry()->getTerminator() };
+  std::unordered_map<SequentialSegment *, uint64_t> nextOffsets;
+  std::unordered_map<SequentialSegment *,
+                     std::vector<std::pair<Value *, Value *>>>
+      forwardedValues;
+  for (auto spill : this->spills) {
+
+    /*
+     * Fetch the sequential segment that includes every store of the spilled
+     * value.
+     */
+    auto spillSS = this->getSequentialSegmentThatStoresSpill(spill, sss);
+    if ((spillSS == nullptr)
+        || this->usesIterationCounters(spillSS->getID())) {
+      continue;
+    }
+
+    /*
+     * Check if the value fits in the line of the sequential segment.
+     */
+    auto spillEnvPtr = (*spill->environmentStores.begin())->getPointerOperand();
+    auto valueType = spillEnvPtr->getType()->getPointerElementType();
+    if (nextOffsets.find(spillSS) == nextOffsets.end()) {
+      nextOffsets[spillSS] = firstForwardedValueOffset;
+    }
+    auto offset = alignTo(nextOffsets[spillSS],
+                          DL.getABITypeAlign(valueType).value());
+    auto valueBytes = DL.getTypeAllocSize(valueType).getFixedSize();
+    if ((offset + valueBytes) > lineBytes) {
+      continue;
+    }
+    nextOffsets[spillSS] = offset + valueBytes;
+
+    /*
+     * Compute the pointers to the value within the lines of the previous and
+     * the next core.
+     */
+    auto valuePtrType = PointerType::getUnqual(valueType);
+    auto pastLine = entryBuilder.CreateBitCast(
+        this->ssPastPtrs.at(spillSS->getID()),
+        PointerType::getUnqual(int8));
+    auto pastPtr = entryBuilder.CreateBitCast(
+        entryBuilder.CreateConstInBoundsGEP1_64(int8, pastLine, offset),
+        valuePtrType);
+    auto futureLine = entryBuilder.CreateBitCast(
+        this->ssFuturePtrs.at(spillSS->getID()),
+        PointerType::getUnqual(int8));
+    auto futurePtr = entryBuilder.CreateBitCast(
+        entryBuilder.CreateConstInBoundsGEP1_64(int8, futureLine, offset),
+        valuePtrType);
+
+    /*
+     * The value of the current iteration lives in the line of the next core.
+     * This line is published by the signal.
+     */
+    spillEnvPtr->replaceAllUsesWith(futurePtr);
+
+    /*
+     * The first core starts from the value stored in the environment before
+     * the loop.
+     * Other cores store that value in a stack variable so they do not write
+     * the line of another core.
+     */
+    auto initialValue = entryBuilder.CreateLoad(valueType, spillEnvPtr);
+    auto isFirstCore = entryBuilder.CreateICmpEQ(
+        helixTask->coreArg,
+        ConstantInt::get(helixTask->coreArg->getType(), 0));
+    auto scratchPtr = helixTask->newStackVariable(valueType);
+    entryBuilder.CreateStore(
+        initialValue,
+        entryBuilder.CreateSelect(isFirstCore, pastPtr, scratchPtr));
+
+    forwardedValues[spillSS].push_back(std::make_pair(pastPtr, futurePtr));
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << this->prefixString << "  Forward " << *spill->getOriginal()
+             << " with the signal of sequential segment " << spillSS->getID()
+             << "\n";
+    }
+  }
+
+  /*
+   * After waiting, copy the values received from the previous core to the
+   * line of the next core.
+   * Hence, iterations that do not update a value still forward it.
+   */
+  for (auto ssValues : forwardedValues) {
+    auto pastSSPtr = this->ssPastPtrs.at(ssValues.first->getID());
+    for (auto wait : helixTask->waits) {
+      if (wait->getArgOperand(0) != pastSSPtr) {
+        continue;
+      }
+      IRBuilder<> copyBuilder(wait->getNextNode());
+      for (auto pointers : ssValues.second) {
+        auto valueType = pointers.first->getType()->getPointerElementType();
+        auto value = copyBuilder.CreateLoad(valueType, pointers.first);
+        copyBuilder.CreateStore(value, pointers.second);
+      }
+    }
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -49,8 +49,11 @@ void HELIX::invokeParallelizedLoop(LoopContent *LDI,
    * Fetch the pointer to the environments
    */
   auto envPtr = envBuilder->getEnvironmentArrayVoidPtr();
-  auto loopCarriedEnvPtr =
-      this->loopCarriedLoopEnvironmentBuilder->getEnvironmentArrayVoidPtr();
+  auto loopCarriedEnvPtr = this->loopCarriedArray;
+  if (loopCarriedEnvPtr == nullptr) {
+    loopCarriedEnvPtr =
+        this->loopCarriedLoopEnvironmentBuilder->getEnvironmentArrayVoidPtr();
+  }
 
   /*
    * Fetch the number of cores
@@ -63,12 +66,25 @@ void HELIX::invokeParallelizedLoop(LoopContent *LDI,
    */
   auto numOfSS = cm->getIntegerConstant(numberOfSequentialSegments, 64);
 
+  /*
+   * Pick the dispatcher.
+   * Critical sections do not order the segments across cores.
+   * Helper threads keep the sequential-segment lines close to the workers
+   * when waiting for them dominates the execution of the loop.
+   */
+  auto dispatcher = this->taskDispatcherSS;
+  if (this->useCriticalSections) {
+    dispatcher = this->taskDispatcherCS;
+  } else if (this->shouldUseHelperThreads(LDI, numberOfSequentialSegments)) {
+    dispatcher = this->taskDispatcherSSWithHelpers;
+  }
+
   /*
    * Call the function that incudes the parallelized loop.
    */
   IRBuilder<> helixBuilder(this->entryPointOfParallelizedLoop);
   auto runtimeCall = helixBuilder.CreateCall(
-      this->taskDispatcherSS,
+      dispatcher,
       ArrayRef<Value *>({ (Value *)tasks[0]->getTaskBody(),
                           envPtr,
                           loopCarriedEnvPtr,
@@ -91,6 +91,14 @@ HELIXTask *HELIX::createParallelizableTask(LoopContent *LDI, Heuristics *h) {
         << "ERROR = sync functions HELIX_wait, HELIX_signal were not both found.\n";
     abort();
   }
+  if (!this->waitIterationSSCall || !this->signalIterationSSCall
+      || !this->waitPrecedingIterationsSSCall) {
+    errs() << this->prefixString
+           << "ERROR = sync functions HELIX_waitForIteration, "
+              "HELIX_signalIteration, HELIX_waitForPrecedingIterations were "
+              "not all found.\n";
+    abort();
+  }
 
   /*
    * Fetch the header.
@@ -302,6 +310,7 @@ HELIXTask *HELIX::createParallelizableTask(LoopContent *LDI, Heuristics *h) {
   if (this->verbose >= Verbosity::Maximal) {
     errs() << this->prefixString << "  Adjusting loop IVs\n";
   }
+  this->iterationBatchFactor = this->computeIterationBatchFactor(LDI);
   this->rewireLoopForIVsToIterateNthIterations(LDI);
   this->rewireLoopForPeriodicVariables(LDI);
   /*
@@ -335,7 +344,8 @@ bool HELIX::synchronizeTask(LoopContent *LDI,
   auto sequentialSegments = this->identifySequentialSegments(this->originalLDI,
                                                              LDI,
                                                              reachabilityDFR,
-                                                             helixTask);
+                                                             helixTask,
+                                                             h);
   this->squeezeSequentialSegments(LDI, &sequentialSegments, reachabilityDFR);
 
   /*
@@ -357,7 +367,8 @@ bool HELIX::synchronizeTask(LoopContent *LDI,
   sequentialSegments = this->identifySequentialSegments(this->originalLDI,
                                                         LDI,
                                                         reachabilityDFR,
-                                                        helixTask);
+                                                        helixTask,
+                                                        h);
   if (this->verbose >= Verbosity::Maximal) {
     errs() << this->prefixString << "    There are "
            << sequentialSegments.size() << " sequential segments\n";
@@ -367,7 +378,25 @@ bool HELIX::synchronizeTask(LoopContent *LDI,
    * Schedule the sequential segments to overlap parallel and sequential
    * segments.
    */
-  this->scheduleSequentialSegments(LDI, &sequentialSegments, reachabilityDFR);
+  if (this->scheduleSequentialSegments(LDI,
+                                       &sequentialSegments,
+                                       reachabilityDFR)) {
+
+    /*
+     * Instructions have moved, so the entry and exit frontiers of the
+     * sequential segments need to be computed again.
+     */
+    delete reachabilityDFR;
+    for (auto ss : sequentialSegments) {
+      delete ss;
+    }
+    reachabilityDFR = this->computeReachabilityFromInstructions(LDI);
+    sequentialSegments = this->identifySequentialSegments(this->originalLDI,
+                                                          LDI,
+                                                          reachabilityDFR,
+                                                          helixTask,
+                                                          h);
+  }
 
   /*
    * Delete reachability results here before we decide whether to continue with
@@ -375,6 +404,30 @@ bool HELIX::synchronizeTask(LoopContent *LDI,
    */
   delete reachabilityDFR;
 
+  /*
+   * Identify the sequential segments that are a single commutative update of a
+   * machine word.
+   * They will become atomic instructions and will not be synchronized.
+   */
+  this->identifyAtomicSequentialSegments(LDI, &sequentialSegments);
+
+  /*
+   * Check if the sequential segments only need mutual exclusion.
+   * Otherwise, compute how many iterations back each sequential segment
+   * depends on.
+   */
+  this->useCriticalSections =
+      this->canUseCriticalSections(LDI, &sequentialSegments);
+  this->computeDependenceDistances(LDI, &sequentialSegments, helixTask);
+
+  /*
+   * Iterations that do not enter a rarely entered sequential segment do not
+   * have to wait for it.
+   */
+  this->identifyRarelyEnteredSequentialSegments(LDI,
+                                                &sequentialSegments,
+                                                helixTask);
+
   /*
    * Check if any sequential segment's entry and exit frontier spans the entire
    * loop execution If so, do not parallelize
@@ -393,6 +446,17 @@ bool HELIX::synchronizeTask(LoopContent *LDI,
       if (!entryAtHeader || !exitAtLatch)
         continue;
 
+      /*
+       * A sequential segment that depends on an older iteration than the
+       * previous one, that is rarely entered, or that is a single atomic
+       * update still overlaps across iterations.
+       */
+      if (this->usesIterationCounters(sequentialSegment->getID())
+          || (this->atomicSSs.find(sequentialSegment->getID())
+              != this->atomicSSs.end())) {
+        continue;
+      }
+
       /*
        * The HELIX parallelization isn't worth it.
        */
@@ -419,6 +483,14 @@ bool HELIX::synchronizeTask(LoopContent *LDI,
     errs() << "HELIX:  Synchronizing sequential segments\n";
   }
   this->addSynchronizations(LDI, &sequentialSegments, helixTask);
+  this->lowerAtomicSequentialSegments(&sequentialSegments);
+
+  /*
+   * Lay out the spilled values by the sequential segments that store them.
+   * Then, forward the small ones within the lines of the sequential segments.
+   */
+  this->layOutSpilledValues(LDI, &sequentialSegments, helixTask);
+  this->forwardSpilledValuesWithSignals(LDI, &sequentialSegments, helixTask);
 
   /*
    * Store final results of loop live-out variables.
@@ -478,6 +550,12 @@ bool HELIX::synchronizeTask(LoopContent *LDI,
   this->generateCodeToStoreLiveOutVariables(this->originalLDI, 0);
   this->generateCodeToStoreExitBlockIndex(this->originalLDI, 0);
 
+  /*
+   * Let the compiler know which memory the task can access through its
+   * live-in pointers.
+   */
+  this->propagateAliasInformationToTask(this->originalLDI, 0);
+
   /*
    * HACK: reset the last clone map to reflect the loop exit block which is the
    * successor to the if else branch determining whether to execute the last
@@ -515,6 +593,16 @@ bool HELIX::synchronizeTask(LoopContent *LDI,
     this->makePRVGsReentrant();
   }
 
+  /*
+   * Use the thread-caching allocator for the memory allocated by the task.
+   */
+  if (this->useThreadCachingAllocator) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << "HELIX:  Use the thread-caching allocator\n";
+    }
+    this->substituteMemoryAllocators();
+  }
+
   /*
    * Print the HELIX task.
    */
@@ -19,6 +19,7 @@
  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
  OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/IR/CFG.h"
 #include "arcana/gino/core/HELIX.hpp"
 #include "arcana/noelle/core/SCCPartitionScheduler.hpp"
@@ -26,6 +27,328 @@
 using namespace llvm;
 using namespace arcana::gino;
 
+/*
+ * Check if @i and @j must keep their relative order within an iteration.
+ */
+static bool mustBeOrdered(PDG *taskDG, Instruction *i, Instruction *j) {
+
+  /*
+   * Check register dependences.
+   */
+  for (auto &op : i->operands()) {
+    if (op.get() == j) {
+      return true;
+    }
+  }
+  for (auto &op : j->operands()) {
+    if (op.get() == i) {
+      return true;
+    }
+  }
+
+  /*
+   * Calls can have effects that are not captured by the dependence graph
+   * (e.g., they may not return).
+   */
+  if ((isa<CallBase>(i) || isa<CallBase>(j)) && i->mayHaveSideEffects()
+      && j->mayHaveSideEffects()) {
+    return true;
+  }
+
+  /*
+   * Check the dependences of the task.
+   * Instructions added to the task after computing its dependence graph are
+   * conservatively assumed to depend on all memory instructions.
+   */
+  auto iNode = taskDG->fetchNode(i);
+  if ((iNode == nullptr) || (taskDG->fetchNode(j) == nullptr)) {
+    return i->mayReadOrWriteMemory() && j->mayReadOrWriteMemory();
+  }
+  for (auto edge : iNode->getOutgoingEdges()) {
+    if ((edge->getDst() == j) && !isa<ControlDependence<Value, Value>>(edge)) {
+      return true;
+    }
+  }
+  for (auto edge : iNode->getIncomingEdges()) {
+    if ((edge->getSrc() == j) && !isa<ControlDependence<Value, Value>>(edge)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*
+ * Check if @inst can be moved by the schedulers of sequential segments.
+ */
+static bool isMovable(Instruction *inst,
+                      LoopStructure *rootLoop,
+                      LoopTree *loops) {
+  if (isa<PHINode>(inst) || inst->isTerminator() || inst->isEHPad()
+      || isa<AllocaInst>(inst) || isa<CallBase>(inst)) {
+    return false;
+  }
+
+  return loops->getInnermostLoopThatContains(inst) == rootLoop;
+}
+
+/*
+ * Fetch the basic blocks of @rootLoop that are control equivalent to @bb from
+ * the earliest to the latest.
+ */
+static std::vector<BasicBlock *> getControlEquivalentBlocks(
+    BasicBlock *bb,
+    LoopStructure *rootLoop,
+    LoopTree *loops,
+    DominatorTree &DT,
+    ControlFlowEquivalence &cfe) {
+  std::vector<BasicBlock *> equivalentBBs;
+  for (auto equivalentBB : cfe.getEquivalences(bb)) {
+    if ((equivalentBB == bb)
+        || (loops->getInnermostLoopThatContains(
+                equivalentBB->getTerminator())
+            != rootLoop)) {
+      continue;
+    }
+    if (!DT.dominates(equivalentBB, bb) && !DT.dominates(bb, equivalentBB)) {
+      continue;
+    }
+    equivalentBBs.push_back(equivalentBB);
+  }
+  std::sort(equivalentBBs.begin(),
+            equivalentBBs.end(),
+            [&DT](BasicBlock *a, BasicBlock *b) -> bool {
+              return DT.properlyDominates(a, b);
+            });
+
+  return equivalentBBs;
+}
+
+/*
+ * Move @inst just before @insertPoint, which belongs to a basic block that is
+ * control equivalent to the one of @inst, unless a dependence forbids it.
+ */
+static bool moveToControlEquivalentPoint(Instruction *inst,
+                                         Instruction *insertPoint,
+                                         LoopStructure *rootLoop,
+                                         DominatorTree &DT,
+                                         PDG *taskDG) {
+  auto bb = inst->getParent();
+  auto targetBB = insertPoint->getParent();
+  auto isHoisting = DT.properlyDominates(targetBB, bb);
+  assert(isHoisting || DT.properlyDominates(bb, targetBB));
+
+  /*
+   * Check the operands of @inst are available at the new location and that
+   * the new location still dominates the users of @inst.
+   */
+  for (auto &op : inst->operands()) {
+    auto opInst = dyn_cast<Instruction>(op.get());
+    if ((opInst != nullptr) && !DT.dominates(opInst, insertPoint)) {
+      return false;
+    }
+  }
+  for (auto &use : inst->uses()) {
+    auto userPoint = cast<Instruction>(use.getUser());
+    if (auto phi = dyn_cast<PHINode>(userPoint)) {
+      userPoint = phi->getIncomingBlock(use)->getTerminator();
+    }
+    if ((userPoint != insertPoint) && !DT.dominates(insertPoint, userPoint)) {
+      return false;
+    }
+  }
+
+  /*
+   * Collect the basic blocks that can be executed between the new and the
+   * old locations within the same iteration.
+   */
+  auto header = rootLoop->getHeader();
+  auto fromBB = isHoisting ? targetBB : bb;
+  auto toBB = isHoisting ? bb : targetBB;
+  std::unordered_set<BasicBlock *> blocksInBetween;
+  std::vector<BasicBlock *> worklist(succ_begin(fromBB), succ_end(fromBB));
+  while (!worklist.empty()) {
+    auto current = worklist.back();
+    worklist.pop_back();
+    if ((current == toBB) || (current == header)
+        || !rootLoop->isIncluded(current)
+        || !blocksInBetween.insert(current).second) {
+      continue;
+    }
+    worklist.insert(worklist.end(), succ_begin(current), succ_end(current));
+  }
+
+  /*
+   * Check @inst does not depend on the instructions it would skip.
+   */
+  auto canBeMoved = true;
+  auto checkInstruction = [&](Instruction &other) -> void {
+    if (canBeMoved && (&other != inst)
+        && mustBeOrdered(taskDG, inst, &other)) {
+      canBeMoved = false;
+    }
+  };
+  for (auto inBetweenBB : blocksInBetween) {
+    std::for_each(inBetweenBB->begin(), inBetweenBB->end(), checkInstruction);
+  }
+  if (isHoisting) {
+    std::for_each(insertPoint->getIterator(),
+                  targetBB->end(),
+                  checkInstruction);
+    std::for_each(bb->begin(), inst->getIterator(), checkInstruction);
+  } else {
+    std::for_each(std::next(inst->getIterator()), bb->end(), checkInstruction);
+    std::for_each(targetBB->begin(),
+                  insertPoint->getIterator(),
+                  checkInstruction);
+  }
+  if (!canBeMoved) {
+    return false;
+  }
+
+  inst->moveBefore(insertPoint);
+  return true;
+}
+
+/*
+ * Hoist @inst to the earliest basic block that is control equivalent to its
+ * own, that dominates it, and that already includes instructions of sequential
+ * segments.
+ */
+static bool hoistToControlEquivalentBlock(
+    Instruction *inst,
+    std::unordered_set<Instruction *> &ssInstructions,
+    LoopStructure *rootLoop,
+    LoopTree *loops,
+    DominatorTree &DT,
+    ControlFlowEquivalence &cfe,
+    PDG *taskDG) {
+  auto bb = inst->getParent();
+  for (auto candidate :
+       getControlEquivalentBlocks(bb, rootLoop, loops, DT, cfe)) {
+    if (!DT.properlyDominates(candidate, bb)) {
+      break;
+    }
+    auto includesSSInstructions = std::any_of(
+        candidate->begin(),
+        candidate->end(),
+        [&](Instruction &other) -> bool {
+          return ssInstructions.find(&other) != ssInstructions.end();
+        });
+    if (!includesSSInstructions) {
+      continue;
+    }
+    if (moveToControlEquivalentPoint(inst,
+                                     candidate->getTerminator(),
+                                     rootLoop,
+                                     DT,
+                                     taskDG)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*
+ * Count the instructions that are executed between the first and the last
+ * instructions of a sequential segment within an iteration.
+ */
+static uint64_t computeSequentialSegmentSize(
+    std::unordered_set<Instruction *> &ssInstructions,
+    LoopStructure *rootLoop,
+    DataFlowResult *reachabilityDFR) {
+  uint64_t size = 0;
+  for (auto bb : rootLoop->getBasicBlocks()) {
+    for (auto &inst : *bb) {
+      auto isInSS = (ssInstructions.find(&inst) != ssInstructions.end());
+      auto reachesSS = isInSS;
+      for (auto reachable : reachabilityDFR->OUT(&inst)) {
+        auto reachableInst = cast<Instruction>(reachable);
+        if (ssInstructions.find(reachableInst) != ssInstructions.end()) {
+          reachesSS = true;
+          break;
+        }
+      }
+      auto isReachedBySS = isInSS;
+      for (auto ssInst : ssInstructions) {
+        if (isReachedBySS) {
+          break;
+        }
+        isReachedBySS = (reachabilityDFR->OUT(ssInst).count(&inst) > 0);
+      }
+      if (reachesSS && isReachedBySS) {
+        size++;
+      }
+    }
+  }
+
+  return size;
+}
+
+/*
+ * Move the instructions of sequential segments within @bb, and the ones they
+ * depend on, before the rest of the instructions of @bb.
+ */
+static bool hoistSequentialInstructionsWithinBlock(
+    BasicBlock *bb,
+    std::unordered_set<Instruction *> &ssInstructions,
+    PDG *taskDG) {
+
+  /*
+   * Fetch the instructions that can be reordered.
+   */
+  std::vector<Instruction *> instructions;
+  auto terminator = bb->getTerminator();
+  for (auto it = bb->getFirstInsertionPt(); &*it != terminator; it++) {
+    instructions.push_back(&*it);
+  }
+
+  /*
+   * Identify the instructions that must run before the rest of the block.
+   */
+  std::unordered_set<Instruction *> early;
+  for (auto i = (int64_t)instructions.size() - 1; i >= 0; i--) {
+    auto inst = instructions[i];
+    if (ssInstructions.find(inst) != ssInstructions.end()) {
+      early.insert(inst);
+      continue;
+    }
+    for (auto j = i + 1; j < (int64_t)instructions.size(); j++) {
+      if ((early.find(instructions[j]) != early.end())
+          && mustBeOrdered(taskDG, inst, instructions[j])) {
+        early.insert(inst);
+        break;
+      }
+    }
+  }
+
+  /*
+   * Sink the remaining instructions after the early ones while preserving their
+   * relative order.
+   */
+  auto modified = false;
+  auto seenLate = false;
+  for (auto inst : instructions) {
+    if (early.find(inst) == early.end()) {
+      seenLate = true;
+    } else if (seenLate) {
+      modified = true;
+      break;
+    }
+  }
+  if (!modified) {
+    return false;
+  }
+  for (auto inst : instructions) {
+    if (early.find(inst) == early.end()) {
+      inst->moveBefore(terminator);
+    }
+  }
+
+  return true;
+}
+
 /*
  * Heuristic used: push furthest outlier instructions closer to the rest of the
  * sequential segment by moving between control flow equivalent sets of basic
@@ -48,6 +371,107 @@ void HELIX::squeezeSequentialSegment(LoopContent *LDI,
   DominatorSummary taskDS(taskDT, taskPDT);
   ControlFlowEquivalence cfe(&taskDS, loops, rootLoop);
 
+  /*
+   * Identify the outliers: the instructions of the sequential segment that
+   * are executed either before or after all the others.
+   */
+  auto ssInstructions = ss->getInstructions();
+  auto isReachedByOthers = [&](Instruction *inst) -> bool {
+    for (auto other : ssInstructions) {
+      if ((other != inst) && (reachabilityDFR->OUT(other).count(inst) > 0)) {
+        return true;
+      }
+    }
+    return false;
+  };
+  auto reachesOthers = [&](Instruction *inst) -> bool {
+    for (auto reachable : reachabilityDFR->OUT(inst)) {
+      auto other = cast<Instruction>(reachable);
+      if ((other != inst)
+          && (ssInstructions.find(other) != ssInstructions.end())) {
+        return true;
+      }
+    }
+    return false;
+  };
+  std::vector<Instruction *> firstOutliers;
+  std::vector<Instruction *> lastOutliers;
+  for (auto inst : ssInstructions) {
+    if (!isMovable(inst, rootLoop, loops)) {
+      continue;
+    }
+    auto isFirst = !isReachedByOthers(inst);
+    auto isLast = !reachesOthers(inst);
+    if (isFirst && !isLast) {
+      firstOutliers.push_back(inst);
+    } else if (isLast && !isFirst) {
+      lastOutliers.push_back(inst);
+    }
+  }
+
+  /*
+   * Sink the first outliers to the earliest control equivalent basic block
+   * that includes other instructions of the sequential segment.
+   */
+  for (auto inst : firstOutliers) {
+    auto bb = inst->getParent();
+    for (auto candidate :
+         getControlEquivalentBlocks(bb, rootLoop, loops, taskDT, cfe)) {
+      if (!taskDT.properlyDominates(bb, candidate)) {
+        continue;
+      }
+      auto firstSSInst = std::find_if(
+          candidate->begin(),
+          candidate->end(),
+          [&](Instruction &other) -> bool {
+            return ssInstructions.find(&other) != ssInstructions.end();
+          });
+      if (firstSSInst == candidate->end()) {
+        continue;
+      }
+      auto insertPoint = isa<PHINode>(&*firstSSInst)
+                             ? &*candidate->getFirstInsertionPt()
+                             : &*firstSSInst;
+      moveToControlEquivalentPoint(inst, insertPoint, rootLoop, taskDT, taskDG);
+      break;
+    }
+  }
+
+  /*
+   * Hoist the last outliers to the latest control equivalent basic block that
+   * includes other instructions of the sequential segment.
+   */
+  for (auto inst : lastOutliers) {
+    auto bb = inst->getParent();
+    auto candidates =
+        getControlEquivalentBlocks(bb, rootLoop, loops, taskDT, cfe);
+    for (auto it = candidates.rbegin(); it != candidates.rend(); it++) {
+      auto candidate = *it;
+      if (!taskDT.properlyDominates(candidate, bb)) {
+        continue;
+      }
+      auto lastSSInst = std::find_if(
+          candidate->rbegin(),
+          candidate->rend(),
+          [&](Instruction &other) -> bool {
+            return ssInstructions.find(&other) != ssInstructions.end();
+          });
+      if (lastSSInst == candidate->rend()) {
+        continue;
+      }
+      Instruction *insertPoint = nullptr;
+      if (isa<PHINode>(&*lastSSInst)) {
+        insertPoint = &*candidate->getFirstInsertionPt();
+      } else if (lastSSInst->isTerminator()) {
+        insertPoint = &*lastSSInst;
+      } else {
+        insertPoint = lastSSInst->getNextNode();
+      }
+      moveToControlEquivalentPoint(inst, insertPoint, rootLoop, taskDT, taskDG);
+      break;
+    }
+  }
+
   return;
 }
 
@@ -55,6 +479,20 @@ void HELIX::squeezeSequentialSegments(LoopContent *LDI,
                                       std::vector<SequentialSegment *> *sss,
                                       DataFlowResult *reachabilityDFR) {
 
+  /*
+   * Measure the sequential segments before squeezing them.
+   */
+  auto rootLoop = LDI->getLoopStructure();
+  std::vector<uint64_t> sizesBefore;
+  if (this->verbose >= Verbosity::Maximal) {
+    for (auto ss : *sss) {
+      auto ssInstructions = ss->getInstructions();
+      sizesBefore.push_back(computeSequentialSegmentSize(ssInstructions,
+                                                         rootLoop,
+                                                         reachabilityDFR));
+    }
+  }
+
   auto sccdagAttribution = LDI->getSCCManager();
   auto sccdag = sccdagAttribution->getSCCDAG();
   std::unordered_set<SCCSet *> sccPartitions;
@@ -73,13 +511,120 @@ void HELIX::squeezeSequentialSegments(LoopContent *LDI,
     delete ssPartition;
   }
 
+  /*
+   * Squeeze each sequential segment on the code produced by the scheduler.
+   */
+  auto squeezedDFR = this->computeReachabilityFromInstructions(LDI);
+  for (auto ss : *sss) {
+    this->squeezeSequentialSegment(LDI, squeezedDFR, ss);
+  }
+  delete squeezedDFR;
+
+  /*
+   * Report the sizes of the sequential segments after squeezing them.
+   */
+  if (this->verbose >= Verbosity::Maximal) {
+    auto finalDFR = this->computeReachabilityFromInstructions(LDI);
+    for (auto i = 0u; i < sss->size(); i++) {
+      auto ss = (*sss)[i];
+      auto ssInstructions = ss->getInstructions();
+      auto sizeAfter =
+          computeSequentialSegmentSize(ssInstructions, rootLoop, finalDFR);
+      errs() << this->prefixString << "  Sequential segment " << ss->getID()
+             << " has been squeezed from " << sizesBefore[i] << " to "
+             << sizeAfter << " instructions\n";
+    }
+    delete finalDFR;
+  }
+
   return;
 }
 
-void HELIX::scheduleSequentialSegments(LoopContent *LDI,
+/*
+ * Heuristic used: the next core waits for the signal of a sequential segment,
+ * so the instructions of a segment are hoisted as early as their dependences
+ * allow, first across control equivalent basic blocks where sequential code
+ * already runs and then within their basic blocks. Independent parallel code
+ * is sunk after them.
+ */
+bool HELIX::scheduleSequentialSegments(LoopContent *LDI,
                                        std::vector<SequentialSegment *> *sss,
                                        DataFlowResult *reachabilityDFR) {
-  // TODO
 
-  return;
+  /*
+   * Fetch ControlFlowEquivalence and dependence graph of the task.
+   */
+  auto loops = LDI->getLoopHierarchyStructures();
+  auto rootLoop = loops->getLoop();
+  auto taskFunction = rootLoop->getHeader()->getParent();
+  auto taskDG = LDI->getLoopDG();
+  DominatorTree taskDT(*taskFunction);
+  PostDominatorTree taskPDT(*taskFunction);
+  DominatorSummary taskDS(taskDT, taskPDT);
+  ControlFlowEquivalence cfe(&taskDS, loops, rootLoop);
+
+  /*
+   * Collect the instructions of all sequential segments.
+   */
+  std::unordered_set<Instruction *> ssInstructions;
+  for (auto ss : *sss) {
+    for (auto inst : ss->getInstructions()) {
+      ssInstructions.insert(inst);
+    }
+  }
+
+  /*
+   * Hoist the instructions of the sequential segments across control
+   * equivalent basic blocks.
+   * Basic blocks are visited in reverse post-order so that producers are
+   * hoisted before their consumers.
+   */
+  auto modified = false;
+  uint32_t hoistedInstructions = 0;
+  ReversePostOrderTraversal<Function *> rpot(taskFunction);
+  for (auto bb : rpot) {
+    if (!rootLoop->isIncluded(bb)) {
+      continue;
+    }
+    std::vector<Instruction *> toHoist;
+    for (auto &inst : *bb) {
+      if ((ssInstructions.find(&inst) == ssInstructions.end())
+          || !isMovable(&inst, rootLoop, loops)) {
+        continue;
+      }
+      toHoist.push_back(&inst);
+    }
+    for (auto inst : toHoist) {
+      if (hoistToControlEquivalentBlock(inst,
+                                        ssInstructions,
+                                        rootLoop,
+                                        loops,
+                                        taskDT,
+                                        cfe,
+                                        taskDG)) {
+        hoistedInstructions++;
+        modified = true;
+      }
+    }
+  }
+
+  /*
+   * Hoist the instructions of the sequential segments within their basic
+   * blocks.
+   */
+  uint32_t scheduledBlocks = 0;
+  for (auto bb : rootLoop->getBasicBlocks()) {
+    if (hoistSequentialInstructionsWithinBlock(bb, ssInstructions, taskDG)) {
+      scheduledBlocks++;
+      modified = true;
+    }
+  }
+
+  if (this->verbose >= Verbosity::Maximal) {
+    errs() << this->prefixString << "  Scheduling sequential segments: "
+           << hoistedInstructions << " instructions have been hoisted and "
+           << scheduledBlocks << " basic blocks have been rescheduled\n";
+  }
+
+  return modified;
 }
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/noelle/core/LoopCarriedSCC.hpp"
+#include "arcana/gino/core/HELIX.hpp"
+
+namespace arcana::gino {
+
+/*
+ * Cycles a core spends on a wait and a signal that do not stall.
+ */
+static const double cyclesPerSynchronization = 20;
+
+/*
+ * Check if @scc only updates memory in place with commutative and associative
+ * operators (e.g., *p += x), so its iterations can run in any order.
+ * Updates that might touch the same location can only be reordered if they
+ * use the same operator on the same type: @updateOperator is the operator of
+ * the updates checked so far, and it is set by the first one.
+ */
+static bool isCommutativeUpdate(SCC *scc, BinaryOperator *&updateOperator) {
+
+  /*
+   * Check if @op is the operator of an update of @ptr.
+   */
+  auto isUpdateOperator = [scc](BinaryOperator *op, Value *ptr) -> bool {
+    if (!op->isCommutative() || !op->isAssociative() || !op->hasOneUse()) {
+      return false;
+    }
+    auto store = dyn_cast<StoreInst>(*op->user_begin());
+    if ((store == nullptr) || (store->getPointerOperand() != ptr)
+        || (store->getValueOperand() != op) || store->isVolatile()) {
+      return false;
+    }
+
+    /*
+     * Exactly one operand is the loaded value.
+     */
+    auto operandsInSCC = 0u;
+    for (auto &operand : op->operands()) {
+      if (scc->isInternal(operand.get())) {
+        operandsInSCC++;
+      }
+    }
+
+    return operandsInSCC == 1;
+  };
+
+  for (auto nodePair : scc->internalNodePairs()) {
+    auto inst = dyn_cast<Instruction>(nodePair.first);
+    if (inst == nullptr) {
+      return false;
+    }
+
+    /*
+     * Every load must only feed the update of the location it reads.
+     */
+    if (auto load = dyn_cast<LoadInst>(inst)) {
+      if (load->isVolatile() || !load->hasOneUse()) {
+        return false;
+      }
+      auto op = dyn_cast<BinaryOperator>(*load->user_begin());
+      if ((op == nullptr) || !isUpdateOperator(op, load->getPointerOperand())) {
+        return false;
+      }
+      continue;
+    }
+
+    /*
+     * Every store must write the update of the location it writes.
+     */
+    if (auto store = dyn_cast<StoreInst>(inst)) {
+      auto op = dyn_cast<BinaryOperator>(store->getValueOperand());
+      if ((op == nullptr) || !scc->isInternal(op)) {
+        return false;
+      }
+      continue;
+    }
+
+    /*
+     * Operators are checked through the loads that feed them.
+     */
+    if (auto op = dyn_cast<BinaryOperator>(inst)) {
+      auto store = op->hasOneUse() ? dyn_cast<StoreInst>(*op->user_begin())
+                                   : nullptr;
+      if ((store == nullptr)
+          || !isUpdateOperator(op, store->getPointerOperand())) {
+        return false;
+      }
+      if (updateOperator == nullptr) {
+        updateOperator = op;
+      }
+      if ((op->getOpcode() != updateOperator->getOpcode())
+          || (op->getType() != updateOperator->getType())) {
+        return false;
+      }
+      auto readsTheUpdatedLocation = false;
+      for (auto &operand : op->operands()) {
+        auto load = dyn_cast<LoadInst>(operand.get());
+        if ((load != nullptr) && scc->isInternal(load)
+            && (load->getPointerOperand() == store->getPointerOperand())) {
+          readsTheUpdatedLocation = true;
+        }
+      }
+      if (!readsTheUpdatedLocation) {
+        return false;
+      }
+      continue;
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+void HELIX::partitionSequentialSegments(
+    LoopContent *LDI,
+    Heuristics *h,
+    std::unordered_map<SCC *, SCC *> &taskToOriginalSCCs,
+    std::function<bool(SCC *scc)> requiresSequentialSegment) {
+
+  /*
+   * Without profiles, every set of sequential SCCs gets its own segment.
+   */
+  auto profiles = this->noelle.getProfiles();
+  auto originalLoopStructure = this->originalLDI->getLoopStructure();
+  if (!profiles->isAvailable()
+      || !profiles->hasBeenExecuted(originalLoopStructure)) {
+    return;
+  }
+  auto iterations = profiles->getIterations(originalLoopStructure);
+  if (iterations == 0) {
+    return;
+  }
+
+  /*
+   * Estimate the instructions a set of SCCs executes per iteration.
+   * SCCs that only exist in the task have no profile, so their static
+   * instructions are used instead.
+   */
+  auto &invocationLatency = h->getInvocationLatency();
+  auto costOfSet = [&](SCCSet *set) -> double {
+    double cost = 0;
+    for (auto scc : set->sccs) {
+      if (taskToOriginalSCCs.find(scc) == taskToOriginalSCCs.end()) {
+        cost += scc->numInternalNodes();
+        continue;
+      }
+      auto originalSCC = taskToOriginalSCCs.at(scc);
+      cost += ((double)invocationLatency.latencyPerInvocation(originalSCC))
+              / ((double)iterations);
+    }
+    return cost;
+  };
+  auto isSequential = [&](SCCSet *set) -> bool {
+    for (auto scc : set->sccs) {
+      if (requiresSequentialSegment(scc)) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  /*
+   * Predict the cycles per iteration of the parallelized loop.
+   * Cores share the instructions of the iterations and the synchronizations
+   * of every segment, while a segment runs on one core at a time before it
+   * is handed to the next core.
+   * Batching iterations spreads a handoff across the iterations of a batch.
+   */
+  auto ltm = LDI->getLoopTransformationsManager();
+  auto cores = (double)std::max<uint64_t>(ltm->getMaximumNumberOfCores(), 1);
+  auto instructionsPerIteration =
+      profiles->getAverageTotalInstructionsPerIteration(originalLoopStructure);
+  auto handoff = cyclesPerHandoff / this->iterationBatchFactor;
+  auto predictIterationTime = [&](uint64_t segments,
+                                  double largestSegment) -> double {
+    auto parallelTime =
+        (instructionsPerIteration
+         + (segments * (cyclesPerSynchronization + handoff)))
+        / cores;
+    auto sequentialTime = (segments > 0) ? (largestSegment + handoff) : 0;
+    return std::max(parallelTime, sequentialTime);
+  };
+
+  /*
+   * Merge sequential sets while that shortens the predicted iteration.
+   */
+  while (true) {
+
+    /*
+     * Fetch the sequential sets and their costs.
+     */
+    std::vector<SCCSet *> sequentialSets;
+    std::unordered_map<SCCSet *, double> setCosts;
+    double largestSegment = 0;
+    for (auto set : this->partitioner->getSets()) {
+      auto cost = costOfSet(set);
+      setCosts[set] = cost;
+      if (isSequential(set)) {
+        sequentialSets.push_back(set);
+        largestSegment = std::max(largestSegment, cost);
+      }
+    }
+    auto currentTime =
+        predictIterationTime(sequentialSets.size(), largestSegment);
+
+    /*
+     * Find the merge of two sequential sets that shortens the iteration the
+     * most.
+     * Merging two sets also merges the sets on the dependence paths between
+     * them.
+     */
+    std::unordered_set<SCCSet *> bestMerge;
+    auto bestTime = currentTime;
+    for (auto i = 0u; i < sequentialSets.size(); i++) {
+      for (auto j = i + 1; j < sequentialSets.size(); j++) {
+        auto setsInMerge =
+            this->partitioner->getCycleIntroducedByMerging(sequentialSets[i],
+                                                           sequentialSets[j]);
+        double mergedCost = 0;
+        uint64_t mergedSegments = 0;
+        for (auto set : setsInMerge) {
+          mergedCost += setCosts.at(set);
+          if (isSequential(set)) {
+            mergedSegments++;
+          }
+        }
+        auto largestSegmentAfterMerge = mergedCost;
+        for (auto set : sequentialSets) {
+          if (setsInMerge.find(set) == setsInMerge.end()) {
+            largestSegmentAfterMerge =
+                std::max(largestSegmentAfterMerge, setCosts.at(set));
+          }
+        }
+        auto time = predictIterationTime(
+            sequentialSets.size() - mergedSegments + 1,
+            largestSegmentAfterMerge);
+        if (time < bestTime) {
+          bestTime = time;
+          bestMerge = setsInMerge;
+        }
+      }
+    }
+    if (bestMerge.size() == 0) {
+      break;
+    }
+
+    /*
+     * Merge the sets.
+     */
+    if (this->verbose >= Verbosity::Maximal) {
+      errs() << this->prefixString << "    Merge " << bestMerge.size()
+             << " sets into one sequential segment: " << currentTime
+             << " -> " << bestTime << " cycles per iteration\n";
+    }
+    this->partitioner->getPartitionGraph()->mergeSetsAndCollapseResultingCycles(
+        bestMerge);
+  }
+
+  return;
+}
+
+bool HELIX::canUseCriticalSections(LoopContent *LDI,
+                                   std::vector<SequentialSegment *> *sss) {
+  if (sss->size() == 0) {
+    return false;
+  }
+
+  /*
+   * Spilled loop-carried values and the sequential prologue must be computed
+   * in iteration order.
+   * The code executed only by the last iteration must run after every other
+   * iteration.
+   */
+  if ((this->spills.size() > 0)
+      || this->doesHaveASequentialPrologue(this->originalLDI)
+      || (this->lastIterationExecutionBlock != nullptr)) {
+    return false;
+  }
+
+  /*
+   * Every loop-carried SCC of a segment must be a commutative update, and all
+   * of them must use the same operator (e.g., *p += a; *p *= b must stay
+   * ordered).
+   * Then, mutual exclusion is enough and a core that reaches a segment does
+   * not have to wait for the previous iteration.
+   */
+  auto sccManager = LDI->getSCCManager();
+  for (auto ss : *sss) {
+    BinaryOperator *updateOperator = nullptr;
+    for (auto scc : ss->getSCCs()) {
+      if (!isa<LoopCarriedSCC>(sccManager->getSCCAttrs(scc))) {
+        continue;
+      }
+      if (!isCommutativeUpdate(scc, updateOperator)) {
+        return false;
+      }
+    }
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << this->prefixString
+           << "  Sequential segments only need mutual exclusion: use "
+              "critical sections\n";
+  }
+
+  return true;
+}
+
+} // namespace arcana::gino
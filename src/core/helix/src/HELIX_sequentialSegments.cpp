@@ -31,7 +31,8 @@ std::vector<SequentialSegment *> HELIX::identifySequentialSegments(
     LoopContent *originalLDI,
     LoopContent *LDI,
     DataFlowResult *reachabilityDFR,
-    HELIXTask *helixTask) {
+    HELIXTask *helixTask,
+    Heuristics *h) {
 
   /*
    * Map from old to new SCCs (for use in determining what SCC can be left out
@@ -141,14 +142,66 @@ std::vector<SequentialSegment *> HELIX::identifySequentialSegments(
       (originalIVManager->getLoopGoverningInductionVariable() != nullptr);
 
   /*
-   * Fetch the subsets.
+   * Fetch the set of SCCs that have loop-carried data dependences.
    */
-  auto sets = this->partitioner->getDepthOrderedSets();
+  auto depsSCCs = sccManager->getSCCsWithLoopCarriedDataDependencies();
 
   /*
-   * Fetch the set of SCCs that have loop-carried data dependences.
+   * Define the SCCs that must execute sequentially.
    */
-  auto depsSCCs = sccManager->getSCCsWithLoopCarriedDataDependencies();
+  auto requiresSequentialSegment = [&](SCC *scc) -> bool {
+
+    /*
+     * Fetch the SCC metadata.
+     * NOTE: If no original SCC mapping exists, default to analyzing the newly
+     * constructed SCC
+     */
+    auto sccToAnalyze = scc;
+    auto sccInfo = sccManager->getSCCAttrs(sccToAnalyze);
+    if (taskToOriginalFunctionSCCMap.find(scc)
+        != taskToOriginalFunctionSCCMap.end()) {
+      sccToAnalyze = taskToOriginalFunctionSCCMap.at(scc);
+      sccInfo = originalSCCManager->getSCCAttrs(sccToAnalyze);
+    }
+
+    /*
+     * If the SCC is due to a control dependence, but the number of iterations
+     * can be computed just before executing the loop, then we can skip it.
+     */
+    if (wasOriginalLoopIVGoverned) {
+      auto weCanSkipIt = true;
+      for (auto sccInfo : depsSCCs) {
+        if (scc == sccInfo->getSCC()) {
+          weCanSkipIt = false;
+          break;
+        }
+      }
+      if (weCanSkipIt) {
+        return false;
+      }
+    }
+
+    /*
+     * Only SCC that has to execute sequentially can generate a sequential
+     * segment.
+     */
+    return isa<LoopCarriedUnknownSCC>(sccInfo)
+           || isa<UnknownClosedFormSCC>(sccInfo);
+  };
+
+  /*
+   * Group the sequential SCCs into the sets that minimize the predicted time
+   * of an iteration.
+   */
+  this->partitionSequentialSegments(LDI,
+                                    h,
+                                    taskToOriginalFunctionSCCMap,
+                                    requiresSequentialSegment);
+
+  /*
+   * Fetch the subsets.
+   */
+  auto sets = this->partitioner->getDepthOrderedSets();
 
   /*
    * Allocate the sequential segments, one per partition.
@@ -162,43 +215,7 @@ std::vector<SequentialSegment *> HELIX::identifySequentialSegments(
      */
     auto requireSS = false;
     for (auto scc : set->sccs) {
-
-      /*
-       * Fetch the SCC metadata.
-       * NOTE: If no original SCC mapping exists, default to analyzing the newly
-       * constructed SCC
-       */
-      auto sccToAnalyze = scc;
-      auto sccInfo = sccManager->getSCCAttrs(sccToAnalyze);
-      if (taskToOriginalFunctionSCCMap.find(scc)
-          != taskToOriginalFunctionSCCMap.end()) {
-        sccToAnalyze = taskToOriginalFunctionSCCMap.at(scc);
-        sccInfo = originalSCCManager->getSCCAttrs(sccToAnalyze);
-      }
-
-      /*
-       * If the SCC is due to a control dependence, but the number of iterations
-       * can be computed just before executing the loop, then we can skip it.
-       */
-      if (wasOriginalLoopIVGoverned) {
-        auto weCanSkipIt = true;
-        for (auto sccInfo : depsSCCs) {
-          if (scc == sccInfo->getSCC()) {
-            weCanSkipIt = false;
-            break;
-          }
-        }
-        if (weCanSkipIt) {
-          continue;
-        }
-      }
-
-      /*
-       * Only SCC that has to execute sequentially can generate a sequential
-       * segment.
-       */
-      if (isa<LoopCarriedUnknownSCC>(sccInfo)
-          || isa<UnknownClosedFormSCC>(sccInfo)) {
+      if (requiresSequentialSegment(scc)) {
         requireSS = true;
         break;
       }
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/HELIX.hpp"
+
+namespace arcana::gino {
+
+void HELIX::enableSynchronizationSkipping(void) {
+  this->alwaysSkipSynchronization = true;
+
+  return;
+}
+
+void HELIX::identifyRarelyEnteredSequentialSegments(
+    LoopContent *LDI,
+    std::vector<SequentialSegment *> *sss,
+    HELIXTask *helixTask) {
+  this->rarelyEnteredSSs.clear();
+
+  /*
+   * An iteration that enters a rarely entered sequential segment waits for
+   * every preceding iteration, so they must be executed one per core.
+   * The code executed only by the last iteration must run after every other
+   * iteration.
+   */
+  if ((sss->size() == 0) || this->useCriticalSections
+      || (this->iterationBatchFactor > 1)
+      || (this->lastIterationExecutionBlock != nullptr)) {
+    return;
+  }
+
+  /*
+   * Without profiles, we cannot tell how often a sequential segment is
+   * entered, unless every sequential segment is assumed to be rarely entered.
+   */
+  auto profiles = this->noelle.getProfiles();
+  auto originalLoopStructure = this->originalLDI->getLoopStructure();
+  uint64_t iterations = 0;
+  if (profiles->isAvailable()
+      && profiles->hasBeenExecuted(originalLoopStructure)) {
+    iterations = profiles->getIterations(originalLoopStructure);
+  }
+  if ((iterations == 0) && !this->alwaysSkipSynchronization) {
+    return;
+  }
+
+  /*
+   * Fetch the sequential segment that decides whether the loop continues.
+   * Every iteration enters it.
+   */
+  auto preambleSCC =
+      this->getTheSequentialSCCThatCreatesTheSequentialPrologue(LDI);
+
+  /*
+   * Identify the sequential segments entered by few iterations.
+   */
+  for (auto ss : *sss) {
+    auto isPreamble = false;
+    for (auto scc : ss->getSCCs()) {
+      isPreamble |= (scc == preambleSCC);
+    }
+    if (isPreamble || this->usesIterationCounters(ss->getID())
+        || (this->atomicSSs.find(ss->getID()) != this->atomicSSs.end())) {
+      continue;
+    }
+
+    /*
+     * Check if every sequential segment must be considered rarely entered.
+     */
+    if (this->alwaysSkipSynchronization) {
+      this->rarelyEnteredSSs.insert(ss->getID());
+      continue;
+    }
+
+    /*
+     * Compute how many times the sequential segment has been entered.
+     * Instructions that only exist in the task (e.g., accesses to spilled
+     * values) have no profile.
+     */
+    uint64_t entries = 0;
+    auto isProfiled = true;
+    for (auto cloneI : ss->getInstructions()) {
+      auto originalI = helixTask->getOriginalInstructionOfClone(cloneI);
+      if (originalI == nullptr) {
+        isProfiled = false;
+        break;
+      }
+      if (isa<CallBase>(originalI)) {
+        continue;
+      }
+      auto executions = profiles->getTotalInstructions(originalI);
+      entries = std::max<uint64_t>(entries, executions);
+    }
+    if (!isProfiled || (entries == 0)) {
+      continue;
+    }
+    auto entryFrequency = ((double)entries) / ((double)iterations);
+    if (entryFrequency > maximumEntryFrequencyToSkipSynchronization) {
+      continue;
+    }
+    this->rarelyEnteredSSs.insert(ss->getID());
+    if (this->verbose != Verbosity::Disabled) {
+      errs() << this->prefixString << "  Sequential segment " << ss->getID()
+             << " is entered by " << (entryFrequency * 100)
+             << "% of the iterations: skip its synchronization elsewhere\n";
+    }
+  }
+  if (this->rarelyEnteredSSs.size() == 0) {
+    return;
+  }
+
+  /*
+   * Track the index of the current iteration.
+   */
+  this->trackIterationIndex(LDI, helixTask);
+
+  return;
+}
+
+bool HELIX::canEnterSequentialSegment(SequentialSegment *ss,
+                                      Instruction *justAfterEntry,
+                                      BasicBlock *loopHeader) {
+
+  /*
+   * Check the rest of the basic block of the entry.
+   */
+  auto ssInstructions = ss->getInstructions();
+  for (auto i = justAfterEntry; i != nullptr; i = i->getNextNode()) {
+    if (ssInstructions.find(i) != ssInstructions.end()) {
+      return true;
+    }
+  }
+
+  /*
+   * Check the basic blocks reachable within the same iteration.
+   */
+  std::unordered_set<BasicBlock *> visited;
+  std::queue<BasicBlock *> toVisit;
+  toVisit.push(justAfterEntry->getParent());
+  while (!toVisit.empty()) {
+    auto bb = toVisit.front();
+    toVisit.pop();
+    for (auto succ : successors(bb)) {
+      if ((succ == loopHeader) || (visited.find(succ) != visited.end())) {
+        continue;
+      }
+      visited.insert(succ);
+      for (auto &i : *succ) {
+        if (ssInstructions.find(&i) != ssInstructions.end()) {
+          return true;
+        }
+      }
+      toVisit.push(succ);
+    }
+  }
+
+  return false;
+}
+
+} // namespace arcana::gino
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/HELIX.hpp"
+
+namespace arcana::gino {
+
+SequentialSegment *HELIX::getSequentialSegmentThatStoresSpill(
+    SpilledLoopCarriedDependence *spill,
+    std::vector<SequentialSegment *> *sss) {
+  if (spill->environmentStores.size() == 0) {
+    return nullptr;
+  }
+
+  for (auto ss : *sss) {
+    auto ssInstructions = ss->getInstructions();
+    auto includesAllStores = true;
+    for (auto store : spill->environmentStores) {
+      if (ssInstructions.find(store) == ssInstructions.end()) {
+        includesAllStores = false;
+        break;
+      }
+    }
+    if (includesAllStores) {
+      return ss;
+    }
+  }
+
+  return nullptr;
+}
+
+void HELIX::layOutSpilledValues(LoopContent *LDI,
+                                std::vector<SequentialSegment *> *sss,
+                                HELIXTask *helixTask) {
+  if (this->spills.size() == 0) {
+    return;
+  }
+
+  /*
+   * Fetch the data layout and the types.
+   */
+  auto program = this->noelle.getProgram();
+  auto &DL = program->getDataLayout();
+  auto tm = this->noelle.getTypesManager();
+  auto int8 = tm->getIntegerType(8);
+  auto int8Ptr = PointerType::getUnqual(int8);
+  auto lineBytes = Architecture::getCacheLineBytes();
+
+  /*
+   * Group the spilled values by the sequential segment that stores them.
+   * Values stored by more than one segment form their own group.
+   */
+  std::map<int64_t, std::vector<SpilledLoopCarriedDependence *>> groups;
+  for (auto spill : this->spills) {
+    int64_t groupID = -1;
+    auto ss = this->getSequentialSegmentThatStoresSpill(spill, sss);
+    if (ss != nullptr) {
+      groupID = ss->getID();
+    }
+    groups[groupID].push_back(spill);
+  }
+
+  /*
+   * Place each group on its own cache lines.
+   * Hence, cores that hand different segments to each other do not share
+   * lines.
+   */
+  uint64_t arrayBytes = 0;
+  std::unordered_map<SpilledLoopCarriedDependence *, uint64_t> offsets;
+  for (auto &group : groups) {
+    arrayBytes = alignTo(arrayBytes, lineBytes);
+    for (auto spill : group.second) {
+      auto valueType = spill->getOriginal()->getType();
+      auto offset =
+          alignTo(arrayBytes, DL.getABITypeAlign(valueType).value());
+      offsets[spill] = offset;
+      arrayBytes = offset + DL.getTypeAllocSize(valueType).getFixedSize();
+    }
+  }
+  arrayBytes = alignTo(arrayBytes, lineBytes);
+
+  /*
+   * Allocate the array in the function of the loop.
+   */
+  auto loopFunction = this->originalLDI->getLoopStructure()->getFunction();
+  IRBuilder<> loopFunctionBuilder(&*loopFunction->begin()->begin());
+  auto arrayType = ArrayType::get(int8, arrayBytes);
+  auto array = loopFunctionBuilder.CreateAlloca(arrayType);
+  array->setAlignment(Align(lineBytes));
+  this->loopCarriedArray = loopFunctionBuilder.CreateBitCast(array, int8Ptr);
+
+  /*
+   * Move the accesses to the spilled values to their new locations.
+   */
+  IRBuilder<> entryBuilder{ helixTask->getEntry()->getTerminator() };
+  auto arrayInTask =
+      entryBuilder.CreateBitCast(helixTask->loopCarriedArrayArg, int8Ptr);
+  for (auto spill : this->spills) {
+    auto valuePtrType = PointerType::getUnqual(spill->getOriginal()->getType());
+    auto offset = offsets.at(spill);
+
+    /*
+     * Move the store of the initial value.
+     */
+    auto initialStore = spill->environmentInitialStore;
+    IRBuilder<> initialBuilder(initialStore);
+    auto initialPtr = initialBuilder.CreateBitCast(
+        initialBuilder.CreateConstInBoundsGEP2_64(arrayType, array, 0, offset),
+        valuePtrType);
+    initialStore->setOperand(initialStore->getPointerOperandIndex(),
+                             initialPtr);
+
+    /*
+     * Move the accesses within the task.
+     */
+    Value *oldPtr = nullptr;
+    if (spill->environmentStores.size() > 0) {
+      oldPtr = (*spill->environmentStores.begin())->getPointerOperand();
+    } else if (spill->environmentLoads.size() > 0) {
+      oldPtr = (*spill->environmentLoads.begin())->getPointerOperand();
+    }
+    if (oldPtr == nullptr) {
+      continue;
+    }
+    auto newPtr = entryBuilder.CreateBitCast(
+        entryBuilder.CreateConstInBoundsGEP1_64(int8, arrayInTask, offset),
+        valuePtrType);
+    oldPtr->replaceAllUsesWith(newPtr);
+  }
+  if (this->verbose != Verbosity::Disabled) {
+    errs() << this->prefixString << "  Spilled values take "
+           << (arrayBytes / lineBytes) << " cache lines for " << groups.size()
+           << " groups\n";
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
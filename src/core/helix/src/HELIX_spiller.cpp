@@ -125,15 +125,16 @@ void HELIX::spillLoopCarriedDataDependencies(LoopContent *LDI,
   loopCarriedLoopEnvironmentBuilder->generateEnvVariables(loopFunctionBuilder);
 
   IRBuilder<> builder(this->entryPointOfParallelizedLoop);
+  std::vector<StoreInst *> initialStores;
   for (auto envVariableID = 0; envVariableID < originalLoopCarriedPHIs.size();
        ++envVariableID) {
     auto phi = originalLoopCarriedPHIs[envVariableID];
     auto preHeaderIndex = phi->getBasicBlockIndex(loopPreHeader);
     auto preHeaderV = phi->getIncomingValue(preHeaderIndex);
-    builder.CreateStore(
+    initialStores.push_back(builder.CreateStore(
         preHeaderV,
         loopCarriedLoopEnvironmentBuilder->getEnvironmentVariable(
-            envVariableID));
+            envVariableID)));
   }
 
   std::unordered_map<BasicBlock *, BasicBlock *> cloneToOriginalBlockMap;
@@ -152,6 +153,7 @@ void HELIX::spillLoopCarriedDataDependencies(LoopContent *LDI,
     auto originalPHI = originalLoopCarriedPHIs[phiI];
     auto clonePHI = clonedLoopCarriedPHIs[phiI];
     auto spilled = new SpilledLoopCarriedDependence(originalPHI, clonePHI);
+    spilled->environmentInitialStore = initialStores[phiI];
     this->spills.insert(spilled);
 
     /*
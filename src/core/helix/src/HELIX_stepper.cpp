@@ -82,6 +82,14 @@ void HELIX::rewireLoopForIVsToIterateNthIterations(LoopContent *LDI) {
     ivInfos.insert(ivInfo);
   }
 
+  /*
+   * Batch consecutive iterations if it is worth it.
+   */
+  std::set<Instruction *> ivsStepSelects;
+  if (this->iterationBatchFactor > 1) {
+    this->batchIterations(LDI);
+  }
+
   /*
    * Collect clones of step size deriving values for all induction variables
    * of the top level loop
@@ -90,8 +98,14 @@ void HELIX::rewireLoopForIVsToIterateNthIterations(LoopContent *LDI) {
 
   /*
    * Determine start value of the IV for the task
-   *   core_start: original_start + original_step_size * core_id
+   *   core_start: original_start + original_step_size * core_id * batch_factor
    */
+  auto batchFactor =
+      ConstantInt::get(task->coreArg->getType(), this->iterationBatchFactor);
+  auto firstIterationOfCore =
+      (this->iterationBatchFactor > 1)
+          ? entryBuilder.CreateMul(task->coreArg, batchFactor)
+          : task->coreArg;
   for (auto ivInfo : ivInfos) {
     auto startOfIV = this->fetchCloneInTask(task, ivInfo->getStartValue());
     auto stepOfIV = clonedStepSizeMap.at(ivInfo);
@@ -99,18 +113,22 @@ void HELIX::rewireLoopForIVsToIterateNthIterations(LoopContent *LDI) {
     auto ivPHI = cast<PHINode>(this->fetchCloneInTask(task, originalIVPHI));
 
     auto offsetStartValue =
-        IVUtility::computeInductionVariableValueForIteration(preheaderClone,
-                                                             ivPHI,
-                                                             startOfIV,
-                                                             stepOfIV,
-                                                             task->coreArg);
+        IVUtility::computeInductionVariableValueForIteration(
+            preheaderClone,
+            ivPHI,
+            startOfIV,
+            stepOfIV,
+            firstIterationOfCore);
     ivPHI->setIncomingValueForBlock(preheaderClone, offsetStartValue);
   }
 
   /*
    * Determine additional step size to account for n cores each executing the
    * task.
-   *   jump_step_size: original_step_size * (num_cores - 1)
+   *   jump_step_size: original_step_size * (num_cores - 1) * batch_factor
+   *
+   * When iterations are batched, the additional step is taken only at the end
+   * of a batch.
    */
   for (auto ivInfo : ivInfos) {
     auto stepOfIV = clonedStepSizeMap.at(ivInfo);
@@ -120,10 +138,24 @@ void HELIX::rewireLoopForIVsToIterateNthIterations(LoopContent *LDI) {
     auto numCoresMinusOne = entryBuilder.CreateSub(
         task->numCoresArg,
         ConstantInt::get(task->numCoresArg->getType(), 1));
-    auto jumpStepSize = IVUtility::scaleInductionVariableStep(preheaderClone,
-                                                              ivPHI,
-                                                              stepOfIV,
-                                                              numCoresMinusOne);
+    auto iterationsToSkip =
+        (this->iterationBatchFactor > 1)
+            ? entryBuilder.CreateMul(numCoresMinusOne, batchFactor)
+            : numCoresMinusOne;
+    Value *jumpStepSize =
+        IVUtility::scaleInductionVariableStep(preheaderClone,
+                                              ivPHI,
+                                              stepOfIV,
+                                              iterationsToSkip);
+    if (this->iterationBatchFactor > 1) {
+      IRBuilder<> headerBuilder(
+          cast<Instruction>(this->isLastIterationOfBatch)->getNextNode());
+      jumpStepSize = headerBuilder.CreateSelect(
+          this->isLastIterationOfBatch,
+          jumpStepSize,
+          Constant::getNullValue(jumpStepSize->getType()));
+      ivsStepSelects.insert(cast<Instruction>(jumpStepSize));
+    }
 
     IVUtility::stepInductionVariablePHI(preheaderClone, ivPHI, jumpStepSize);
   }
@@ -272,6 +304,17 @@ void HELIX::rewireLoopForIVsToIterateNthIterations(LoopContent *LDI) {
     originalInstsThatMustMove.push_back(&I);
   }
 
+  /*
+   * The instructions that track the batches of iterations stay in the header.
+   */
+  if (this->iterationBatchFactor > 1) {
+    cloneInstsThatCanStayInTheNewHeader.insert(this->iterationBatchIndex);
+    cloneInstsThatCanStayInTheNewHeader.insert(
+        cast<Instruction>(this->isLastIterationOfBatch));
+    cloneInstsThatCanStayInTheNewHeader.insert(ivsStepSelects.begin(),
+                                               ivsStepSelects.end());
+  }
+
   /*
    * Collect the instruction in the old header of the task that must move.
    */
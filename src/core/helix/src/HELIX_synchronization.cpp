@@ -21,6 +21,8 @@
  */
 #include "arcana/noelle/core/Architecture.hpp"
 #include "arcana/gino/core/HELIX.hpp"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
 
 namespace arcana::gino {
 
@@ -44,6 +46,21 @@ void HELIX::addSynchronizations(LoopContent *LDI,
   auto loopStructure = LDI->getLoopStructure();
   auto loopHeader = loopStructure->getHeader();
 
+  /*
+   * Fetch the blocks of the loop within the task.
+   * Blocks created while synchronizing inherit the membership of the block
+   * they are carved from.
+   */
+  DominatorTree taskDT(*loopHeader->getParent());
+  LoopInfo taskLI(taskDT);
+  auto taskLoop = taskLI.getLoopFor(loopHeader);
+  assert(taskLoop != nullptr);
+  this->taskLoopBlocks.clear();
+  this->taskLoopBlocks.insert(taskLoop->block_begin(), taskLoop->block_end());
+  auto isInTaskLoop = [this](BasicBlock *bb) -> bool {
+    return this->taskLoopBlocks.find(bb) != this->taskLoopBlocks.end();
+  };
+
   /*
    * Fetch the types we need.
    */
@@ -100,6 +117,16 @@ void HELIX::addSynchronizations(LoopContent *LDI,
     ssStates.push_back(ssStateAlloca);
   }
 
+  /*
+   * Sequential segments lowered to atomic instructions are not synchronized.
+   */
+  std::vector<SequentialSegment *> synchronizedSSs;
+  for (auto ss : *sss) {
+    if (this->atomicSSs.find(ss->getID()) == this->atomicSSs.end()) {
+      synchronizedSSs.push_back(ss);
+    }
+  }
+
   /*
    * Define the code that inject wait instructions.
    */
@@ -140,6 +167,10 @@ void HELIX::addSynchronizations(LoopContent *LDI,
      */
     auto ssWaitBBName = "SS" + std::to_string(ss->getID()) + "-wait";
     auto ssWaitBB = helixTask->newBasicBlock(ssWaitBBName);
+    if (isInTaskLoop(beforeEntryBB)) {
+      this->taskLoopBlocks.insert(ssEntryBB);
+      this->taskLoopBlocks.insert(ssWaitBB);
+    }
     IRBuilder<> ssWaitBuilder(ssWaitBB);
     auto wait = this->injectWaitCall(ssWaitBuilder, ss->getID());
     auto ssState = ssStates.at(ss->getID());
@@ -165,6 +196,32 @@ void HELIX::addSynchronizations(LoopContent *LDI,
     helixTask->waits.insert(cast<CallInst>(wait));
   };
 
+  /*
+   * When iterations are batched, a core signals the next one only at the last
+   * iteration of a batch. Signals on the paths that leave the loop are kept
+   * unconditional.
+   */
+  auto lastIndexOfBatch =
+      cm->getIntegerConstant(this->iterationBatchFactor - 1, int64);
+  auto injectSignalAt = [&](SequentialSegment *ss,
+                            Instruction *insertPoint) -> CallInst * {
+    if ((this->iterationBatchFactor > 1)
+        && isInTaskLoop(insertPoint->getParent())) {
+      IRBuilder<> checkBuilder(insertPoint);
+      auto isLastIterationOfBatch =
+          checkBuilder.CreateICmpEQ(this->iterationBatchIndex,
+                                    lastIndexOfBatch);
+      auto splitPoint = insertPoint;
+      insertPoint = SplitBlockAndInsertIfThen(isLastIterationOfBatch,
+                                              splitPoint,
+                                              false);
+      this->taskLoopBlocks.insert(splitPoint->getParent());
+      this->taskLoopBlocks.insert(insertPoint->getParent());
+    }
+    IRBuilder<> signalBuilder(insertPoint);
+    return cast<CallInst>(this->injectSignalCall(signalBuilder, ss->getID()));
+  };
+
   /*
    * Define the code that inject wait instructions.
    */
@@ -182,17 +239,18 @@ void HELIX::addSynchronizations(LoopContent *LDI,
       Instruction *insertPoint = terminator == justBeforeExit
                                      ? terminator
                                      : justBeforeExit->getNextNode();
-      IRBuilder<> beforeExitBuilder(insertPoint);
-      auto signal = this->injectSignalCall(beforeExitBuilder, ss->getID());
-      helixTask->signals.insert(cast<CallInst>(signal));
+      auto signal = injectSignalAt(ss, insertPoint);
+      helixTask->signals.insert(signal);
       return;
     }
 
-    for (auto successorBlock : successors(block)) {
-      IRBuilder<> beforeExitBuilder(
+    std::vector<BasicBlock *> successorBlocks(succ_begin(block),
+                                              succ_end(block));
+    for (auto successorBlock : successorBlocks) {
+      auto signal = injectSignalAt(
+          ss,
           successorBlock->getFirstNonPHIOrDbgOrLifetime());
-      auto signal = this->injectSignalCall(beforeExitBuilder, ss->getID());
-      helixTask->signals.insert(cast<CallInst>(signal));
+      helixTask->signals.insert(signal);
     }
   };
 
@@ -217,7 +275,7 @@ void HELIX::addSynchronizations(LoopContent *LDI,
   for (auto i = 0u; i < helixTask->getNumberOfLastBlocks(); ++i) {
     auto loopExitBlock = helixTask->getLastBlock(i);
     auto loopExitTerminator = loopExitBlock->getTerminator();
-    for (auto ss : *sss) {
+    for (auto ss : synchronizedSSs) {
       injectWait(ss, loopExitBlock->getFirstNonPHI());
       injectSignal(ss, loopExitTerminator);
     }
@@ -227,7 +285,7 @@ void HELIX::addSynchronizations(LoopContent *LDI,
    * Add wait and signal instructions to the last-iteration-body if it exists.
    */
   if (this->lastIterationExecutionBlock != nullptr) {
-    for (auto ss : *sss) {
+    for (auto ss : synchronizedSSs) {
       injectWait(ss, this->lastIterationExecutionBlock->getFirstNonPHI());
     }
   }
@@ -241,6 +299,9 @@ void HELIX::addSynchronizations(LoopContent *LDI,
     auto beforeCheckBB = justAfterEntry->getParent();
     auto afterCheckBB = helixTask->newBasicBlock("SS-passed-checkexit");
     auto failedCheckBB = helixTask->newBasicBlock("SS-failed-checkexit");
+    if (isInTaskLoop(beforeCheckBB)) {
+      this->taskLoopBlocks.insert(afterCheckBB);
+    }
     IRBuilder<> afterCheckBuilder(afterCheckBB);
     auto afterEntry = justAfterEntry;
     while (afterEntry) {
@@ -270,7 +331,7 @@ void HELIX::addSynchronizations(LoopContent *LDI,
 
     IRBuilder<> failedCheckBuilder(failedCheckBB);
     auto brToExit = failedCheckBuilder.CreateBr(helixTask->getExit());
-    for (auto ss : *sss)
+    for (auto ss : synchronizedSSs)
       injectSignal(ss, brToExit);
   };
 
@@ -278,7 +339,7 @@ void HELIX::addSynchronizations(LoopContent *LDI,
    * Once the preamble has been synchronized, if that was necessary, synchronize
    * each sequential segment
    */
-  for (auto ss : *sss) {
+  for (auto ss : synchronizedSSs) {
 
     /*
      * Reset the value of ssState at the beginning of the iteration
@@ -287,7 +348,25 @@ void HELIX::addSynchronizations(LoopContent *LDI,
      */
     auto firstLoopInst = loopHeader->getFirstNonPHIOrDbgOrLifetime();
     IRBuilder<> headerBuilder(firstLoopInst);
-    headerBuilder.CreateStore(const0, ssStates.at(ss->getID()));
+    auto ssState = ssStates.at(ss->getID());
+    if (this->iterationBatchFactor > 1) {
+
+      /*
+       * A wait is executed only once per batch of iterations.
+       */
+      auto isFirstIterationOfBatch =
+          headerBuilder.CreateICmpEQ(this->iterationBatchIndex, const0);
+      auto currentSSState = headerBuilder.CreateLoad(
+          ssState->getType()->getPointerElementType(),
+          ssState);
+      headerBuilder.CreateStore(
+          headerBuilder.CreateSelect(isFirstIterationOfBatch,
+                                     const0,
+                                     currentSSState),
+          ssState);
+    } else {
+      headerBuilder.CreateStore(const0, ssState);
+    }
 
     /*
      * Inject waits.
@@ -302,7 +381,20 @@ void HELIX::addSynchronizations(LoopContent *LDI,
       /*
        * This is not the prologue.
        */
-      ss->forEachEntry([ss, &injectWait](Instruction *justAfterEntry) -> void {
+      auto isRarelyEntered = this->rarelyEnteredSSs.find(ss->getID())
+                             != this->rarelyEnteredSSs.end();
+      ss->forEachEntry([&](Instruction *justAfterEntry) -> void {
+        /*
+         * An iteration that takes a path around a rarely entered sequential
+         * segment does not wait.
+         * It only signals that it is done with the sequential segment.
+         */
+        if (isRarelyEntered
+            && !this->canEnterSequentialSegment(ss,
+                                                justAfterEntry,
+                                                loopHeader)) {
+          return;
+        }
         injectWait(ss, justAfterEntry);
       });
 
@@ -397,6 +489,40 @@ Value *HELIX::getPointerOfSequentialSegment(HELIXTask *helixTask,
 
 CallInst *HELIX::injectWaitCall(IRBuilder<> &builder, uint32_t ssID) {
 
+  /*
+   * Check if the sequential segment depends only on the iteration d positions
+   * back.
+   * If it does, wait for the core that executes that iteration to complete it.
+   */
+  auto distanceIt = this->ssDistances.find(ssID);
+  if (distanceIt != this->ssDistances.end()) {
+    auto int64 = this->iterationIndex->getType();
+    auto iterations = builder.CreateSub(
+        this->iterationIndex,
+        ConstantInt::get(int64, distanceIt->second - 1));
+    auto ptr = this->ssProducerPtrs.at(ssID);
+    return builder.CreateCall(this->waitIterationSSCall, { ptr, iterations });
+  }
+
+  /*
+   * Check if the sequential segment is rarely entered.
+   * If it is, the iterations that precede the current one might have skipped
+   * it without waiting, so wait for all of them.
+   */
+  if (this->rarelyEnteredSSs.find(ssID) != this->rarelyEnteredSSs.end()) {
+    auto task = static_cast<HELIXTask *>(this->tasks[0]);
+    auto int64 = this->iterationIndex->getType();
+    auto ssArraySize = ConstantInt::get(
+        int64,
+        this->ssPastPtrs.size() * Architecture::getCacheLineBytes());
+    auto core = builder.CreateZExtOrTrunc(task->coreArg, int64);
+    auto numCores = builder.CreateZExtOrTrunc(task->numCoresArg, int64);
+    auto ptr = this->ssPastPtrs.at(ssID);
+    return builder.CreateCall(
+        this->waitPrecedingIterationsSSCall,
+        { ptr, ssArraySize, core, numCores, this->iterationIndex });
+  }
+
   /*
    * Fetch the pointer to the sequential segment memory location.
    */
@@ -412,6 +538,26 @@ CallInst *HELIX::injectWaitCall(IRBuilder<> &builder, uint32_t ssID) {
 
 CallInst *HELIX::injectSignalCall(IRBuilder<> &builder, uint32_t ssID) {
 
+  /*
+   * Check if the sequential segment depends only on the iteration d positions
+   * back, or if it is rarely entered.
+   * If it does, publish the number of iterations completed by this core in its
+   * own line.
+   * A core that leaves the loop releases every iteration that waits for it.
+   */
+  if (this->usesIterationCounters(ssID)) {
+    auto int64 = this->iterationIndex->getType();
+    Value *iterations =
+        ConstantInt::get(int64, std::numeric_limits<int64_t>::max());
+    if (this->taskLoopBlocks.find(builder.GetInsertBlock())
+        != this->taskLoopBlocks.end()) {
+      iterations =
+          builder.CreateAdd(this->iterationIndex, ConstantInt::get(int64, 1));
+    }
+    auto ptr = this->ssPastPtrs.at(ssID);
+    return builder.CreateCall(this->signalIterationSSCall, { ptr, iterations });
+  }
+
   /*
    * Fetch the pointer to the sequential segment memory location.
    */
@@ -26,7 +26,8 @@ namespace arcana::gino {
 
 SpilledLoopCarriedDependence::SpilledLoopCarriedDependence(PHINode *orig,
                                                            PHINode *taskClone)
-  : originalLoopCarriedPHI{ orig },
+  : environmentInitialStore{ nullptr },
+    originalLoopCarriedPHI{ orig },
     loopCarriedPHI{ taskClone } {
   return;
 }
@@ -47,6 +47,8 @@ public:
       std::function<bool(GenericSCC *scc)> canBeRematerialized,
       Verbosity verbose);
 
+  InvocationLatency &getInvocationLatency(void);
+
 private:
   void minMaxMergePartition(
       SCCDAGPartitioner &partitioner,
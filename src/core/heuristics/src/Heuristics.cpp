@@ -44,6 +44,10 @@ void Heuristics::adjustParallelizationPartitionForDSWP(
                        verbose);
 }
 
+InvocationLatency &Heuristics::getInvocationLatency(void) {
+  return this->invocationLatency;
+}
+
 void Heuristics::minMaxMergePartition(
     SCCDAGPartitioner &partitioner,
     SCCDAGAttrs &attrs,
@@ -65,6 +65,12 @@ public:
 
   virtual Transformation getParallelizationID(void) const = 0;
 
+  /*
+   * Use the thread-caching allocator of the runtime for the memory allocated
+   * within the parallelized code.
+   */
+  void enableThreadCachingAllocator(void);
+
   /*
    * Destructor.
    */
@@ -147,6 +153,9 @@ protected:
   virtual void generateCodeToStoreLiveOutVariables(LoopContent *loopContent,
                                                    int taskIndex);
 
+  virtual void propagateAliasInformationToTask(LoopContent *loopContent,
+                                               int taskIndex);
+
   virtual Instruction *
   fetchOrCreatePHIForIntermediateProducerValueOfReducibleLiveOutVariable(
       LoopContent *loopContent,
@@ -192,6 +201,13 @@ protected:
 
   virtual void makePRVGsReentrant(void);
 
+  virtual void substituteMemoryAllocators(void);
+
+  virtual Instruction *allocatePrivateCopyWithThreadCachingAllocator(
+      Task *task,
+      AllocaInst *alloca,
+      IRBuilder<> &entryBuilder);
+
   Value *fetchCloneInTask(Task *t, Value *original);
 
   /*
@@ -200,6 +216,7 @@ protected:
   Noelle &noelle;
   Verbosity verbose;
   LoopEnvironmentBuilder *envBuilder;
+  bool useThreadCachingAllocator;
 
   /*
    * Parallel task related information.
@@ -29,6 +29,7 @@ namespace arcana::gino {
 ParallelizationTechnique::ParallelizationTechnique(Noelle &n)
   : noelle{ n },
     envBuilder{ nullptr },
+    useThreadCachingAllocator{ false },
     tasks{},
     entryPointOfParallelizedLoop{ nullptr },
     exitPointOfParallelizedLoop{ nullptr },
@@ -707,11 +708,21 @@ void ParallelizationTechnique::cloneMemoryLocationsLocallyAndRewireLoop(
 
     /*
      * Clone the stack object at the beginning of the task.
+     * Big objects are allocated by the thread-caching allocator, if enabled.
      */
-    auto allocaClone = cast<AllocaInst>(alloca->clone());
-    auto firstInst = &*entryBlock.begin();
-    entryBuilder.SetInsertPoint(firstInst);
-    entryBuilder.Insert(allocaClone);
+    Instruction *allocaClone = nullptr;
+    if (this->useThreadCachingAllocator) {
+      allocaClone =
+          this->allocatePrivateCopyWithThreadCachingAllocator(task,
+                                                              alloca,
+                                                              entryBuilder);
+    }
+    if (allocaClone == nullptr) {
+      allocaClone = alloca->clone();
+      auto firstInst = &*entryBlock.begin();
+      entryBuilder.SetInsertPoint(firstInst);
+      entryBuilder.Insert(allocaClone);
+    }
 
     /*
      * Initialize the private copy
@@ -783,7 +794,7 @@ void ParallelizationTechnique::cloneMemoryLocationsLocallyAndRewireLoop(
       /*
        * Initialize the private copy of the stack object.
        */
-      auto t = allocaClone->getAllocatedType();
+      auto t = alloca->getAllocatedType();
       auto beforePtrOfOriginalStackObject =
           ptrOfOriginalStackObject->getPrevNode();
       entryBuilder.SetInsertPoint(ptrOfOriginalStackObject);
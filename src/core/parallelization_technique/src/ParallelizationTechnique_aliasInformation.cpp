@@ -0,0 +1,222 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/ParallelizationTechnique.hpp"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/MDBuilder.h"
+
+namespace arcana::gino {
+
+void ParallelizationTechnique::propagateAliasInformationToTask(
+    LoopContent *loopContent,
+    int taskIndex) {
+
+  /*
+   * Fetch the task.
+   */
+  auto task = this->tasks.at(taskIndex);
+  auto taskFunction = task->getTaskBody();
+  auto &cxt = taskFunction->getContext();
+  auto &DL = taskFunction->getParent()->getDataLayout();
+
+  /*
+   * Fetch the user of the environment associated to the task.
+   */
+  auto userID = this->fromTaskIDToUserID.at(task->getID());
+  auto envUser = this->envBuilder->getUser(userID);
+  auto env = loopContent->getEnvironment();
+
+  /*
+   * The environment is allocated by the code that invokes the parallelized
+   * loop and its pointer is only given to the tasks. Hence, the environment
+   * cannot be accessed through the pointers used by the loop.
+   */
+  auto envArg = dyn_cast<Argument>(task->getEnvironment());
+  if (envArg == nullptr) {
+    return;
+  }
+  auto envArrayType = this->envBuilder->getEnvironmentArrayType();
+  auto envSize = DL.getTypeAllocSize(envArrayType).getFixedSize();
+  envArg->addAttr(Attribute::NoAlias);
+  envArg->addAttr(Attribute::NonNull);
+  envArg->addAttr(Attribute::getWithDereferenceableBytes(cxt, envSize));
+  envArg->addAttr(
+      Attribute::getWithAlignment(cxt, DL.getABITypeAlign(envArrayType)));
+
+  /*
+   * Create the alias scopes of the task:
+   * - one for the environment
+   * - one for each live-in pointer that points to a distinct object in the
+   *   original code (i.e., noalias arguments and stack objects)
+   */
+  MDBuilder mdBuilder(cxt);
+  auto domain =
+      mdBuilder.createAnonymousAliasScopeDomain(taskFunction->getName());
+  auto envScope = mdBuilder.createAnonymousAliasScope(domain, "environment");
+  std::unordered_map<Value *, MDNode *> scopes;
+  std::vector<Metadata *> allScopes{ envScope };
+  std::unordered_set<Instruction *> envLoads;
+  for (auto envID : envUser->getEnvIDsOfLiveInVars()) {
+    auto producer = env->getProducer(envID);
+    if (!task->isAnOriginalLiveIn(producer)) {
+      continue;
+    }
+    auto envLoad = dyn_cast<LoadInst>(task->getCloneOfOriginalLiveIn(producer));
+    if (envLoad == nullptr) {
+      continue;
+    }
+    envLoads.insert(envLoad);
+
+    /*
+     * Live-in values do not change while tasks run.
+     */
+    envLoad->setMetadata(LLVMContext::MD_invariant_load,
+                         MDNode::get(cxt, {}));
+    envLoad->setMetadata(LLVMContext::MD_alias_scope,
+                         MDNode::get(cxt, { envScope }));
+
+    /*
+     * Propagate what is known about the live-in pointer.
+     */
+    if (!producer->getType()->isPointerTy()) {
+      continue;
+    }
+    uint64_t dereferenceableBytes = 0;
+    MaybeAlign alignment;
+    auto isDistinctObject = false;
+    auto isNonNull = false;
+    if (auto argument = dyn_cast<Argument>(producer)) {
+      dereferenceableBytes = argument->getDereferenceableBytes();
+      alignment = argument->getParamAlign();
+      isDistinctObject = argument->hasNoAliasAttr();
+      isNonNull = argument->hasNonNullAttr();
+    } else if (auto alloca = dyn_cast<AllocaInst>(producer)) {
+      if (auto allocaSize = alloca->getAllocationSizeInBits(DL)) {
+        dereferenceableBytes = allocaSize->getFixedSize() / 8;
+      }
+      alignment = alloca->getAlign();
+      isDistinctObject = true;
+      isNonNull = true;
+    }
+    auto int64Type = Type::getInt64Ty(cxt);
+    if (dereferenceableBytes > 0) {
+      envLoad->setMetadata(
+          LLVMContext::MD_dereferenceable,
+          MDNode::get(cxt,
+                      { ConstantAsMetadata::get(ConstantInt::get(
+                          int64Type,
+                          dereferenceableBytes)) }));
+    }
+    if (alignment && (alignment->value() > 1)) {
+      envLoad->setMetadata(
+          LLVMContext::MD_align,
+          MDNode::get(cxt,
+                      { ConstantAsMetadata::get(
+                          ConstantInt::get(int64Type, alignment->value())) }));
+    }
+    if (isNonNull) {
+      envLoad->setMetadata(LLVMContext::MD_nonnull, MDNode::get(cxt, {}));
+    }
+    if (!isDistinctObject) {
+      continue;
+    }
+    auto scope =
+        mdBuilder.createAnonymousAliasScope(domain, producer->getName());
+    scopes[envLoad] = scope;
+    allScopes.push_back(scope);
+  }
+
+  /*
+   * Tag the memory accesses of the task with the scopes of the objects they
+   * access. An access that can only reach objects known to be distinct from
+   * the ones of a scope does not alias with it.
+   */
+  for (auto &inst : instructions(taskFunction)) {
+    if (envLoads.find(&inst) != envLoads.end()) {
+      continue;
+    }
+    auto pointer = getLoadStorePointerOperand(&inst);
+    if (pointer == nullptr) {
+      continue;
+    }
+
+    /*
+     * Classify the objects the access can reach.
+     */
+    SmallVector<const Value *, 4> objects;
+    getUnderlyingObjects(pointer, objects);
+    std::set<Metadata *> scopesOfAccess;
+    auto accessesOnlyIdentifiedObjects = true;
+    for (auto object : objects) {
+      if (object == envArg) {
+        scopesOfAccess.insert(envScope);
+        continue;
+      }
+      auto objectInst = const_cast<Value *>(object);
+      if (scopes.find(objectInst) != scopes.end()) {
+        scopesOfAccess.insert(scopes.at(objectInst));
+        continue;
+      }
+      if (!isIdentifiedObject(object)) {
+        accessesOnlyIdentifiedObjects = false;
+      }
+    }
+
+    /*
+     * The environment is never accessed through pointers that are not based
+     * on the environment argument.
+     */
+    std::vector<Metadata *> noAliasScopes;
+    for (auto scope : allScopes) {
+      if (scopesOfAccess.find(scope) != scopesOfAccess.end()) {
+        continue;
+      }
+      if ((scope != envScope) && !accessesOnlyIdentifiedObjects) {
+        continue;
+      }
+      noAliasScopes.push_back(scope);
+    }
+
+    /*
+     * Attach the metadata.
+     */
+    if (scopesOfAccess.size() > 0) {
+      std::vector<Metadata *> aliasScopes(scopesOfAccess.begin(),
+                                          scopesOfAccess.end());
+      inst.setMetadata(
+          LLVMContext::MD_alias_scope,
+          MDNode::concatenate(inst.getMetadata(LLVMContext::MD_alias_scope),
+                              MDNode::get(cxt, aliasScopes)));
+    }
+    if (noAliasScopes.size() > 0) {
+      inst.setMetadata(
+          LLVMContext::MD_noalias,
+          MDNode::concatenate(inst.getMetadata(LLVMContext::MD_noalias),
+                              MDNode::get(cxt, noAliasScopes)));
+    }
+  }
+
+  return;
+}
+
+} // namespace arcana::gino
@@ -0,0 +1,349 @@
+/*
+ * Copyright 2016 - 2023  Angelo Matni, Simone Campanoni
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arcana/gino/core/ParallelizationTechnique.hpp"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/MemoryBuiltins.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+
+namespace arcana::gino {
+
+/*
+ * Private copies of stack objects smaller than this number of bytes stay on
+ * the stack of the task, which is cheaper than any allocator.
+ */
+#define MINIMUM_BYTES_OF_PRIVATE_COPIES_TO_ALLOCATE 4096
+
+/*
+ * Check if the memory allocated by @allocation can only be reached by the
+ * function that allocates it.
+ * The calls that release it are added to @releases.
+ */
+static bool isAllocationPrivateToItsFunction(
+    Instruction *allocation,
+    std::map<Function *, Function *> &deallocators,
+    std::set<CallBase *> &releases) {
+  std::set<Value *> visited;
+  std::vector<Value *> pointers{ allocation };
+  while (!pointers.empty()) {
+    auto ptr = pointers.back();
+    pointers.pop_back();
+    if (!visited.insert(ptr).second) {
+      continue;
+    }
+    for (auto &use : ptr->uses()) {
+      auto user = use.getUser();
+
+      /*
+       * Accesses to the memory do not expose the pointer.
+       */
+      if (isa<LoadInst>(user) || isa<ICmpInst>(user)) {
+        continue;
+      }
+      if (auto storeInst = dyn_cast<StoreInst>(user)) {
+        if (storeInst->getValueOperand() == ptr) {
+          return false;
+        }
+        continue;
+      }
+
+      /*
+       * Pointers derived from the allocation must not escape either.
+       */
+      if (isa<GetElementPtrInst>(user) || isa<BitCastInst>(user)
+          || isa<PHINode>(user) || isa<SelectInst>(user)) {
+        pointers.push_back(user);
+        continue;
+      }
+
+      /*
+       * Calls can only release the memory or access it without capturing the
+       * pointer.
+       */
+      auto callInst = dyn_cast<CallBase>(user);
+      if (callInst == nullptr) {
+        return false;
+      }
+      if (isa<MemIntrinsic>(callInst) || callInst->isLifetimeStartOrEnd()) {
+        continue;
+      }
+      auto callee = callInst->getCalledFunction();
+      if ((callee == nullptr) || (deallocators.count(callee) == 0)
+          || !callInst->isArgOperand(&use)
+          || (callInst->getArgOperandNo(&use) != 0)) {
+        return false;
+      }
+      releases.insert(callInst);
+      if (callee->getName() == "realloc") {
+        pointers.push_back(callInst);
+      }
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Check if code that we do not compile can release memory it receives.
+ *
+ * Such code is a function declared in @program that is neither a library
+ * function known not to release memory nor an API of the runtime.
+ * The deallocators in @deallocators are substituted, so they do not count.
+ */
+static bool canExternalCodeReleaseMemory(
+    Module &program,
+    std::map<Function *, Function *> &deallocators) {
+  TargetLibraryInfoImpl TLII(Triple(program.getTargetTriple()));
+  TargetLibraryInfo TLI(TLII);
+  for (auto &F : program) {
+    if (!F.isDeclaration() || F.isIntrinsic() || F.use_empty()) {
+      continue;
+    }
+    if (deallocators.find(&F) != deallocators.end()) {
+      continue;
+    }
+
+    /*
+     * The runtime releases only the memory given to its deallocators.
+     */
+    auto name = F.getName();
+    if (name.startswith("NOELLE_") || name.startswith("HELIX_")
+        || name.startswith("queuePush") || name.startswith("queuePop")
+        || (name == "stageExecuter")) {
+      continue;
+    }
+
+    /*
+     * Library functions other than free and realloc do not release memory.
+     * getline and getdelim are not library functions known by LLVM, so they
+     * are handled conservatively.
+     */
+    LibFunc libFunction;
+    if (TLI.getLibFunc(F, libFunction)
+        && !isLibFreeFunction(&F, libFunction)
+        && !isReallocLikeFn(&F, &TLI)) {
+      continue;
+    }
+
+    /*
+     * Functions that cannot receive pointers cannot release memory either.
+     */
+    auto receivesPointers = F.isVarArg();
+    for (auto &arg : F.args()) {
+      if (arg.getType()->isPointerTy()) {
+        receivesPointers = true;
+        break;
+      }
+    }
+    if (!receivesPointers && !F.hasAddressTaken()) {
+      continue;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+void ParallelizationTechnique::enableThreadCachingAllocator(void) {
+  this->useThreadCachingAllocator = true;
+
+  return;
+}
+
+void ParallelizationTechnique::substituteMemoryAllocators(void) {
+
+  /*
+   * Fetch the APIs of the thread-caching allocator.
+   */
+  auto program = this->noelle.getProgram();
+  auto noelleMalloc = program->getFunction("NOELLE_malloc");
+  auto noelleCalloc = program->getFunction("NOELLE_calloc");
+  auto noelleRealloc = program->getFunction("NOELLE_realloc");
+  auto noelleFree = program->getFunction("NOELLE_free");
+  auto noelleFreeSized = program->getFunction("NOELLE_freeSized");
+  if ((noelleMalloc == nullptr) || (noelleCalloc == nullptr)
+      || (noelleRealloc == nullptr) || (noelleFree == nullptr)
+      || (noelleFreeSized == nullptr)) {
+    if (this->verbose != Verbosity::Disabled) {
+      errs()
+          << "WARNING: the thread-caching allocator couldn't be found. Memory allocators will not be substituted\n";
+    }
+    return;
+  }
+
+  /*
+   * Define the functions to substitute.
+   * We only substitute functions with the same signature of their substitute.
+   */
+  auto addSubstitution = [program](std::map<Function *, Function *> &m,
+                                   std::string name,
+                                   Function *substitute) {
+    auto f = program->getFunction(name);
+    if (f == nullptr) {
+      return;
+    }
+    if (f->getFunctionType() != substitute->getFunctionType()) {
+      return;
+    }
+    m[f] = substitute;
+  };
+  std::map<Function *, Function *> allocators;
+  addSubstitution(allocators, "malloc", noelleMalloc);
+  addSubstitution(allocators, "calloc", noelleCalloc);
+  addSubstitution(allocators, "_Znwm", noelleMalloc);
+  addSubstitution(allocators, "_Znam", noelleMalloc);
+  std::map<Function *, Function *> deallocators;
+  addSubstitution(deallocators, "free", noelleFree);
+  addSubstitution(deallocators, "realloc", noelleRealloc);
+  addSubstitution(deallocators, "_ZdlPv", noelleFree);
+  addSubstitution(deallocators, "_ZdaPv", noelleFree);
+  addSubstitution(deallocators, "_ZdlPvm", noelleFreeSized);
+  addSubstitution(deallocators, "_ZdaPvm", noelleFreeSized);
+
+  /*
+   * Substitute the allocations performed by the tasks.
+   *
+   * Code that is not compiled by us (e.g., getline) can release memory it
+   * receives with the system allocator.
+   * If such code exists, we only substitute the allocations that do not escape
+   * their task, and the calls that release them.
+   * Otherwise, the memory allocated by the tasks can also escape them, and it
+   * can be released by any code of the program, including by a different
+   * thread.
+   * The deallocators of the runtime forward the memory they do not own to the
+   * system allocator, so all deallocations of the program are substituted.
+   */
+  auto canMemoryEscape = !canExternalCodeReleaseMemory(*program, deallocators);
+  auto hasMemoryEscaped = false;
+  for (auto task : this->tasks) {
+    auto f = task->getTaskBody();
+    std::map<CallBase *, Function *> substitutions;
+    for (auto &I : instructions(f)) {
+
+      /*
+       * Fetch the next call to an allocator.
+       */
+      auto callI = dyn_cast<CallBase>(&I);
+      if (callI == nullptr) {
+        continue;
+      }
+      auto calleeF = callI->getCalledFunction();
+      if (calleeF == nullptr) {
+        continue;
+      }
+      if (allocators.find(calleeF) == allocators.end()) {
+        continue;
+      }
+
+      /*
+       * Check if the allocated memory does not escape the task.
+       */
+      std::set<CallBase *> releases;
+      if (!isAllocationPrivateToItsFunction(callI, deallocators, releases)) {
+        if (!canMemoryEscape) {
+          continue;
+        }
+        substitutions[callI] = allocators[calleeF];
+        hasMemoryEscaped = true;
+        continue;
+      }
+
+      /*
+       * Substitute the allocator and the deallocators.
+       */
+      substitutions[callI] = allocators[calleeF];
+      for (auto release : releases) {
+        substitutions[release] = deallocators[release->getCalledFunction()];
+      }
+    }
+    for (auto pair : substitutions) {
+      pair.first->setCalledFunction(pair.second);
+    }
+  }
+  if (hasMemoryEscaped) {
+    for (auto pair : deallocators) {
+      pair.first->replaceAllUsesWith(pair.second);
+    }
+  }
+
+  return;
+}
+
+Instruction *
+ParallelizationTechnique::allocatePrivateCopyWithThreadCachingAllocator(
+    Task *task,
+    AllocaInst *alloca,
+    IRBuilder<> &entryBuilder) {
+
+  /*
+   * Check the size of the stack object.
+   */
+  auto &DL = alloca->getFunction()->getParent()->getDataLayout();
+  auto sizeInBits = alloca->getAllocationSizeInBits(DL);
+  if (!sizeInBits.hasValue()) {
+    return nullptr;
+  }
+  uint64_t bytes = sizeInBits.getValue() / 8;
+  if (bytes < MINIMUM_BYTES_OF_PRIVATE_COPIES_TO_ALLOCATE) {
+    return nullptr;
+  }
+
+  /*
+   * Fetch the APIs of the thread-caching allocator.
+   */
+  auto program = this->noelle.getProgram();
+  auto noelleAlignedMalloc = program->getFunction("NOELLE_alignedMalloc");
+  auto noelleFree = program->getFunction("NOELLE_free");
+  if ((noelleAlignedMalloc == nullptr) || (noelleFree == nullptr)) {
+    return nullptr;
+  }
+
+  /*
+   * Allocate the private copy at the beginning of the task.
+   * It must be aligned as the stack object.
+   */
+  auto cm = this->noelle.getConstantsManager();
+  auto &entryBlock = *task->getTaskBody()->begin();
+  entryBuilder.SetInsertPoint(&*entryBlock.begin());
+  auto alignmentValue = cm->getIntegerConstant(alloca->getAlign().value(), 64);
+  auto bytesValue = cm->getIntegerConstant(bytes, 64);
+  auto allocation =
+      entryBuilder.CreateCall(noelleAlignedMalloc,
+                              { alignmentValue, bytesValue });
+  auto privateCopy = cast<Instruction>(
+      entryBuilder.CreateBitCast(allocation, alloca->getType()));
+
+  /*
+   * Free the private copy just before exiting the task.
+   */
+  auto exitBlock = task->getExit();
+  auto exitTerminator = exitBlock->getTerminator();
+  IRBuilder<> exitBuilder(exitBlock);
+  if (exitTerminator != nullptr) {
+    exitBuilder.SetInsertPoint(exitTerminator);
+  }
+  exitBuilder.CreateCall(noelleFree, { allocation });
+
+  return privateCopy;
+}
+
+} // namespace arcana::gino
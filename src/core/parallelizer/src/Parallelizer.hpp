@@ -23,6 +23,8 @@
 #define NOELLE_SRC_TOOLS_PARALLELIZER_H_
 
 #include "arcana/gino/core/DOALL.hpp"
+#include "arcana/gino/core/DOALLEarlyExit.hpp"
+#include "arcana/gino/core/DOALLProcesses.hpp"
 #include "arcana/gino/core/DSWP.hpp"
 #include "arcana/gino/core/HELIX.hpp"
 #include "arcana/gino/core/HeuristicsPass.hpp"
@@ -51,6 +53,18 @@ private:
    */
   bool forceParallelization;
   bool forceNoSCCPartition;
+  bool doallWithProcesses;
+  bool useThreadCachingAllocator;
+  bool doallWithTwoLevelChunks;
+  bool doallWithEarlyExits;
+  bool doallWithDeterministicReductions;
+  bool doallWithAtomicUpdates;
+  bool helixWithValueForwarding;
+  bool helixWithAtomicSequentialSegments;
+  bool helixWithDependenceDistances;
+  uint32_t helixIterationBatchFactor;
+  bool helixWithHelperThreads;
+  bool helixWithSynchronizationSkipping;
   std::vector<int> loopIndexesWhiteList;
   std::vector<int> loopIndexesBlackList;
 
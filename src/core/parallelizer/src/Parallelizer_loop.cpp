@@ -39,10 +39,92 @@ bool Parallelizer::parallelizeLoop(LoopContent *loopContent,
    */
   DSWP dswp{ par, this->forceParallelization, !this->forceNoSCCPartition };
   DOALL doall{ par };
+  DOALLProcesses doallProcesses{ par };
+  DOALLEarlyExit doallEarlyExit{ par };
   HELIX helix{ par, this->forceParallelization };
-  std::vector<ParallelizationTechnique *> parallelizationTechniques{ &doall,
-                                                                     &helix,
-                                                                     &dswp };
+  std::vector<ParallelizationTechnique *> parallelizationTechniques{ &doall };
+  if (this->doallWithProcesses) {
+
+    /*
+     * Loops that cannot use threads because of thread-unsafe library calls
+     * can still run their iterations within processes.
+     */
+    parallelizationTechniques.push_back(&doallProcesses);
+  }
+  if (this->doallWithEarlyExits) {
+
+    /*
+     * Search loops with multiple exits can run their iterations speculatively.
+     */
+    parallelizationTechniques.push_back(&doallEarlyExit);
+  }
+  parallelizationTechniques.push_back(&helix);
+  parallelizationTechniques.push_back(&dswp);
+
+  /*
+   * Set how DOALL tasks iterate over their chunks.
+   */
+  if (this->doallWithTwoLevelChunks) {
+    doall.enableTwoLevelChunking();
+    doallProcesses.enableTwoLevelChunking();
+  }
+
+  /*
+   * Set how DOALL computes floating-point sums.
+   * Processes are excluded because the partial sums they compute would not be
+   * sent back to the parent process.
+   */
+  if (this->doallWithDeterministicReductions) {
+    doall.enableDeterministicReductions();
+  }
+
+  /*
+   * Set how DOALL updates memory locations shared between iterations.
+   * Processes are excluded because they do not share memory.
+   */
+  if (this->doallWithAtomicUpdates) {
+    doall.enableAtomicUpdates();
+  }
+
+  /*
+   * Set how HELIX passes loop-carried values between cores.
+   */
+  if (this->helixWithValueForwarding) {
+    helix.enableValueForwarding();
+  }
+
+  /*
+   * Set whether single updates become atomic instructions and whether HELIX
+   * iterations wait only for the iterations they depend on.
+   */
+  if (this->helixWithAtomicSequentialSegments) {
+    helix.enableAtomicSequentialSegments();
+  }
+  if (this->helixWithDependenceDistances) {
+    helix.enableDependenceDistances();
+  }
+
+  /*
+   * Set the HELIX optimizations that are used without profiles.
+   */
+  if (this->helixIterationBatchFactor > 1) {
+    helix.enableIterationBatching(this->helixIterationBatchFactor);
+  }
+  if (this->helixWithHelperThreads) {
+    helix.enableHelperThreads();
+  }
+  if (this->helixWithSynchronizationSkipping) {
+    helix.enableSynchronizationSkipping();
+  }
+
+  /*
+   * Set the allocator to use within the parallelized code.
+   */
+  if (this->useThreadCachingAllocator) {
+    for (auto parallelizationTechnique : parallelizationTechniques) {
+      parallelizationTechnique->enableThreadCachingAllocator();
+    }
+  }
 
   /*
    * Fetch the profiles.
@@ -31,6 +31,75 @@ static cl::opt<bool> ForceParallelization(
     cl::ZeroOrMore,
     cl::Hidden,
     cl::desc("Force the parallelization"));
+static cl::opt<bool> DOALLWithProcesses(
+    "noelle-parallelizer-doall-processes",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc(
+        "Run DOALL loops that cannot use threads within forked processes"));
+static cl::opt<bool> ThreadCachingAllocator(
+    "noelle-parallelizer-thread-caching-allocator",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc(
+        "Use the thread-caching allocator within the parallelized code"));
+static cl::opt<bool> DOALLWithTwoLevelChunks(
+    "noelle-parallelizer-doall-two-level-chunks",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Iterate DOALL chunks with an outer loop around a counted loop"));
+static cl::opt<bool> DOALLWithEarlyExits(
+    "noelle-parallelizer-doall-early-exits",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Parallelize search loops with multiple exits with DOALL"));
+static cl::opt<bool> DOALLWithDeterministicReductions(
+    "noelle-parallelizer-doall-deterministic-reductions",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Compute DOALL floating-point sums independently of the number "
+             "of cores (not necessarily equal to the sequential sums)"));
+static cl::opt<bool> DOALLWithAtomicUpdates(
+    "noelle-parallelizer-doall-atomic-updates",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Perform DOALL updates of shared memory locations atomically"));
+static cl::opt<bool> HELIXWithValueForwarding(
+    "noelle-parallelizer-helix-value-forwarding",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Forward small HELIX loop-carried values within the lines of "
+             "the sequential segments"));
+static cl::opt<bool> HELIXWithAtomicSequentialSegments(
+    "noelle-parallelizer-helix-atomic-segments",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Lower HELIX sequential segments that are a single commutative "
+             "update to atomic instructions"));
+static cl::opt<bool> HELIXWithDependenceDistances(
+    "noelle-parallelizer-helix-dependence-distances",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Let a HELIX iteration wait only for the iteration its "
+             "loop-carried memory dependences come from"));
+static cl::opt<uint32_t> HELIXIterationBatchFactor(
+    "noelle-parallelizer-helix-iteration-batch",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::init(0),
+    cl::desc("Batch this number of consecutive HELIX iterations per core "
+             "instead of computing it from profiles"));
+static cl::opt<bool> HELIXWithHelperThreads(
+    "noelle-parallelizer-helix-helper-threads",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Run HELIX helper threads without checking profiles"));
+static cl::opt<bool> HELIXWithSynchronizationSkipping(
+    "noelle-parallelizer-helix-skip-synchronization",
+    cl::ZeroOrMore,
+    cl::Hidden,
+    cl::desc("Skip the HELIX synchronization of every sequential segment that "
+             "supports it without checking profiles"));
 static cl::opt<bool> ForceNoSCCPartition(
     "dswp-no-scc-merge",
     cl::ZeroOrMore,
@@ -50,7 +119,19 @@ static cl::list<int> LoopIndexesBlackList(
 Parallelizer::Parallelizer()
   : ModulePass{ ID },
     forceParallelization{ false },
-    forceNoSCCPartition{ false } {
+    forceNoSCCPartition{ false },
+    doallWithProcesses{ false },
+    useThreadCachingAllocator{ false },
+    doallWithTwoLevelChunks{ false },
+    doallWithEarlyExits{ false },
+    doallWithDeterministicReductions{ false },
+    doallWithAtomicUpdates{ false },
+    helixWithValueForwarding{ false },
+    helixWithAtomicSequentialSegments{ false },
+    helixWithDependenceDistances{ false },
+    helixIterationBatchFactor{ 0 },
+    helixWithHelperThreads{ false },
+    helixWithSynchronizationSkipping{ false } {
 
   return;
 }
@@ -58,6 +139,27 @@ Parallelizer::Parallelizer()
 bool Parallelizer::doInitialization(Module &M) {
   this->forceParallelization = (ForceParallelization.getNumOccurrences() > 0);
   this->forceNoSCCPartition = (ForceNoSCCPartition.getNumOccurrences() > 0);
+  this->doallWithProcesses = (DOALLWithProcesses.getNumOccurrences() > 0);
+  this->useThreadCachingAllocator =
+      (ThreadCachingAllocator.getNumOccurrences() > 0);
+  this->doallWithTwoLevelChunks =
+      (DOALLWithTwoLevelChunks.getNumOccurrences() > 0);
+  this->doallWithEarlyExits = (DOALLWithEarlyExits.getNumOccurrences() > 0);
+  this->doallWithDeterministicReductions =
+      (DOALLWithDeterministicReductions.getNumOccurrences() > 0);
+  this->doallWithAtomicUpdates =
+      (DOALLWithAtomicUpdates.getNumOccurrences() > 0);
+  this->helixWithValueForwarding =
+      (HELIXWithValueForwarding.getNumOccurrences() > 0);
+  this->helixWithAtomicSequentialSegments =
+      (HELIXWithAtomicSequentialSegments.getNumOccurrences() > 0);
+  this->helixWithDependenceDistances =
+      (HELIXWithDependenceDistances.getNumOccurrences() > 0);
+  this->helixIterationBatchFactor = HELIXIterationBatchFactor.getValue();
+  this->helixWithHelperThreads =
+      (HELIXWithHelperThreads.getNumOccurrences() > 0);
+  this->helixWithSynchronizationSkipping =
+      (HELIXWithSynchronizationSkipping.getNumOccurrences() > 0);
   this->loopIndexesWhiteList = LoopIndexesWhiteList;
   this->loopIndexesBlackList = LoopIndexesBlackList;
 
@@ -11,6 +11,15 @@ extern DispatcherInfo NOELLE_DOALLDispatcher(
     int64_t maxNumberOfCores,
     int64_t chunkSize);
 
+extern DispatcherInfo NOELLE_DOALLDispatcherProcesses(
+    void (*parallelizedLoop)(void *, int64_t, int64_t, int64_t),
+    void *env,
+    int64_t maxNumberOfCores,
+    int64_t chunkSize,
+    void **regions,
+    int64_t *regionSizes,
+    int64_t numberOfRegions);
+
 extern void queuePush8(void *, int8_t *);
 extern void queuePush16(void *, int16_t *);
 extern void queuePush32(void *, int32_t *);
@@ -30,6 +39,13 @@ extern DispatcherInfo NOELLE_DSWPDispatcher(void *env,
 
 extern void HELIX_wait(void *);
 extern void HELIX_signal(void *);
+extern void HELIX_waitForIteration(void *, int64_t);
+extern void HELIX_signalIteration(void *, int64_t);
+extern void HELIX_waitForPrecedingIterations(void *,
+                                             int64_t,
+                                             int64_t,
+                                             int64_t,
+                                             int64_t);
 extern DispatcherInfo NOELLE_HELIX_dispatcher_criticalSections(
     void (*parallelizedLoop)(void *,
                              void *,
@@ -56,8 +72,48 @@ extern DispatcherInfo NOELLE_HELIX_dispatcher_sequentialSegments(
     int64_t numCores,
     int64_t numOfsequentialSegments);
 
+extern DispatcherInfo NOELLE_HELIX_dispatcher_sequentialSegmentsWithHelpers(
+    void (*parallelizedLoop)(void *,
+                             void *,
+                             void *,
+                             void *,
+                             int64_t,
+                             int64_t,
+                             uint64_t *),
+    void *env,
+    void *loopCarriedArray,
+    int64_t numCores,
+    int64_t numOfsequentialSegments);
+
 extern uint32_t NOELLE_getAvailableCores(void);
 
+extern void *NOELLE_malloc(uint64_t bytes);
+extern void *NOELLE_alignedMalloc(uint64_t alignment, uint64_t bytes);
+extern void *NOELLE_calloc(uint64_t numberOfElements, uint64_t elementSize);
+extern void *NOELLE_realloc(void *ptr, uint64_t bytes);
+extern void NOELLE_free(void *ptr);
+extern void NOELLE_freeSized(void *ptr, uint64_t bytes);
+
+extern void *NOELLE_allocatePartialSums(int64_t numberOfPartialSums,
+                                        int64_t partialSumSize);
+extern double NOELLE_reduceDoublesInTreeOrder(double *partialSums,
+                                              int64_t numberOfPartialSums);
+extern float NOELLE_reduceFloatsInTreeOrder(float *partialSums,
+                                            int64_t numberOfPartialSums);
+
+extern int32_t NOELLE_areIndicesDistinct(void *indices,
+                                         int64_t numberOfIndices,
+                                         int64_t indexSize,
+                                         void *verdict);
+
+extern void NOELLE_lockStripe(void *address);
+extern void NOELLE_unlockStripe(void *address);
+
+extern int64_t NOELLE_materializeList(void *head,
+                                      int64_t nextOffset,
+                                      void ***nodes);
+extern void NOELLE_releaseList(void **nodes);
+
 void SIMONE_CAMPANONI_IS_GOING_TO_REMOVE_THIS_FUNCTION(void) {
   queuePush8(0, 0);
   queuePush16(0, 0);
@@ -74,12 +130,36 @@ void SIMONE_CAMPANONI_IS_GOING_TO_REMOVE_THIS_FUNCTION(void) {
 
   NOELLE_HELIX_dispatcher_criticalSections(0, 0, 0, 0, 0);
   NOELLE_HELIX_dispatcher_sequentialSegments(0, 0, 0, 0, 0);
+  NOELLE_HELIX_dispatcher_sequentialSegmentsWithHelpers(0, 0, 0, 0, 0);
   HELIX_wait(0);
   HELIX_signal(0);
+  HELIX_waitForIteration(0, 0);
+  HELIX_signalIteration(0, 0);
+  HELIX_waitForPrecedingIterations(0, 0, 0, 0, 0);
 
   int s;
   rand_r(&s);
   NOELLE_DOALLDispatcher(0, 0, 0, 0);
+  NOELLE_DOALLDispatcherProcesses(0, 0, 0, 0, 0, 0, 0);
 
   NOELLE_getAvailableCores();
+
+  NOELLE_malloc(0);
+  NOELLE_alignedMalloc(0, 0);
+  NOELLE_calloc(0, 0);
+  NOELLE_realloc(0, 0);
+  NOELLE_free(0);
+  NOELLE_freeSized(0, 0);
+
+  NOELLE_allocatePartialSums(0, 0);
+  NOELLE_reduceDoublesInTreeOrder(0, 0);
+  NOELLE_reduceFloatsInTreeOrder(0, 0);
+
+  NOELLE_areIndicesDistinct(0, 0, 0, 0);
+
+  NOELLE_lockStripe(0);
+  NOELLE_unlockStripe(0);
+
+  NOELLE_materializeList(0, 0, 0);
+  NOELLE_releaseList(0);
 }
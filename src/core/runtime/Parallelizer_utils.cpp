@@ -2,6 +2,9 @@
 #include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <limits>
+#include <map>
+#include <tuple>
 #include <pthread.h>
 #include <functional>
 #include <memory>
@@ -10,6 +13,12 @@
 #include <utility>
 #include <vector>
 #include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sched.h>
 
 #include <ThreadSafeQueue.hpp>
 #include <ThreadSafeLockFreeQueue.hpp>
@@ -54,6 +63,10 @@ public:
 
   uint32_t reserveCores(uint32_t coresRequested);
 
+  uint32_t reserveCoresToForkProcesses(uint32_t coresRequested);
+
+  void runWithinForkedProcess(void);
+
   void releaseCores(uint32_t coresReleased);
 
   uint32_t getAvailableCores(void);
@@ -64,6 +77,8 @@ public:
 
   ThreadPoolForCSingleQueue *virgil;
 
+  ThreadPoolForCSingleQueue *getHelperThreads(void);
+
   ~NoelleRuntime(void);
 
 private:
@@ -85,6 +100,13 @@ private:
   uint32_t maxCores;
 
   mutable pthread_spinlock_t spinLock;
+
+  /*
+   * Threads that run next to the workers on their SMT siblings.
+   * They are allocated the first time they are needed.
+   */
+  ThreadPoolForCSingleQueue *helperThreads;
+  std::once_flag helperThreadsFlag;
 };
 
 #ifdef RUNTIME_PROFILE
@@ -109,6 +131,324 @@ pthread_spinlock_t printLock;
 
 static NoelleRuntime runtime{};
 
+/*
+ * Only one HELIX loop at a time can use the SMT siblings of its workers.
+ */
+static std::atomic<bool> HELIX_siblingsAreInUse{ false };
+
+/*
+ * Table of locks that protect updates of shared memory locations that cannot
+ * be performed by native atomic instructions.
+ * Locks are hashed by address and padded to avoid false sharing.
+ */
+#define LOCK_STRIPES_BITS 10
+
+typedef struct {
+  std::atomic<bool> isLocked;
+  char padding[CACHE_LINE_SIZE - sizeof(std::atomic<bool>)];
+} LockStripe_t;
+
+static LockStripe_t lockStripes[1 << LOCK_STRIPES_BITS];
+
+static inline LockStripe_t *NOELLE_getLockStripe(void *address) {
+  auto hash = (((uint64_t)address) >> 3) * 0x9e3779b97f4a7c15ULL;
+
+  return &lockStripes[hash >> (64 - LOCK_STRIPES_BITS)];
+}
+
+/*
+ * Inspector of the indices used by indirect accesses.
+ */
+#define INSPECTOR_MIN_INDICES_PER_THREAD 65536
+
+typedef struct {
+  int64_t minIndex;
+  int64_t maxIndex;
+} IndicesSummary_t;
+
+/*
+ * Verdict of the inspector for one of its call sites.
+ * The compiler allocates one verdict per call site, initialized to zero.
+ * It also sets hasBeenWritten after every instruction that may write the
+ * indices inspected there, so a verdict is revalidated without reading the
+ * indices again.
+ */
+typedef struct {
+  const void *indices;
+  int64_t numberOfIndices;
+  int32_t areDistinct;
+  int32_t hasBeenWritten;
+} InspectorVerdict_t;
+
+static std::mutex inspectorVerdictsLock;
+
+template <typename F>
+struct InspectorWorker_t {
+  F *f;
+  int64_t threadID;
+  int64_t first;
+  int64_t last;
+  pthread_spinlock_t endLock;
+};
+
+template <typename F>
+static void NOELLE_inspectorTrampoline(void *args) {
+  auto worker = (InspectorWorker_t<F> *)args;
+  (*worker->f)(worker->threadID, worker->first, worker->last);
+  pthread_spin_unlock(&worker->endLock);
+
+  return;
+}
+
+/*
+ * Maximum number of threads that inspect @numberOfElements indices.
+ */
+static int64_t NOELLE_inspectorThreads(int64_t numberOfElements) {
+  return std::max<int64_t>(numberOfElements / INSPECTOR_MIN_INDICES_PER_THREAD,
+                           1);
+}
+
+/*
+ * Run @f over chunks of [0, @numberOfElements), one per thread.
+ * The threads are the ones of the runtime that are idle, up to
+ * @maxThreads - 1, plus the current one.
+ */
+template <typename F>
+static void NOELLE_inspectInParallel(int64_t numberOfElements,
+                                     int64_t maxThreads,
+                                     F f) {
+  int64_t threads = runtime.reserveCores(maxThreads);
+  auto elementsPerThread = (numberOfElements + threads - 1) / threads;
+  std::vector<InspectorWorker_t<F>> workers(threads - 1);
+  for (int64_t t = 1; t < threads; t++) {
+    auto worker = &workers[t - 1];
+    worker->f = &f;
+    worker->threadID = t;
+    worker->first = std::min(t * elementsPerThread, numberOfElements);
+    worker->last =
+        std::min(worker->first + elementsPerThread, numberOfElements);
+    pthread_spin_init(&worker->endLock, 0);
+    pthread_spin_lock(&worker->endLock);
+    runtime.virgil->submitAndDetach(NOELLE_inspectorTrampoline<F>, worker);
+  }
+  f(0, 0, std::min(elementsPerThread, numberOfElements));
+  for (auto &worker : workers) {
+    pthread_spin_lock(&worker.endLock);
+    pthread_spin_destroy(&worker.endLock);
+  }
+  runtime.releaseCores(threads);
+
+  return;
+}
+
+template <typename T>
+static IndicesSummary_t NOELLE_summarizeIndices(const T *indices,
+                                                int64_t numberOfIndices) {
+  auto threads = NOELLE_inspectorThreads(numberOfIndices);
+  std::vector<IndicesSummary_t> partials(
+      threads,
+      { std::numeric_limits<int64_t>::max(),
+        std::numeric_limits<int64_t>::min() });
+  NOELLE_inspectInParallel(
+      numberOfIndices,
+      threads,
+      [indices, &partials](int64_t t, int64_t first, int64_t last) {
+        int64_t minIndex = std::numeric_limits<int64_t>::max();
+        int64_t maxIndex = std::numeric_limits<int64_t>::min();
+        for (auto i = first; i < last; i++) {
+          int64_t index = indices[i];
+          minIndex = std::min(minIndex, index);
+          maxIndex = std::max(maxIndex, index);
+        }
+        partials[t] = { minIndex, maxIndex };
+      });
+
+  IndicesSummary_t summary = { std::numeric_limits<int64_t>::max(),
+                               std::numeric_limits<int64_t>::min() };
+  for (auto &partial : partials) {
+    if (partial.minIndex > partial.maxIndex) {
+      continue;
+    }
+    summary.minIndex = std::min(summary.minIndex, partial.minIndex);
+    summary.maxIndex = std::max(summary.maxIndex, partial.maxIndex);
+  }
+
+  return summary;
+}
+
+template <typename T>
+static int32_t NOELLE_inspectIndices(const T *indices,
+                                     int64_t numberOfIndices,
+                                     const IndicesSummary_t &summary) {
+
+  /*
+   * Indices spread over a range larger than the number of indices cannot be
+   * distinct.
+   */
+  auto range = (uint64_t)summary.maxIndex - (uint64_t)summary.minIndex + 1;
+  if (range < (uint64_t)numberOfIndices) {
+    return 0;
+  }
+
+  /*
+   * Use a bitmap when the range of the indices is dense enough.
+   */
+  if (range <= (8 * (uint64_t)numberOfIndices)) {
+    auto words = (range + 63) / 64;
+    std::unique_ptr<std::atomic<uint64_t>[]> bitmap(
+        new std::atomic<uint64_t>[words]());
+    std::atomic<bool> foundDuplicate{ false };
+    NOELLE_inspectInParallel(
+        numberOfIndices,
+        NOELLE_inspectorThreads(numberOfIndices),
+        [indices, &summary, &bitmap, &foundDuplicate](int64_t t,
+                                                      int64_t first,
+                                                      int64_t last) {
+          for (auto i = first; i < last; i++) {
+            auto bit = (uint64_t)((int64_t)indices[i] - summary.minIndex);
+            auto mask = ((uint64_t)1) << (bit % 64);
+            auto old =
+                bitmap[bit / 64].fetch_or(mask, std::memory_order_relaxed);
+            if (old & mask) {
+              foundDuplicate.store(true, std::memory_order_relaxed);
+              return;
+            }
+          }
+        });
+    return foundDuplicate.load() ? 0 : 1;
+  }
+
+  /*
+   * Sort a copy of the sparse indices.
+   */
+  std::vector<T> sortedIndices(indices, indices + numberOfIndices);
+  std::sort(sortedIndices.begin(), sortedIndices.end());
+  auto duplicate =
+      std::adjacent_find(sortedIndices.begin(), sortedIndices.end());
+
+  return (duplicate == sortedIndices.end()) ? 1 : 0;
+}
+
+template <typename T>
+static int32_t NOELLE_areIndicesOfTypeDistinct(const T *indices,
+                                               int64_t numberOfIndices,
+                                               InspectorVerdict_t *verdict) {
+
+  /*
+   * Check if the same indices have been inspected already at this call site
+   * and if they have not been written since then.
+   * A write that happens during the inspection leaves hasBeenWritten set, so
+   * the verdict computed here will not be reused.
+   */
+  {
+    std::lock_guard<std::mutex> guard(inspectorVerdictsLock);
+    auto hasBeenWritten =
+        __atomic_exchange_n(&verdict->hasBeenWritten, 0, __ATOMIC_ACQ_REL);
+    if ((hasBeenWritten == 0) && (verdict->indices == indices)
+        && (verdict->numberOfIndices == numberOfIndices)) {
+      return verdict->areDistinct;
+    }
+    verdict->indices = nullptr;
+  }
+
+  /*
+   * Inspect the indices.
+   */
+  auto summary = NOELLE_summarizeIndices(indices, numberOfIndices);
+  auto areDistinct = NOELLE_inspectIndices(indices, numberOfIndices, summary);
+  {
+    std::lock_guard<std::mutex> guard(inspectorVerdictsLock);
+    verdict->indices = indices;
+    verdict->numberOfIndices = numberOfIndices;
+    verdict->areDistinct = areDistinct;
+  }
+
+  return areDistinct;
+}
+
+/*
+ * Lists traversed by the current thread.
+ * Lists are keyed by their head and by the offset of their next pointers.
+ * Caches are per thread because the parallel loop that uses a vector
+ * completes before the thread that created the vector can ask for it again.
+ * A list is in use from its materialization until the exit of the loop that
+ * traverses it. If the same list is materialized again while it is in use
+ * (e.g., by a recursive call), the new traversal gets its own vector, which is
+ * freed at the exit of its loop.
+ */
+#define NOELLE_MAX_MATERIALIZED_LISTS 16
+
+typedef struct {
+  std::vector<void *> nodes;
+  bool isInUse;
+  uint64_t lastUse;
+} MaterializedList_t;
+
+static thread_local std::map<std::pair<void *, int64_t>, MaterializedList_t>
+    materializedLists;
+static thread_local std::map<void **, std::vector<void *> *> uncachedLists;
+static thread_local uint64_t materializedListsClock = 0;
+
+static inline void *NOELLE_getNextNode(void *node, int64_t nextOffset) {
+  return *(void **)(((char *)node) + nextOffset);
+}
+
+/*
+ * Fetch the vector to use for the list that starts from @head.
+ * Return nullptr if the list cannot use a cached vector.
+ */
+static MaterializedList_t *NOELLE_fetchMaterializedList(void *head,
+                                                        int64_t nextOffset) {
+  auto key = std::make_pair(head, nextOffset);
+  auto listIt = materializedLists.find(key);
+  if (listIt != materializedLists.end()) {
+    return listIt->second.isInUse ? nullptr : &listIt->second;
+  }
+
+  /*
+   * Make room for the new list by evicting the least recently used list that
+   * is not in use.
+   */
+  if (materializedLists.size() >= NOELLE_MAX_MATERIALIZED_LISTS) {
+    auto victimIt = materializedLists.end();
+    for (auto it = materializedLists.begin(); it != materializedLists.end();
+         it++) {
+      if (it->second.isInUse) {
+        continue;
+      }
+      if ((victimIt == materializedLists.end())
+          || (it->second.lastUse < victimIt->second.lastUse)) {
+        victimIt = it;
+      }
+    }
+    if (victimIt == materializedLists.end()) {
+      return nullptr;
+    }
+    materializedLists.erase(victimIt);
+  }
+
+  return &materializedLists[key];
+}
+
+/*
+ * Store in @nodes the list that starts from @head.
+ * Only the nodes currently reachable from @head are dereferenced: the
+ * pointers already stored in @nodes might belong to freed nodes.
+ * The storage of @nodes is reused, so chasing a list that was materialized
+ * before does not allocate memory.
+ */
+static void NOELLE_chaseList(std::vector<void *> &nodes,
+                             void *head,
+                             int64_t nextOffset) {
+  nodes.clear();
+  for (auto node = head; node != nullptr;
+       node = NOELLE_getNextNode(node, nextOffset)) {
+    nodes.push_back(node);
+  }
+
+  return;
+}
+
 extern "C" {
 
 /************************************ NOELLE public APIs **************/
@@ -127,6 +467,20 @@ DispatcherInfo NOELLE_DOALLDispatcher(
     int64_t maxNumberOfCores,
     int64_t chunkSize);
 
+/*
+ * Dispatch tasks to run a DOALL loop within forked processes.
+ * The memory regions given as input are merged back once all processes are
+ * done.
+ */
+DispatcherInfo NOELLE_DOALLDispatcherProcesses(
+    void (*parallelizedLoop)(void *, int64_t, int64_t, int64_t),
+    void *env,
+    int64_t maxNumberOfCores,
+    int64_t chunkSize,
+    void **regions,
+    int64_t *regionSizes,
+    int64_t numberOfRegions);
+
 /*
  * Dispatch tasks to run a HELIX loop.
  */
@@ -156,12 +510,98 @@ DispatcherInfo NOELLE_HELIX_dispatcher_criticalSections(
     int64_t numCores,
     int64_t numOfsequentialSegments);
 
+/*
+ * Dispatch tasks to run a HELIX loop where each task has a helper thread
+ * running on its SMT sibling.
+ * Helpers are used only if there are enough SMT siblings available.
+ */
+DispatcherInfo NOELLE_HELIX_dispatcher_sequentialSegmentsWithHelpers(
+    void (*parallelizedLoop)(void *,
+                             void *,
+                             void *,
+                             void *,
+                             int64_t,
+                             int64_t,
+                             uint64_t *),
+    void *env,
+    void *loopCarriedArray,
+    int64_t numCores,
+    int64_t numOfsequentialSegments);
+
 DispatcherInfo NOELLE_DSWPDispatcher(void *env,
                                      int64_t *queueSizes,
                                      void *stages,
                                      int64_t numberOfStages,
                                      int64_t numberOfQueues);
 
+/*
+ * Memory allocator with per-thread caches used by the parallelized code.
+ */
+void *NOELLE_malloc(uint64_t bytes);
+
+void *NOELLE_alignedMalloc(uint64_t alignment, uint64_t bytes);
+
+void *NOELLE_calloc(uint64_t numberOfElements, uint64_t elementSize);
+
+void *NOELLE_realloc(void *ptr, uint64_t bytes);
+
+void NOELLE_free(void *ptr);
+
+void NOELLE_freeSized(void *ptr, uint64_t bytes);
+
+/*
+ * Allocate @numberOfPartialSums partial sums of a deterministic reduction, each
+ * of @partialSumSize bytes and initialized to zero.
+ */
+void *NOELLE_allocatePartialSums(int64_t numberOfPartialSums,
+                                 int64_t partialSumSize);
+
+/*
+ * Combine the partial sums of a deterministic reduction.
+ * The partial sums are combined in a tree order that only depends on their
+ * number, so the result does not depend on the number of threads that
+ * computed them.
+ */
+double NOELLE_reduceDoublesInTreeOrder(double *partialSums,
+                                       int64_t numberOfPartialSums);
+
+float NOELLE_reduceFloatsInTreeOrder(float *partialSums,
+                                     int64_t numberOfPartialSums);
+
+/*
+ * Inspector of indirect accesses.
+ * Return 1 if the @numberOfIndices indices of @indexSize bytes each stored at
+ * @indices are distinct, 0 otherwise.
+ * The verdict is cached in @verdict, which belongs to the call site, and it is
+ * reused until the code writes the indices again.
+ */
+int32_t NOELLE_areIndicesDistinct(void *indices,
+                                  int64_t numberOfIndices,
+                                  int64_t indexSize,
+                                  void *verdict);
+
+/*
+ * Locks used by DOALL to update memory locations shared between iterations.
+ * The lock acquired depends only on the address given as input.
+ */
+void NOELLE_lockStripe(void *address);
+
+void NOELLE_unlockStripe(void *address);
+
+/*
+ * Materializer of the lists chased by loops.
+ * Store in @nodes the pointers of the list that starts from @head, where the
+ * next pointer of a node is stored @nextOffset bytes from its beginning.
+ * Return the number of nodes of the list.
+ * The list is chased again at every call, but the vector is reused if the same
+ * list is materialized again by the same thread.
+ * The vector must be released by NOELLE_releaseList when the loop that
+ * traverses it exits.
+ */
+int64_t NOELLE_materializeList(void *head, int64_t nextOffset, void ***nodes);
+
+void NOELLE_releaseList(void **nodes);
+
 /******************************************* Utils ********************/
 #ifdef RUNTIME_PROFILE
 static __inline__ int64_t rdtsc_s(void) {
@@ -448,109 +888,419 @@ DispatcherInfo NOELLE_DOALLDispatcher(
   return dispatcherInfo;
 }
 
-/**********************************************************************
- *                HELIX
- **********************************************************************/
-typedef struct {
-  void (*parallelizedLoop)(void *,
-                           void *,
-                           void *,
-                           void *,
-                           int64_t,
-                           int64_t,
-                           uint64_t *);
-  void *env;
-  void *loopCarriedArray;
-  void *ssArrayPast;
-  void *ssArrayFuture;
-  uint64_t coreID;
-  uint64_t numCores;
-  uint64_t *loopIsOverFlag;
-  pthread_spinlock_t endLock;
-} NOELLE_HELIX_args_t;
+DispatcherInfo NOELLE_DOALLDispatcherProcesses(
+    void (*parallelizedLoop)(void *, int64_t, int64_t, int64_t),
+    void *env,
+    int64_t maxNumberOfCores,
+    int64_t chunkSize,
+    void **regions,
+    int64_t *regionSizes,
+    int64_t numberOfRegions) {
 
-static void NOELLE_HELIXTrampoline(void *args) {
+  /*
+   * Set the number of cores to use.
+   * No other parallel loop can run while the processes are forked.
+   */
+  auto numCores = runtime.reserveCoresToForkProcesses(maxNumberOfCores);
+#ifdef RUNTIME_PRINT
+  std::cerr << "DOALL: Processes dispatcher: Start" << std::endl;
+  std::cerr << "DOALL: Processes dispatcher:   Number of cores: " << numCores
+            << std::endl;
+  std::cerr << "DOALL: Processes dispatcher:   Memory regions to merge: "
+            << numberOfRegions << std::endl;
+#endif
 
   /*
-   * Fetch the arguments.
+   * Compute the number of bytes of the memory regions that task instances can
+   * modify.
    */
-  auto HELIX_args = (NOELLE_HELIX_args_t *)args;
+  int64_t totalBytes = 0;
+  for (auto r = 0; r < numberOfRegions; r++) {
+    totalBytes += regionSizes[r];
+  }
 
   /*
-   * Invoke
+   * Take a snapshot of the memory regions before running the task instances.
+   * This is the baseline we use to identify the bytes modified by each
+   * process.
    */
-  HELIX_args->parallelizedLoop(HELIX_args->env,
-                               HELIX_args->loopCarriedArray,
-                               HELIX_args->ssArrayPast,
-                               HELIX_args->ssArrayFuture,
-                               HELIX_args->coreID,
-                               HELIX_args->numCores,
-                               HELIX_args->loopIsOverFlag);
+  auto snapshot = (uint8_t *)malloc(totalBytes + 1);
+  int64_t offset = 0;
+  for (auto r = 0; r < numberOfRegions; r++) {
+    memcpy(snapshot + offset, regions[r], regionSizes[r]);
+    offset += regionSizes[r];
+  }
 
-  pthread_spin_unlock(&(HELIX_args->endLock));
-  return;
-}
+  /*
+   * Allocate the memory shared between processes.
+   * Every process copies its version of the memory regions there.
+   */
+  auto sharedBytes = totalBytes * (numCores - 1) + 1;
+  auto shared = (uint8_t *)mmap(NULL,
+                                sharedBytes,
+                                PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_ANONYMOUS,
+                                -1,
+                                0);
+  if (shared == MAP_FAILED) {
+    std::cerr
+        << "DOALL: Processes dispatcher: ERROR = not enough memory to share the memory regions between processes"
+        << std::endl;
+    abort();
+  }
 
-static void HELIX_helperThread(void *ssArray,
-                               uint32_t numOfsequentialSegments,
-                               uint64_t *theLoopIsOver) {
+  /*
+   * Flush the I/O buffers so processes do not replicate pending outputs.
+   */
+  fflush(NULL);
 
-  while ((*theLoopIsOver) == 0) {
+  /*
+   * Fork the processes.
+   */
+  std::vector<pid_t> processes(numCores - 1, 0);
+  for (auto i = 0; i < (numCores - 1); ++i) {
+    auto pid = fork();
+    if (pid == 0) {
 
-    /*
-     * Prefetch all sequential segment cache lines of the current loop
-     * iteration.
-     */
-    for (auto i = 0; ((*theLoopIsOver) == 0) && (i < numOfsequentialSegments);
-         i++) {
+      /*
+       * We are in the child process.
+       *
+       * The threads of the runtime do not exist here.
+       * Prevent the child from using them.
+       */
+      runtime.runWithinForkedProcess();
+      HELIX_siblingsAreInUse = true;
 
       /*
-       * Fetch the pointer.
+       * Run the task instance.
+       * Live-in values are shared through the copy-on-write memory of the
+       * parent process.
        */
-      auto ptr = (uint64_t *)(((uint64_t)ssArray) + (i * CACHE_LINE_SIZE));
+      parallelizedLoop(env, i, numCores, chunkSize);
 
       /*
-       * Prefetch the cache line for the current sequential segment.
+       * Send the memory regions back to the parent process.
        */
-      while (((*theLoopIsOver) == 0) && ((*ptr) == 0))
-        ;
-    }
-  }
+      auto childRegions = shared + (totalBytes * i);
+      int64_t childOffset = 0;
+      for (auto r = 0; r < numberOfRegions; r++) {
+        memcpy(childRegions + childOffset, regions[r], regionSizes[r]);
+        childOffset += regionSizes[r];
+      }
 
-  return;
-}
+      /*
+       * Terminate the child process.
+       */
+      fflush(NULL);
+      _exit(0);
+    }
 
-static DispatcherInfo NOELLE_HELIX_dispatcher(
-    void (*parallelizedLoop)(void *,
-                             void *,
-                             void *,
-                             void *,
-                             int64_t,
-                             int64_t,
-                             uint64_t *),
-    void *env,
-    void *loopCarriedArray,
-    int64_t maxNumberOfCores,
-    int64_t numOfsequentialSegments,
-    bool LIO) {
+    /*
+     * Check if the process has been created.
+     */
+    if (pid < 0) {
+      std::cerr
+          << "DOALL: Processes dispatcher: ERROR = the process for the task instance "
+          << i << " could not be created" << std::endl;
+      abort();
+    }
+    processes[i] = pid;
+  }
+#ifdef RUNTIME_PRINT
+  std::cerr << "DOALL: Processes dispatcher:   Forked " << (numCores - 1)
+            << " processes" << std::endl;
+#endif
 
   /*
-   * Assumptions.
+   * Run a task in the current process.
+   * Its changes to memory are applied directly.
    */
-  assert(parallelizedLoop != NULL);
-  assert(env != NULL);
-  assert(maxNumberOfCores > 1);
+  parallelizedLoop(env, numCores - 1, numCores, chunkSize);
 
   /*
-   * Fetch VIRGIL
+   * Wait for the remaining task instances.
    */
-  auto virgil = runtime.virgil;
+  for (auto i = 0; i < (numCores - 1); ++i) {
+    int status;
+    waitpid(processes[i], &status, 0);
+    if ((!WIFEXITED(status)) || (WEXITSTATUS(status) != 0)) {
+      std::cerr
+          << "DOALL: Processes dispatcher: ERROR = the process for the task instance "
+          << i << " did not complete" << std::endl;
+      abort();
+    }
+  }
+#ifdef RUNTIME_PRINT
+  std::cerr << "DOALL: Processes dispatcher:   All task instances have completed"
+            << std::endl;
+#endif
 
   /*
-   * Reserve the cores.
+   * Merge the memory regions.
+   *
+   * Task instances of a DOALL loop write disjoint memory locations.
+   * Hence, we only need to copy back the bytes each process has modified.
    */
-  auto numCores = runtime.reserveCores(maxNumberOfCores);
-  assert(numCores >= 1);
+  for (auto i = 0; i < (numCores - 1); ++i) {
+    auto childRegions = shared + (totalBytes * i);
+    int64_t regionOffset = 0;
+    for (auto r = 0; r < numberOfRegions; r++) {
+      auto region = (uint8_t *)regions[r];
+      for (int64_t b = 0; b < regionSizes[r]; b++) {
+        auto childByte = childRegions[regionOffset + b];
+        if (childByte != snapshot[regionOffset + b]) {
+          region[b] = childByte;
+        }
+      }
+      regionOffset += regionSizes[r];
+    }
+  }
+
+  /*
+   * Free the cores and memory.
+   */
+  munmap(shared, sharedBytes);
+  free(snapshot);
+  runtime.releaseCores(numCores);
+
+  /*
+   * Prepare the return value.
+   */
+  DispatcherInfo dispatcherInfo;
+  dispatcherInfo.numberOfThreadsUsed = numCores;
+#ifdef RUNTIME_PRINT
+  std::cerr << "DOALL: Processes dispatcher: Exit" << std::endl;
+#endif
+
+  return dispatcherInfo;
+}
+
+/**********************************************************************
+ *                HELIX
+ **********************************************************************/
+typedef struct {
+  void (*parallelizedLoop)(void *,
+                           void *,
+                           void *,
+                           void *,
+                           int64_t,
+                           int64_t,
+                           uint64_t *);
+  void *env;
+  void *loopCarriedArray;
+  void *ssArrayPast;
+  void *ssArrayFuture;
+  uint64_t coreID;
+  uint64_t numCores;
+  uint64_t *loopIsOverFlag;
+  int32_t cpu;
+  pthread_spinlock_t endLock;
+} NOELLE_HELIX_args_t;
+
+typedef struct {
+  void *ssArray;
+  uint32_t numOfsequentialSegments;
+  uint64_t *loopIsOverFlag;
+  int32_t cpu;
+  std::atomic<uint32_t> *activeHelpers;
+} NOELLE_HELIX_helperArgs_t;
+
+/*
+ * Offset within the line of a sequential segment of the number of iterations
+ * completed by its core.
+ * Segments whose iterations depend on iterations more than one step back, or
+ * that are rarely entered, synchronize through it instead of the spinlock.
+ */
+static const uint64_t HELIX_completedIterationsOffset = 8;
+
+static inline void HELIX_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/*
+ * Pairs of logical CPUs that share a physical core and that the process can
+ * run on.
+ * The first CPU of a pair runs a worker and the second one its helper.
+ */
+static const std::vector<std::pair<int32_t, int32_t>> &HELIX_getSMTSiblings(
+    void) {
+  static std::vector<std::pair<int32_t, int32_t>> siblings;
+  static std::once_flag siblingsFlag;
+  std::call_once(siblingsFlag, []() {
+    cpu_set_t allowedCPUs;
+    CPU_ZERO(&allowedCPUs);
+    if (sched_getaffinity(0, sizeof(allowedCPUs), &allowedCPUs) != 0) {
+      return;
+    }
+    for (int32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (!CPU_ISSET(cpu, &allowedCPUs)) {
+        continue;
+      }
+
+      /*
+       * Read the siblings of the current CPU (e.g., "0,4" or "0-1").
+       */
+      char path[128];
+      snprintf(path,
+               sizeof(path),
+               "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+               cpu);
+      auto file = fopen(path, "r");
+      if (file == nullptr) {
+        continue;
+      }
+      int32_t first = -1;
+      int32_t second = -1;
+      char separator = 0;
+      auto fields = fscanf(file, "%d%c%d", &first, &separator, &second);
+      fclose(file);
+      if ((fields != 3) || (first != cpu)) {
+        continue;
+      }
+      if (separator == '-') {
+        second = first + 1;
+      }
+      if ((second == cpu) || (second >= CPU_SETSIZE)
+          || !CPU_ISSET(second, &allowedCPUs)) {
+        continue;
+      }
+      siblings.push_back(std::make_pair(first, second));
+    }
+  });
+
+  return siblings;
+}
+
+/*
+ * Pin the calling thread to @cpu and store its previous affinity in @previous.
+ */
+static bool HELIX_pinThread(int32_t cpu, cpu_set_t *previous) {
+  if (cpu < 0) {
+    return false;
+  }
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), previous)
+      != 0) {
+    return false;
+  }
+  cpu_set_t target;
+  CPU_ZERO(&target);
+  CPU_SET(cpu, &target);
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &target)
+         == 0;
+}
+
+static void HELIX_unpinThread(cpu_set_t *previous) {
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), previous);
+
+  return;
+}
+
+static void NOELLE_HELIXTrampoline(void *args) {
+
+  /*
+   * Fetch the arguments.
+   */
+  auto HELIX_args = (NOELLE_HELIX_args_t *)args;
+
+  /*
+   * Run on the CPU whose sibling runs the helper of this task.
+   */
+  cpu_set_t previousCPUs;
+  auto isPinned = HELIX_pinThread(HELIX_args->cpu, &previousCPUs);
+
+  /*
+   * Invoke
+   */
+  HELIX_args->parallelizedLoop(HELIX_args->env,
+                               HELIX_args->loopCarriedArray,
+                               HELIX_args->ssArrayPast,
+                               HELIX_args->ssArrayFuture,
+                               HELIX_args->coreID,
+                               HELIX_args->numCores,
+                               HELIX_args->loopIsOverFlag);
+
+  if (isPinned) {
+    HELIX_unpinThread(&previousCPUs);
+  }
+  pthread_spin_unlock(&(HELIX_args->endLock));
+  return;
+}
+
+static void HELIX_helperThread(void *ssArray,
+                               uint32_t numOfsequentialSegments,
+                               uint64_t *theLoopIsOver) {
+
+  while (__atomic_load_n(theLoopIsOver, __ATOMIC_ACQUIRE) == 0) {
+
+    /*
+     * Read the cache lines of the sequential segments the worker will wait
+     * on. This keeps them in the caches shared with the worker, so the
+     * worker does not miss when the previous core signals.
+     */
+    for (auto i = 0u; i < numOfsequentialSegments; i++) {
+      auto ptr =
+          (volatile int *)(((uint64_t)ssArray) + (i * CACHE_LINE_SIZE));
+      (void)(*ptr);
+      HELIX_pause();
+    }
+  }
+
+  return;
+}
+
+static void NOELLE_HELIXHelperTrampoline(void *args) {
+  auto helperArgs = (NOELLE_HELIX_helperArgs_t *)args;
+
+  cpu_set_t previousCPUs;
+  auto isPinned = HELIX_pinThread(helperArgs->cpu, &previousCPUs);
+  HELIX_helperThread(helperArgs->ssArray,
+                     helperArgs->numOfsequentialSegments,
+                     helperArgs->loopIsOverFlag);
+  if (isPinned) {
+    HELIX_unpinThread(&previousCPUs);
+  }
+
+  helperArgs->activeHelpers->fetch_sub(1, std::memory_order_release);
+  return;
+}
+
+static DispatcherInfo NOELLE_HELIX_dispatcher(
+    void (*parallelizedLoop)(void *,
+                             void *,
+                             void *,
+                             void *,
+                             int64_t,
+                             int64_t,
+                             uint64_t *),
+    void *env,
+    void *loopCarriedArray,
+    int64_t maxNumberOfCores,
+    int64_t numOfsequentialSegments,
+    bool LIO,
+    bool useHelpers) {
+
+  /*
+   * Assumptions.
+   */
+  assert(parallelizedLoop != NULL);
+  assert(env != NULL);
+  assert(maxNumberOfCores > 1);
+
+  /*
+   * Fetch VIRGIL
+   */
+  auto virgil = runtime.virgil;
+
+  /*
+   * Reserve the cores.
+   */
+  auto numCores = runtime.reserveCores(maxNumberOfCores);
+  assert(numCores >= 1);
 
 #ifdef RUNTIME_PRINT
   pthread_spin_lock(&printLock);
@@ -584,6 +1334,7 @@ static DispatcherInfo NOELLE_HELIX_dispatcher(
                 << numCores << " sequential segment arrays" << std::endl;
       abort();
     }
+    memset(ssArrays, 0, ssArraySize * numOfSSArrays);
 
     /*
      * Initialize the sequential segment arrays.
@@ -629,11 +1380,40 @@ static DispatcherInfo NOELLE_HELIX_dispatcher(
                  CACHE_LINE_SIZE,
                  sizeof(NOELLE_HELIX_args_t) * (numCores - 1));
 
+  /*
+   * Check if every task can have a helper on the SMT sibling of its core.
+   */
+  auto &siblings = HELIX_getSMTSiblings();
+  auto hasHelpers = useHelpers && LIO && (numOfsequentialSegments > 0)
+                    && (siblings.size() >= (uint64_t)numCores)
+                    && !HELIX_siblingsAreInUse.exchange(true);
+  std::vector<NOELLE_HELIX_helperArgs_t> argsForAllHelpers;
+  std::atomic<uint32_t> activeHelpers{ 0 };
+  if (hasHelpers) {
+    argsForAllHelpers.resize(numCores);
+  }
+#ifdef RUNTIME_PRINT
+  pthread_spin_lock(&printLock);
+  std::cerr << "HELIX: dispatcher:   Helper threads = " << hasHelpers
+            << std::endl;
+  pthread_spin_unlock(&printLock);
+#endif
+
   /*
    * Launch threads
    */
   uint64_t loopIsOverFlag = 0;
-  cpu_set_t cores;
+  auto launchHelper = [&](int64_t coreID, void *ssArrayPast) -> void {
+    auto helperArgs = &argsForAllHelpers[coreID];
+    helperArgs->ssArray = ssArrayPast;
+    helperArgs->numOfsequentialSegments = numOfsequentialSegments;
+    helperArgs->loopIsOverFlag = &loopIsOverFlag;
+    helperArgs->cpu = siblings[coreID].second;
+    helperArgs->activeHelpers = &activeHelpers;
+    activeHelpers.fetch_add(1, std::memory_order_relaxed);
+    runtime.getHelperThreads()->submitAndDetach(NOELLE_HELIXHelperTrampoline,
+                                                helperArgs);
+  };
   for (auto i = 0; i < (numCores - 1); ++i) {
 
     /*
@@ -676,18 +1456,10 @@ static DispatcherInfo NOELLE_HELIX_dispatcher(
     argsPerCore->coreID = i;
     argsPerCore->numCores = numCores;
     argsPerCore->loopIsOverFlag = &loopIsOverFlag;
+    argsPerCore->cpu = hasHelpers ? siblings[i].first : -1;
     pthread_spin_init(&(argsPerCore->endLock), PTHREAD_PROCESS_PRIVATE);
     pthread_spin_lock(&(argsPerCore->endLock));
 
-    /*
-     * Set the affinity for both the thread and its helper.
-     */
-    /*CPU_ZERO(&cores);
-    auto physicalCore = i * 2;
-    CPU_SET(physicalCore, &cores);
-    CPU_SET(physicalCore + 1, &cores);
-    */
-
     /*
      * Launch the thread.
      */
@@ -696,14 +1468,9 @@ static DispatcherInfo NOELLE_HELIX_dispatcher(
     /*
      * Launch the helper thread.
      */
-    continue;
-    /*localFutures.push_back(pool.submitToCores(
-      cores,
-      HELIX_helperThread,
-      ssArrayPast,
-      numOfsequentialSegments,
-      &loopIsOverFlag
-    ));*/
+    if (hasHelpers) {
+      launchHelper(i, ssArrayPast);
+    }
   }
 #ifdef RUNTIME_PRINT
   pthread_spin_lock(&printLock);
@@ -719,6 +1486,12 @@ static DispatcherInfo NOELLE_HELIX_dispatcher(
   auto futureID = 0;
   auto ssArrayPast = (void *)(((uint64_t)ssArrays) + (pastID * ssArraySize));
   auto ssArrayFuture = ssArrays;
+  cpu_set_t previousCPUs;
+  auto isPinned = false;
+  if (hasHelpers) {
+    isPinned = HELIX_pinThread(siblings[numCores - 1].first, &previousCPUs);
+    launchHelper(numCores - 1, ssArrayPast);
+  }
   parallelizedLoop(env,
                    loopCarriedArray,
                    ssArrayPast,
@@ -726,6 +1499,9 @@ static DispatcherInfo NOELLE_HELIX_dispatcher(
                    numCores - 1,
                    numCores,
                    &loopIsOverFlag);
+  if (isPinned) {
+    HELIX_unpinThread(&previousCPUs);
+  }
 
   /*
    * Wait for the remaining HELIX tasks.
@@ -733,6 +1509,19 @@ static DispatcherInfo NOELLE_HELIX_dispatcher(
   for (auto i = 0; i < (numCores - 1); ++i) {
     pthread_spin_lock(&(argsForAllCores[i].endLock));
   }
+
+  /*
+   * Stop the helpers.
+   * The tasks set the loop-is-over flag only when the loop has a sequential
+   * prologue, so we set it here.
+   */
+  if (hasHelpers) {
+    __atomic_store_n(&loopIsOverFlag, 1, __ATOMIC_RELEASE);
+    while (activeHelpers.load(std::memory_order_acquire) > 0) {
+      HELIX_pause();
+    }
+    HELIX_siblingsAreInUse.store(false);
+  }
 #ifdef RUNTIME_PRINT
   pthread_spin_lock(&printLock);
   std::cerr << "HELIX: dispatcher:   All task instances have completed"
@@ -782,6 +1571,28 @@ DispatcherInfo NOELLE_HELIX_dispatcher_sequentialSegments(
                                  loopCarriedArray,
                                  numCores,
                                  numOfsequentialSegments,
+                                 true,
+                                 false);
+}
+
+DispatcherInfo NOELLE_HELIX_dispatcher_sequentialSegmentsWithHelpers(
+    void (*parallelizedLoop)(void *,
+                             void *,
+                             void *,
+                             void *,
+                             int64_t,
+                             int64_t,
+                             uint64_t *),
+    void *env,
+    void *loopCarriedArray,
+    int64_t numCores,
+    int64_t numOfsequentialSegments) {
+  return NOELLE_HELIX_dispatcher(parallelizedLoop,
+                                 env,
+                                 loopCarriedArray,
+                                 numCores,
+                                 numOfsequentialSegments,
+                                 true,
                                  true);
 }
 
@@ -802,6 +1613,7 @@ DispatcherInfo NOELLE_HELIX_dispatcher_criticalSections(
                                  loopCarriedArray,
                                  numCores,
                                  numOfsequentialSegments,
+                                 false,
                                  false);
 }
 
@@ -865,6 +1677,73 @@ void HELIX_signal(void *sequentialSegment) {
   return;
 }
 
+void HELIX_waitForIteration(void *sequentialSegment, int64_t iterations) {
+
+  /*
+   * Fetch the number of iterations completed by the core that owns the
+   * sequential segment.
+   */
+  auto completedIterations =
+      (int64_t *)(((uint64_t)sequentialSegment)
+                  + HELIX_completedIterationsOffset);
+
+  /*
+   * Wait
+   */
+  while (__atomic_load_n(completedIterations, __ATOMIC_ACQUIRE)
+         < iterations) {
+    HELIX_pause();
+  }
+
+  return;
+}
+
+void HELIX_signalIteration(void *sequentialSegment, int64_t iterations) {
+
+  /*
+   * Fetch the number of iterations completed by the current core.
+   */
+  auto completedIterations =
+      (int64_t *)(((uint64_t)sequentialSegment)
+                  + HELIX_completedIterationsOffset);
+
+  /*
+   * Signal
+   */
+  __atomic_store_n(completedIterations, iterations, __ATOMIC_RELEASE);
+
+  return;
+}
+
+void HELIX_waitForPrecedingIterations(void *sequentialSegment,
+                                      int64_t ssArraySize,
+                                      int64_t core,
+                                      int64_t numCores,
+                                      int64_t iteration) {
+
+  /*
+   * Fetch the line of the sequential segment of the first core.
+   */
+  auto firstSequentialSegment =
+      ((uint64_t)sequentialSegment) - (core * ssArraySize);
+
+  /*
+   * Wait for every other core to complete the iterations that precede the
+   * current one.
+   * Each core completes its iterations in order, so checking its last
+   * iteration before the current one is enough.
+   */
+  for (int64_t back = 1; back < numCores; back++) {
+    auto producer = (core + numCores - back) % numCores;
+    auto producerSequentialSegment =
+        firstSequentialSegment + (producer * ssArraySize);
+    HELIX_waitForIteration((void *)producerSequentialSegment,
+                           iteration - back + 1);
+  }
+
+  return;
+}
+
 /**********************************************************************
  *                DSWP
  **********************************************************************/
@@ -1029,11 +1908,545 @@ DispatcherInfo NOELLE_DSWPDispatcher(void *env,
   return dispatcherInfo;
 }
 
+/**********************************************************************
+ *                Memory allocator
+ **********************************************************************/
+
+/*
+ * Blocks are grouped in size classes (powers of two from 16 bytes to 32 KiB).
+ * Each slab of the allocator heap only contains blocks of one size class.
+ * Bigger allocations are served by the system allocator.
+ */
+#define ALLOCATOR_MIN_BLOCK_BITS 4
+#define ALLOCATOR_SIZE_CLASSES 12
+#define ALLOCATOR_SLAB_BITS 16
+#define ALLOCATOR_HEAP_BYTES (1ULL << 36)
+#define ALLOCATOR_BATCH 32
+
+typedef struct {
+  pthread_spinlock_t lock;
+  void *batches;
+} NOELLE_allocator_pool_t;
+
+static uint8_t *allocatorHeap = nullptr;
+static uint8_t *allocatorSlabClasses = nullptr;
+static std::atomic<uint64_t> allocatorNextSlab{ 0 };
+static NOELLE_allocator_pool_t allocatorPools[ALLOCATOR_SIZE_CLASSES];
+static pthread_once_t allocatorInitialized = PTHREAD_ONCE_INIT;
+
+static void NOELLE_allocatorInitialize(void) {
+
+  /*
+   * Reserve the virtual memory of the heap.
+   * Physical pages are only used once touched.
+   */
+  auto heap = mmap(NULL,
+                   ALLOCATOR_HEAP_BYTES,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                   -1,
+                   0);
+  if (heap == MAP_FAILED) {
+
+    /*
+     * All allocations will be served by the system allocator.
+     */
+    return;
+  }
+
+  /*
+   * Initialize the global pools.
+   */
+  for (auto c = 0; c < ALLOCATOR_SIZE_CLASSES; c++) {
+    pthread_spin_init(&allocatorPools[c].lock, 0);
+    allocatorPools[c].batches = nullptr;
+  }
+  allocatorSlabClasses =
+      (uint8_t *)calloc(ALLOCATOR_HEAP_BYTES >> ALLOCATOR_SLAB_BITS, 1);
+  allocatorHeap = (uint8_t *)heap;
+
+  return;
+}
+
+static inline bool NOELLE_allocatorOwns(void *ptr) {
+  auto p = (uint8_t *)ptr;
+  return (allocatorHeap != nullptr) && (p >= allocatorHeap)
+         && (p < (allocatorHeap + ALLOCATOR_HEAP_BYTES));
+}
+
+static inline int32_t NOELLE_allocatorSizeClass(uint64_t bytes) {
+  if (bytes <= (1ULL << ALLOCATOR_MIN_BLOCK_BITS)) {
+    return 0;
+  }
+  auto bits = 64 - __builtin_clzll(bytes - 1);
+  auto sizeClass = bits - ALLOCATOR_MIN_BLOCK_BITS;
+  if (sizeClass >= ALLOCATOR_SIZE_CLASSES) {
+    return -1;
+  }
+
+  return sizeClass;
+}
+
+static inline uint64_t NOELLE_allocatorBlockSize(int32_t sizeClass) {
+  return 1ULL << (sizeClass + ALLOCATOR_MIN_BLOCK_BITS);
+}
+
+/*
+ * Per-thread cache of free blocks.
+ * A block freed by a thread goes to the cache of that thread, no matter which
+ * thread allocated it.
+ */
+class NoelleAllocatorCache {
+public:
+  void *freeLists[ALLOCATOR_SIZE_CLASSES] = {};
+  uint32_t numberOfFreeBlocks[ALLOCATOR_SIZE_CLASSES] = {};
+
+  void *allocate(int32_t sizeClass);
+
+  void release(void *block, int32_t sizeClass);
+
+  ~NoelleAllocatorCache(void);
+
+private:
+  void fetchBatch(int32_t sizeClass);
+
+  void returnBatch(int32_t sizeClass, uint32_t blocks);
+};
+
+static thread_local NoelleAllocatorCache allocatorCache;
+
+void *NoelleAllocatorCache::allocate(int32_t sizeClass) {
+
+  /*
+   * Refill the cache if needed.
+   */
+  if (this->freeLists[sizeClass] == nullptr) {
+    this->fetchBatch(sizeClass);
+    if (this->freeLists[sizeClass] == nullptr) {
+      return nullptr;
+    }
+  }
+
+  /*
+   * Pop a block.
+   */
+  auto block = (void **)this->freeLists[sizeClass];
+  this->freeLists[sizeClass] = block[0];
+  this->numberOfFreeBlocks[sizeClass]--;
+
+  return block;
+}
+
+void NoelleAllocatorCache::release(void *block, int32_t sizeClass) {
+
+  /*
+   * Push the block.
+   */
+  auto b = (void **)block;
+  b[0] = this->freeLists[sizeClass];
+  this->freeLists[sizeClass] = b;
+  this->numberOfFreeBlocks[sizeClass]++;
+
+  /*
+   * Return blocks to the global pool if this thread holds too many of them.
+   */
+  if (this->numberOfFreeBlocks[sizeClass] >= (2 * ALLOCATOR_BATCH)) {
+    this->returnBatch(sizeClass, ALLOCATOR_BATCH);
+  }
+
+  return;
+}
+
+void NoelleAllocatorCache::fetchBatch(int32_t sizeClass) {
+  auto pool = &allocatorPools[sizeClass];
+
+  /*
+   * Try to fetch a batch from the global pool.
+   * The first block of a batch points to the next batch.
+   */
+  pthread_spin_lock(&pool->lock);
+  auto batch = (void **)pool->batches;
+  if (batch != nullptr) {
+    pool->batches = batch[1];
+  }
+  pthread_spin_unlock(&pool->lock);
+  if (batch != nullptr) {
+    this->freeLists[sizeClass] = batch;
+    for (auto b = batch; b != nullptr; b = (void **)b[0]) {
+      this->numberOfFreeBlocks[sizeClass]++;
+    }
+    return;
+  }
+
+  /*
+   * Carve a new slab.
+   */
+  auto slab = allocatorNextSlab.fetch_add(1);
+  if (slab >= (ALLOCATOR_HEAP_BYTES >> ALLOCATOR_SLAB_BITS)) {
+    return;
+  }
+  allocatorSlabClasses[slab] = sizeClass;
+  auto slabStart = allocatorHeap + (slab << ALLOCATOR_SLAB_BITS);
+  auto blockSize = NOELLE_allocatorBlockSize(sizeClass);
+  auto blocks = (1ULL << ALLOCATOR_SLAB_BITS) / blockSize;
+  for (auto i = 0; i < blocks; i++) {
+    auto b = (void **)(slabStart + (i * blockSize));
+    b[0] = this->freeLists[sizeClass];
+    this->freeLists[sizeClass] = b;
+  }
+  this->numberOfFreeBlocks[sizeClass] += blocks;
+
+  return;
+}
+
+void NoelleAllocatorCache::returnBatch(int32_t sizeClass, uint32_t blocks) {
+
+  /*
+   * Detach a batch from the local free list.
+   */
+  auto batch = (void **)this->freeLists[sizeClass];
+  if (batch == nullptr) {
+    return;
+  }
+  auto last = batch;
+  for (auto i = 1; (i < blocks) && (last[0] != nullptr); i++) {
+    last = (void **)last[0];
+    this->numberOfFreeBlocks[sizeClass]--;
+  }
+  this->numberOfFreeBlocks[sizeClass]--;
+  this->freeLists[sizeClass] = last[0];
+  last[0] = nullptr;
+
+  /*
+   * Give the batch to the global pool.
+   */
+  auto pool = &allocatorPools[sizeClass];
+  pthread_spin_lock(&pool->lock);
+  batch[1] = pool->batches;
+  pool->batches = batch;
+  pthread_spin_unlock(&pool->lock);
+
+  return;
+}
+
+NoelleAllocatorCache::~NoelleAllocatorCache(void) {
+
+  /*
+   * Give all free blocks back to the global pools.
+   */
+  for (auto c = 0; c < ALLOCATOR_SIZE_CLASSES; c++) {
+    while (this->freeLists[c] != nullptr) {
+      this->returnBatch(c, ALLOCATOR_BATCH);
+    }
+  }
+
+  return;
+}
+
+void *NOELLE_malloc(uint64_t bytes) {
+
+  /*
+   * Initialize the allocator.
+   */
+  pthread_once(&allocatorInitialized, NOELLE_allocatorInitialize);
+
+  /*
+   * Check if the allocation is served by the system allocator.
+   */
+  auto sizeClass = NOELLE_allocatorSizeClass(bytes);
+  if ((sizeClass < 0) || (allocatorHeap == nullptr)) {
+    return malloc(bytes);
+  }
+
+  /*
+   * Allocate a block from the cache of the current thread.
+   */
+  auto block = allocatorCache.allocate(sizeClass);
+  if (block == nullptr) {
+    return malloc(bytes);
+  }
+
+  return block;
+}
+
+void *NOELLE_alignedMalloc(uint64_t alignment, uint64_t bytes) {
+
+  /*
+   * Check if the block given by the allocator is aligned already.
+   */
+  auto ptr = NOELLE_malloc(bytes);
+  if ((ptr == nullptr) || (alignment == 0)
+      || ((((uint64_t)ptr) % alignment) == 0)) {
+    return ptr;
+  }
+  NOELLE_free(ptr);
+
+  /*
+   * Ask the system allocator for the alignment.
+   */
+  if (alignment < sizeof(void *)) {
+    alignment = sizeof(void *);
+  }
+  void *alignedPtr = nullptr;
+  if (posix_memalign(&alignedPtr, alignment, bytes) != 0) {
+    return nullptr;
+  }
+
+  return alignedPtr;
+}
+
+void *NOELLE_calloc(uint64_t numberOfElements, uint64_t elementSize) {
+
+  /*
+   * Check overflows.
+   */
+  auto bytes = numberOfElements * elementSize;
+  if ((elementSize != 0) && ((bytes / elementSize) != numberOfElements)) {
+    return nullptr;
+  }
+
+  /*
+   * Allocate and initialize the memory.
+   */
+  auto ptr = NOELLE_malloc(bytes);
+  if (ptr != nullptr) {
+    memset(ptr, 0, bytes);
+  }
+
+  return ptr;
+}
+
+void NOELLE_free(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  /*
+   * Check if the memory has been allocated by the system allocator.
+   */
+  if (!NOELLE_allocatorOwns(ptr)) {
+    free(ptr);
+    return;
+  }
+
+  /*
+   * Give the block to the cache of the current thread.
+   */
+  auto slab = ((uint8_t *)ptr - allocatorHeap) >> ALLOCATOR_SLAB_BITS;
+  auto sizeClass = allocatorSlabClasses[slab];
+  allocatorCache.release(ptr, sizeClass);
+
+  return;
+}
+
+void NOELLE_freeSized(void *ptr, uint64_t bytes) {
+  NOELLE_free(ptr);
+
+  return;
+}
+
+void *NOELLE_realloc(void *ptr, uint64_t bytes) {
+  if (ptr == nullptr) {
+    return NOELLE_malloc(bytes);
+  }
+
+  /*
+   * Check if the memory has been allocated by the system allocator.
+   */
+  if (!NOELLE_allocatorOwns(ptr)) {
+    return realloc(ptr, bytes);
+  }
+  if (bytes == 0) {
+    NOELLE_free(ptr);
+    return nullptr;
+  }
+
+  /*
+   * Check if the current block is big enough.
+   */
+  auto slab = ((uint8_t *)ptr - allocatorHeap) >> ALLOCATOR_SLAB_BITS;
+  auto blockSize = NOELLE_allocatorBlockSize(allocatorSlabClasses[slab]);
+  if (bytes <= blockSize) {
+    return ptr;
+  }
+
+  /*
+   * Move the data to a bigger block.
+   */
+  auto newPtr = NOELLE_malloc(bytes);
+  if (newPtr == nullptr) {
+    return nullptr;
+  }
+  memcpy(newPtr, ptr, blockSize);
+  NOELLE_free(ptr);
+
+  return newPtr;
+}
+
 uint32_t NOELLE_getAvailableCores(void) {
   auto idleCores = runtime.getAvailableCores();
 
   return idleCores;
 }
+
+void *NOELLE_allocatePartialSums(int64_t numberOfPartialSums,
+                                 int64_t partialSumSize) {
+  auto partialSums = calloc(numberOfPartialSums, partialSumSize);
+  if ((partialSums == nullptr) && (numberOfPartialSums > 0)
+      && (partialSumSize > 0)) {
+    std::cerr << "DOALL: deterministic reductions: ERROR = not enough memory "
+                 "to allocate "
+              << numberOfPartialSums << " partial sums" << std::endl;
+    abort();
+  }
+
+  return partialSums;
+}
+
+double NOELLE_reduceDoublesInTreeOrder(double *partialSums,
+                                       int64_t numberOfPartialSums) {
+  if (numberOfPartialSums <= 0) {
+    return 0;
+  }
+
+  /*
+   * Combine pairs of partial sums at increasing distances.
+   */
+  for (int64_t distance = 1; distance < numberOfPartialSums; distance *= 2) {
+    for (int64_t i = 0; (i + distance) < numberOfPartialSums;
+         i += 2 * distance) {
+      partialSums[i] += partialSums[i + distance];
+    }
+  }
+
+  return partialSums[0];
+}
+
+float NOELLE_reduceFloatsInTreeOrder(float *partialSums,
+                                     int64_t numberOfPartialSums) {
+  if (numberOfPartialSums <= 0) {
+    return 0;
+  }
+
+  /*
+   * Combine pairs of partial sums at increasing distances.
+   */
+  for (int64_t distance = 1; distance < numberOfPartialSums; distance *= 2) {
+    for (int64_t i = 0; (i + distance) < numberOfPartialSums;
+         i += 2 * distance) {
+      partialSums[i] += partialSums[i + distance];
+    }
+  }
+
+  return partialSums[0];
+}
+
+int32_t NOELLE_areIndicesDistinct(void *indices,
+                                  int64_t numberOfIndices,
+                                  int64_t indexSize,
+                                  void *verdict) {
+  if (numberOfIndices <= 1) {
+    return 1;
+  }
+
+  auto v = (InspectorVerdict_t *)verdict;
+  switch (indexSize) {
+    case 1:
+      return NOELLE_areIndicesOfTypeDistinct((int8_t *)indices,
+                                             numberOfIndices,
+                                             v);
+    case 2:
+      return NOELLE_areIndicesOfTypeDistinct((int16_t *)indices,
+                                             numberOfIndices,
+                                             v);
+    case 4:
+      return NOELLE_areIndicesOfTypeDistinct((int32_t *)indices,
+                                             numberOfIndices,
+                                             v);
+    case 8:
+      return NOELLE_areIndicesOfTypeDistinct((int64_t *)indices,
+                                             numberOfIndices,
+                                             v);
+  }
+
+  return 0;
+}
+
+void NOELLE_lockStripe(void *address) {
+  auto stripe = NOELLE_getLockStripe(address);
+  while (stripe->isLocked.exchange(true, std::memory_order_acquire)) {
+    while (stripe->isLocked.load(std::memory_order_relaxed)) {
+    }
+  }
+
+  return;
+}
+
+void NOELLE_unlockStripe(void *address) {
+  auto stripe = NOELLE_getLockStripe(address);
+  stripe->isLocked.store(false, std::memory_order_release);
+
+  return;
+}
+
+int64_t NOELLE_materializeList(void *head, int64_t nextOffset, void ***nodes) {
+  if (head == nullptr) {
+    *nodes = nullptr;
+    return 0;
+  }
+
+  /*
+   * Chase the list into a cached vector if it is not in use already.
+   */
+  auto list = NOELLE_fetchMaterializedList(head, nextOffset);
+  if (list != nullptr) {
+    NOELLE_chaseList(list->nodes, head, nextOffset);
+    list->isInUse = true;
+    list->lastUse = materializedListsClock++;
+    *nodes = list->nodes.data();
+    return list->nodes.size();
+  }
+
+  /*
+   * Chase the list into a vector owned by the current traversal.
+   */
+  auto uncachedList = new std::vector<void *>();
+  NOELLE_chaseList(*uncachedList, head, nextOffset);
+  *nodes = uncachedList->data();
+  uncachedLists[*nodes] = uncachedList;
+
+  return uncachedList->size();
+}
+
+void NOELLE_releaseList(void **nodes) {
+  if (nodes == nullptr) {
+    return;
+  }
+
+  /*
+   * Free the vector if it is owned by the traversal that just completed.
+   */
+  auto uncachedIt = uncachedLists.find(nodes);
+  if (uncachedIt != uncachedLists.end()) {
+    delete uncachedIt->second;
+    uncachedLists.erase(uncachedIt);
+    return;
+  }
+
+  /*
+   * Make the cached vector available to the next traversal of its list.
+   */
+  for (auto &keyAndList : materializedLists) {
+    auto &list = keyAndList.second;
+    if (list.isInUse && (list.nodes.data() == nodes)) {
+      list.isInUse = false;
+      break;
+    }
+  }
+
+  return;
+
+}
 }
 
 NoelleRuntime::NoelleRuntime() {
@@ -1050,10 +2463,19 @@ NoelleRuntime::NoelleRuntime() {
    * Allocate VIRGIL
    */
   this->virgil = new ThreadPoolForCSingleQueue(false, maxCores);
+  this->helperThreads = nullptr;
 
   return;
 }
 
+ThreadPoolForCSingleQueue *NoelleRuntime::getHelperThreads(void) {
+  std::call_once(this->helperThreadsFlag, [this]() {
+    this->helperThreads = new ThreadPoolForCSingleQueue(false, this->maxCores);
+  });
+
+  return this->helperThreads;
+}
+
 DOALL_args_t *NoelleRuntime::getDOALLArgs(uint32_t cores, uint32_t *index) {
   DOALL_args_t *argsForAllCores = nullptr;
 
@@ -1137,6 +2559,42 @@ uint32_t NoelleRuntime::reserveCores(uint32_t coresRequested) {
   return numCores;
 }
 
+uint32_t NoelleRuntime::reserveCoresToForkProcesses(uint32_t coresRequested) {
+
+  /*
+   * Processes can only be forked while no other parallel loop runs.
+   * This guarantees the threads of the runtime are idle, so none of them holds
+   * a lock the child processes could inherit.
+   * Otherwise, the loop runs within the current process only.
+   */
+  pthread_spin_lock(&this->spinLock);
+  uint32_t numCores = 1;
+  if (this->NOELLE_idleCores == ((int32_t)this->maxCores)) {
+    numCores = (this->NOELLE_idleCores >= coresRequested) ? coresRequested
+                                                          : NOELLE_idleCores;
+    if (numCores < 1) {
+      numCores = 1;
+    }
+  }
+  this->NOELLE_idleCores -= numCores;
+  pthread_spin_unlock(&this->spinLock);
+
+  return numCores;
+}
+
+void NoelleRuntime::runWithinForkedProcess(void) {
+
+  /*
+   * Only the thread that forked exists within the child process.
+   * So parallel loops invoked by the child must run sequentially.
+   */
+  pthread_spin_init(&this->spinLock, 0);
+  pthread_spin_init(&this->doallMemoryLock, 0);
+  this->NOELLE_idleCores = 0;
+
+  return;
+}
+
 void NoelleRuntime::releaseCores(uint32_t coresReleased) {
   assert(coresReleased > 0);
 
@@ -1189,4 +2647,5 @@ uint32_t NoelleRuntime::getAvailableCores(void) {
 
 NoelleRuntime::~NoelleRuntime(void) {
   delete this->virgil;
+  delete this->helperThreads;
 }
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+void scale (long long *dst, long long *src, long long elements){
+  for (long long i = 0; i < elements; i++){
+    dst[i] = (src[i] * 3 + 1) % 1000003;
+  }
+
+  return ;
+}
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto elements = atoll(argv[1]) * 1000;
+
+  /*
+   * Allocate space.
+   */
+  auto values = (long long *)malloc(2 * elements * sizeof(long long));
+  if (values == NULL){
+    fprintf(stderr, "ERROR: %lld elements couldn't be allocated\n", elements);
+    return 1;
+  }
+  for (auto i = 0; i < 2 * elements; i++){
+    values[i] = i % 17;
+  }
+
+  /*
+   * Hot code.
+   * The arrays are disjoint the first time and they overlap the second one.
+   */
+  scale(values + elements, values, elements);
+  scale(values + 1, values, elements);
+
+  /*
+   * Print the result.
+   */
+  long long total = 0;
+  for (auto i = 0; i < 2 * elements; i++){
+    total += values[i] * (i % 5);
+  }
+  printf("%lld\n", total);
+
+  free(values);
+  return 0;
+}
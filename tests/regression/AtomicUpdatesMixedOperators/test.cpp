@@ -0,0 +1,43 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+long long histogram[16];
+long long mixed[4];
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto iterations = atoll(argv[1]) * 1000;
+
+  /*
+   * Hot code.
+   * The histogram is only updated by additions, while the other locations
+   * are updated by operators that do not commute with each other.
+   */
+  for (auto i = 0; i < iterations; i++){
+    auto value = (i * 13) % 101;
+    histogram[value % 16] += value;
+  }
+  for (auto i = 0; i < iterations; i++){
+    mixed[i % 4] += i;
+    mixed[i % 4] ^= (i * 7);
+  }
+
+  /*
+   * Print the result.
+   */
+  for (auto i = 0; i < 16; i++){
+    printf("%lld\n", histogram[i]);
+  }
+  for (auto i = 0; i < 4; i++){
+    printf("%lld\n", mixed[i]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   * The number of iterations is not a multiple of the blocks of iterations
+   * whose sums are computed sequentially.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto iterations = atoll(argv[1]) * 1000 + 37;
+
+  /*
+   * Hot code.
+   *
+   * The sums are computed in a different order than the sequential one.
+   * So the values added are multiples of a power of two that keep every
+   * partial sum exact, whatever order the sums are computed in.
+   */
+  double sum = 0.5;
+  float sumOfQuarters = 0;
+  for (auto i = 0; i < iterations; i++){
+    sum += (i % 1000) / 8.0;
+    sumOfQuarters += (float)(i % 64) * 0.25f;
+  }
+
+  /*
+   * Print the result.
+   */
+  printf("%.3f %.2f\n", sum, sumOfQuarters);
+
+  return 0;
+}
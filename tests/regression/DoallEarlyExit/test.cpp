@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+int *values;
+
+long long search (const int *array, long long elements, int key){
+  long long i;
+  for (i = 0; i < elements; i++){
+    if (array[i] == key){
+      break;
+    }
+  }
+
+  return i;
+}
+
+long long searchWithDivision (long long elements, int key){
+  long long i;
+  for (i = 0; i < elements; i++){
+    if ((key / values[i]) == 0){
+      break;
+    }
+  }
+
+  return i;
+}
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto elements = atoll(argv[1]) * 1000;
+
+  /*
+   * Allocate space.
+   */
+  values = (int *)malloc(elements * sizeof(int));
+  if (values == NULL){
+    fprintf(stderr, "ERROR: %lld integers couldn't be allocated\n", elements);
+    return 1;
+  }
+  for (auto i = 0; i < elements; i++){
+    values[i] = (i * 7) % 1000 + 1;
+  }
+
+  /*
+   * Hot code.
+   * The first searches read the heap array up to a bound known only at run
+   * time.
+   * The last search would divide by zero after the iteration that leaves the
+   * loop.
+   */
+  auto found = search(values, elements, 999);
+  auto notFound = search(values, elements, -1);
+  values[elements / 2] = 0;
+  values[elements / 3] = 3000;
+  auto divided = searchWithDivision(elements, 2000);
+
+  /*
+   * Print the result.
+   */
+  printf("%lld %lld %lld\n", found, notFound, divided);
+
+  free(values);
+  return 0;
+}
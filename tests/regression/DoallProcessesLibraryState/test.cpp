@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto iterations = atoll(argv[1]) * 1000;
+
+  /*
+   * Allocate space.
+   */
+  auto lengths = (size_t *)calloc(iterations, sizeof(size_t));
+  if (lengths == NULL){
+    fprintf(stderr, "ERROR: %lld lengths couldn't be allocated\n", iterations);
+    return 1;
+  }
+
+  /*
+   * Hot code.
+   * strerror returns a buffer that belongs to the library.
+   * The lengths are written to the heap, so they are merged back from the
+   * processes that compute them.
+   */
+  for (auto i = 0; i < iterations; i++){
+    lengths[i] = strlen(strerror(i % 64)) * (i % 7);
+  }
+
+  /*
+   * Print the result.
+   */
+  size_t total = 0;
+  for (auto i = 0; i < iterations; i++){
+    total += lengths[i];
+  }
+  printf("%zu\n", total);
+
+  free(lengths);
+  return 0;
+}
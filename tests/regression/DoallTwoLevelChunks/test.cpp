@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   * The number of iterations is not a multiple of the number of cores times
+   * the chunk size, so the last chunk is partial.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto elements = atoll(argv[1]) * 1000 + 13;
+
+  /*
+   * Allocate space.
+   */
+  auto values = (long long *)calloc(elements, sizeof(long long));
+  if (values == NULL){
+    fprintf(stderr, "ERROR: %lld elements couldn't be allocated\n", elements);
+    return 1;
+  }
+
+  /*
+   * Hot code.
+   * The loops go forward by one, forward by more than one, and backward.
+   */
+  for (long long i = 0; i < elements; i++){
+    values[i] = i * 3;
+  }
+  for (long long i = 1; i < elements; i += 3){
+    values[i] += i % 17;
+  }
+  long long sum = 0;
+  for (long long i = elements - 1; i >= 0; i--){
+    sum += values[i] * (i % 5);
+  }
+
+  /*
+   * Print the result.
+   */
+  printf("%lld %lld %lld\n", values[elements - 1], values[elements - 2], sum);
+
+  free(values);
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+long long histogram[16];
+long long maxima[4];
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto iterations = atoll(argv[1]) * 1000;
+
+  /*
+   * Allocate space.
+   */
+  auto values = (long long *)calloc(iterations, sizeof(long long));
+  if (values == NULL){
+    fprintf(stderr, "ERROR: %lld elements couldn't be allocated\n", iterations);
+    return 1;
+  }
+  for (auto i = 0; i < 3; i++){
+    values[i] = i + argc;
+  }
+
+  /*
+   * Hot code.
+   * The histogram is only updated by additions and the maxima only by max
+   * operations, while the array depends on the iteration 3 before the current
+   * one.
+   */
+  for (auto i = 3; i < iterations; i++){
+    values[i] = (values[i - 3] * 5 + i) % 1000003;
+    auto value = (i * 13) % 101;
+    histogram[value % 16] += value;
+    auto candidate = (i * 31) % 1009;
+    auto current = maxima[i % 4];
+    maxima[i % 4] = (candidate > current) ? candidate : current;
+  }
+
+  /*
+   * Print the result.
+   */
+  long long total = 0;
+  for (auto i = 0; i < iterations; i++){
+    total += values[i] * (i % 7);
+  }
+  printf("%lld\n", total);
+  for (auto i = 0; i < 16; i++){
+    printf("%lld\n", histogram[i]);
+  }
+  for (auto i = 0; i < 4; i++){
+    printf("%lld\n", maxima[i]);
+  }
+
+  free(values);
+  return 0;
+}
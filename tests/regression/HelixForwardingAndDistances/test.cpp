@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto iterations = atoll(argv[1]) * 1000;
+
+  /*
+   * Allocate space.
+   */
+  auto values = (long long *)calloc(iterations, sizeof(long long));
+  if (values == NULL){
+    fprintf(stderr, "ERROR: %lld elements couldn't be allocated\n", iterations);
+    return 1;
+  }
+  for (auto i = 0; i < 6; i++){
+    values[i] = i + 1;
+  }
+
+  /*
+   * Hot code.
+   * The scalar is forwarded from an iteration to the next one, while the
+   * array depends on the iterations 4 and 6 before the current one.
+   */
+  long long scalar = argc;
+  for (auto i = 6; i < iterations; i++){
+    scalar = (scalar * 3 + i) % 1000003;
+    values[i] = (values[i - 4] + values[i - 6] + scalar) % 1000003;
+  }
+
+  /*
+   * Print the result.
+   */
+  long long total = 0;
+  for (auto i = 0; i < iterations; i++){
+    total += values[i] * (i % 7);
+  }
+  printf("%lld %lld\n", scalar, total);
+
+  free(values);
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+void scatter (long long *values, int *indices, long long elements){
+  for (long long i = 0; i < elements; i++){
+    values[indices[i]] += i;
+  }
+
+  return ;
+}
+
+void scatterFromTheHeader (long long *values, int *indices, long long elements){
+  long long i = 0;
+  while (i < elements){
+    values[indices[i]] += i * 3;
+    i++;
+  }
+
+  return ;
+}
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto elements = atoll(argv[1]) * 1000 + 1;
+
+  /*
+   * Allocate space.
+   */
+  auto values = (long long *)calloc(elements, sizeof(long long));
+  auto indices = (int *)malloc(elements * sizeof(int));
+  if ((values == NULL) || (indices == NULL)){
+    fprintf(stderr, "ERROR: %lld elements couldn't be allocated\n", elements);
+    return 1;
+  }
+  for (auto i = 0; i < elements; i++){
+    indices[i] = (int)((i * 7LL) % elements);
+  }
+
+  /*
+   * Hot code.
+   * The indices are distinct the first time, and they include duplicates
+   * once one of them changes.
+   */
+  scatter(values, indices, elements);
+  scatter(values, indices, elements);
+  indices[elements - 1] = indices[0];
+  scatter(values, indices, elements);
+  scatterFromTheHeader(values, indices, elements - 1);
+
+  /*
+   * Print the result.
+   */
+  long long total = 0;
+  for (auto i = 0; i < elements; i++){
+    total += values[i] * (i % 11);
+  }
+  printf("%lld\n", total);
+
+  free(values);
+  free(indices);
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+void fill (long long *matrix, int firstRow, int lastRow, int columns){
+  for (int i = firstRow; i != lastRow; i++){
+    for (int j = 0; j < columns; j++){
+      matrix[(long long)(i - firstRow) * columns + j] = (long long)i * j + i;
+    }
+  }
+
+  return ;
+}
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 2){
+    fprintf(stderr, "USAGE: %s ROWS COLUMNS\n", argv[0]);
+    return 1;
+  }
+  auto rows = atoi(argv[1]) * 10;
+  auto columns = atoi(argv[2]) * 10;
+
+  /*
+   * Allocate space.
+   */
+  auto matrix = (long long *)calloc((long long)rows * columns, sizeof(long long));
+  if (matrix == NULL){
+    fprintf(stderr, "ERROR: %d x %d elements couldn't be allocated\n", rows, columns);
+    return 1;
+  }
+
+  /*
+   * Hot code.
+   * The outer loop starts from a negative row.
+   */
+  auto firstRow = -(rows / 2);
+  fill(matrix, firstRow, firstRow + rows, columns);
+
+  /*
+   * Print the result.
+   */
+  long long total = 0;
+  for (auto i = 0; i < rows * columns; i++){
+    total += matrix[i] * (i % 5);
+  }
+  printf("%lld\n", total);
+
+  free(matrix);
+  return 0;
+}
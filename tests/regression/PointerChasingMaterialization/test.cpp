@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct _N {
+  long long value;
+  long long result;
+  struct _N *next;
+} N;
+
+N *buildList (long long nodes, long long firstValue){
+  N *head = NULL;
+  for (auto i = 0; i < nodes; i++){
+    auto node = (N *)malloc(sizeof(N));
+    node->value = firstValue + nodes - i;
+    node->result = 0;
+    node->next = head;
+    head = node;
+  }
+
+  return head;
+}
+
+void freeList (N *head){
+  while (head != NULL){
+    auto next = head->next;
+    free(head);
+    head = next;
+  }
+
+  return ;
+}
+
+void compute (N *head){
+  for (auto node = head; node != NULL; node = node->next){
+    node->result = node->value * node->value + 3;
+  }
+
+  return ;
+}
+
+void computeUntil (N *head, long long lastValue){
+  for (auto node = head; node != NULL; node = node->next){
+    if (node->value == lastValue){
+      break;
+    }
+    node->result += node->value;
+  }
+
+  return ;
+}
+
+long long sum (N *head){
+  long long total = 0;
+  for (auto node = head; node != NULL; node = node->next){
+    total += node->result;
+  }
+
+  return total;
+}
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s NODES\n", argv[0]);
+    return 1;
+  }
+  auto nodes = atoll(argv[1]) * 1000;
+
+  /*
+   * Hot code.
+   * The same list is traversed twice, then its nodes are freed and a new list
+   * is built, which might start from the same address.
+   */
+  auto list = buildList(nodes, 0);
+  compute(list);
+  compute(list);
+  computeUntil(list, nodes / 2);
+  auto firstTotal = sum(list);
+  freeList(list);
+
+  list = buildList(nodes / 3, 7);
+  compute(list);
+  auto secondTotal = sum(list);
+  freeList(list);
+
+  /*
+   * Print the result.
+   */
+  printf("%lld %lld\n", firstTotal, secondTotal);
+
+  return 0;
+}
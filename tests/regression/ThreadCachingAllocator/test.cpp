@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+int main (int argc, char *argv[]){
+
+  /*
+   * Fetch the inputs.
+   */
+  if (argc <= 1){
+    fprintf(stderr, "USAGE: %s ITERATIONS\n", argv[0]);
+    return 1;
+  }
+  auto iterations = atoll(argv[1]) * 1000;
+
+  /*
+   * Allocate space.
+   */
+  auto sums = (long long *)calloc(iterations, sizeof(long long));
+  auto kept = (int **)calloc(iterations, sizeof(int *));
+  if ((sums == NULL) || (kept == NULL)){
+    fprintf(stderr, "ERROR: %lld elements couldn't be allocated\n", iterations);
+    return 1;
+  }
+
+  /*
+   * Hot code.
+   * The temporary buffer lives within an iteration, while the kept one
+   * escapes the loop and it is freed after it.
+   */
+  for (auto i = 0; i < iterations; i++){
+    auto tmp = (int *)malloc(16 * sizeof(int));
+    for (auto j = 0; j < 16; j++){
+      tmp[j] = i + j;
+    }
+    tmp = (int *)realloc(tmp, 32 * sizeof(int));
+    for (auto j = 16; j < 32; j++){
+      tmp[j] = tmp[j - 16] * 2;
+    }
+    long long s = 0;
+    for (auto j = 0; j < 32; j++){
+      s += tmp[j];
+    }
+    free(tmp);
+    sums[i] = s;
+
+    kept[i] = (int *)malloc(sizeof(int));
+    *kept[i] = i % 13;
+  }
+
+  /*
+   * Print the result.
+   */
+  long long total = 0;
+  for (auto i = 0; i < iterations; i++){
+    total += sums[i] + *kept[i];
+    free(kept[i]);
+  }
+  printf("%lld\n", total);
+
+  free(sums);
+  free(kept);
+  return 0;
+}
@@ -100,6 +100,28 @@ runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-dis
 runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-disable-dswp ;
 runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-disable-dswp -dswp-no-scc-merge ;
 
+# Test extensions of DOALL
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-parallelizer-doall-processes ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-parallelizer-thread-caching-allocator ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-parallelizer-doall-two-level-chunks ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-parallelizer-doall-early-exits ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-parallelizer-doall-deterministic-reductions ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-parallelizer-doall-atomic-updates ;
+
+# Test extensions of HELIX
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-disable-dswp -noelle-parallelizer-helix-value-forwarding ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-disable-dswp -noelle-parallelizer-helix-atomic-segments ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-disable-dswp -noelle-parallelizer-helix-dependence-distances ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-disable-dswp -noelle-parallelizer-helix-iteration-batch=4 ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-disable-dswp -noelle-parallelizer-helix-helper-threads ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-doall -noelle-disable-dswp -noelle-parallelizer-helix-skip-synchronization ;
+
+# Test enablers that unblock DOALL
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-enablers-loop-collapsing ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-enablers-alias-versioning ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-enablers-inspector-executor ;
+runningTestsWrapper -noelle-parallelizer-force -noelle-disable-helix -noelle-disable-dswp -noelle-enablers-pointer-chasing ;
+
 cd ../ ;
 
 exit 0;